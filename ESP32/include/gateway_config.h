@@ -0,0 +1,45 @@
+#pragma once
+
+// ---------- Ingest source ----------
+// UART receives the Teensy's telemetry link (telemetry_link.h). TWAI
+// listens on the CAN bus itself and decodes the BAMOCAR frames here, so the
+// gateway works without the Teensy (no boot step or pedal state then).
+#define GW_SOURCE_UART 0
+#define GW_SOURCE_TWAI 1
+#define GW_SOURCE      GW_SOURCE_UART
+
+// UART link, must match TELEMETRY_BAUD in TEENSY_COMMAND_MOTOR/include/config.h.
+#define GW_LINK_BAUD      460800
+#define GW_LINK_RX_PIN    16
+#define GW_LINK_TX_PIN    17
+#define GW_LINK_RX_BUFFER 2048
+
+// TWAI (needs a 3.3 V transceiver such as the SN65HVD230), listen-only.
+#define GW_CAN_TX_PIN       5
+#define GW_CAN_RX_PIN       4
+#define GW_CAN_RX_QUEUE     64
+#define GW_STATUS_PERIOD_MS 50      // TlStatus built from the decoded frames
+#define GW_ONLINE_MS        500     // BAMOCAR counts as online this long after a frame
+#define GW_RPM_MAX          6000    // RPM_MAX in the car firmware
+#define GW_TORQUE_MAX       32767   // TORQUE_MAX in the car firmware
+#define GW_BAMOCAR_RX_ID    0x201   // Teensy -> BAMOCAR
+#define GW_BAMOCAR_TX_ID    0x181   // BAMOCAR -> Teensy
+
+// ---------- Cores ----------
+// The Wi-Fi stack runs on core 0, so the web side shares it and ingest gets
+// core 1 to itself. Records cross between them through one SPSC queue.
+#define GW_INGEST_CORE 1
+#define GW_SERVE_CORE  0
+#define GW_QUEUE_LEN   1024   // power of two
+
+// ---------- History ----------
+// Rolling record history the page scrubs back through. Lives in PSRAM when
+// the module has it (WROVER), otherwise a small internal-RAM ring.
+#define GW_HISTORY_BYTES          (2u * 1024 * 1024)
+#define GW_HISTORY_FALLBACK_BYTES (48u * 1024)
+#define GW_HISTORY_MAX_READ       256     // records per /history request
+
+// ---------- Dashboard ----------
+#define GW_UI_TICK_MS    50    // one WebSocket message per tick, 20 Hz
+#define GW_UI_MAX_FRAMES 16
+#define GW_UDP_STREAM    1     // multicast snapshot every tick (TlUdpHeader), 0 = off
@@ -0,0 +1,16 @@
+#pragma once
+#include <stddef.h>
+#include "ingest.h"
+
+// Rolling history of every record the gateway received, oldest overwritten.
+// Written and read only by the serving task, so no locking.
+// Records are in arrival order; ms is close to monotonic (frames carry the
+// car's receive time, which can trail the status queued just before them).
+
+size_t   historyBegin();            // allocates; returns capacity in records
+void     historyAppend(const GwRecord &r);
+uint32_t historyCount();            // records currently held
+uint32_t historyOldestMs();
+uint32_t historyNewestMs();
+// Copies up to max records starting with the first one newer than fromMs.
+size_t   historyRead(uint32_t fromMs, GwRecord *out, size_t max);
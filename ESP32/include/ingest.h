@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include "telemetry_link.h"
+#include "spsc_queue.h"
+#include "gateway_config.h"
+
+// One status snapshot or CAN frame, as it travels from the ingest core to
+// the serving core and as the history stores it.
+struct __attribute__((packed)) GwRecord {
+  uint8_t type;  // TL_STATUS or TL_CAN
+  uint8_t len;   // payload bytes
+  union {
+    TlStatus   status;
+    TlCanFrame frame;
+  };
+
+  uint32_t ms() const { return type == TL_STATUS ? status.ms : frame.ms; }
+};
+static_assert(sizeof(GwRecord) == 24, "the page reads /history records by offset");
+
+// Ingest core -> serving core. Only ingest pushes, only the serving task pops.
+extern SpscQueue<GwRecord, GW_QUEUE_LEN> ingestQueue;
+
+struct GwIngestStats {
+  uint32_t records;    // pushed to ingestQueue
+  uint32_t dropped;    // ingestQueue full
+  uint32_t linkLost;   // UART: TlDecoder seq gaps; TWAI: RX queue misses
+  uint32_t linkCrc;    // UART: bad frames; TWAI: bus errors
+};
+
+void ingestBegin();                 // starts the ingest task on GW_INGEST_CORE
+GwIngestStats ingestStats();        // safe from the other core
@@ -0,0 +1,54 @@
+#include <Arduino.h>
+#include "history.h"
+
+static GwRecord *_ring = nullptr;
+static uint32_t  _cap = 0;
+static uint32_t  _written = 0;  // records ever appended; index = n % _cap
+
+size_t historyBegin() {
+  size_t bytes = GW_HISTORY_BYTES;
+  if (psramFound()) {
+    _ring = (GwRecord *)ps_malloc(bytes);
+  }
+  if (!_ring) {
+    bytes = GW_HISTORY_FALLBACK_BYTES;
+    _ring = (GwRecord *)malloc(bytes);
+  }
+  _cap = _ring ? bytes / sizeof(GwRecord) : 0;
+  return _cap;
+}
+
+void historyAppend(const GwRecord &r) {
+  if (_cap == 0) return;
+  _ring[_written % _cap] = r;
+  _written++;
+}
+
+static uint32_t first() {
+  return _written > _cap ? _written - _cap : 0;
+}
+
+uint32_t historyCount() {
+  return _written - first();
+}
+
+uint32_t historyOldestMs() {
+  return historyCount() ? _ring[first() % _cap].ms() : 0;
+}
+
+uint32_t historyNewestMs() {
+  return historyCount() ? _ring[(_written - 1) % _cap].ms() : 0;
+}
+
+size_t historyRead(uint32_t fromMs, GwRecord *out, size_t max) {
+  // Lower bound on ms > fromMs over [first, _written).
+  uint32_t lo = first(), hi = _written;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (_ring[mid % _cap].ms() <= fromMs) lo = mid + 1;
+    else hi = mid;
+  }
+  size_t n = 0;
+  for (uint32_t i = lo; i < _written && n < max; i++) out[n++] = _ring[i % _cap];
+  return n;
+}
@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include <atomic>
+#include "ingest.h"
+#if GW_SOURCE == GW_SOURCE_TWAI
+#include <driver/twai.h>
+#include "bamocar_decoder.h"
+#endif
+
+SpscQueue<GwRecord, GW_QUEUE_LEN> ingestQueue;
+
+static std::atomic<uint32_t> _records{0}, _dropped{0}, _linkLost{0}, _linkCrc{0};
+
+static void push(uint8_t type, const void *payload, uint8_t len) {
+  GwRecord r;
+  r.type = type;
+  r.len = len;
+  memcpy(&r.status, payload, len);
+  if (ingestQueue.push(r)) _records.fetch_add(1, std::memory_order_relaxed);
+  else _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+GwIngestStats ingestStats() {
+  return { _records.load(), _dropped.load(), _linkLost.load(), _linkCrc.load() };
+}
+
+#if GW_SOURCE == GW_SOURCE_UART
+// ---------- UART link from the Teensy ----------
+// Records arrive ready-made; they are forwarded as decoded.
+static void ingestTask(void *) {
+  static TlDecoder link;
+  for (;;) {
+    int n = Serial2.available();
+    if (n == 0) {
+      vTaskDelay(1);
+      continue;
+    }
+    while (n-- > 0) {
+      if (!link.push((uint8_t)Serial2.read())) continue;
+      if (link.type() == TL_STATUS && link.length() == sizeof(TlStatus)) push(TL_STATUS, link.payload(), link.length());
+      else if (link.type() == TL_CAN && link.length() == sizeof(TlCanFrame)) push(TL_CAN, link.payload(), link.length());
+    }
+    _linkLost.store(link.lost(), std::memory_order_relaxed);
+    _linkCrc.store(link.crcErrors(), std::memory_order_relaxed);
+  }
+}
+
+static void sourceBegin() {
+  Serial2.setRxBufferSize(GW_LINK_RX_BUFFER);
+  Serial2.begin(GW_LINK_BAUD, SERIAL_8N1, GW_LINK_RX_PIN, GW_LINK_TX_PIN);
+}
+#else
+// ---------- TWAI, listen-only on the car bus ----------
+// Every frame is forwarded; BAMOCAR responses and the Teensy's torque
+// commands are decoded into a TlStatus every GW_STATUS_PERIOD_MS.
+static BamocarState _bamocar = {};
+static int16_t  _torque = 0;
+static uint32_t _lastBamocarMs = 0;
+static bool     _seenStatus = false;
+
+static void handleFrame(const twai_message_t &m, uint32_t now) {
+  TlCanFrame f;
+  f.ms = now;
+  f.id = (uint16_t)m.identifier;
+  f.len = m.data_length_code > 8 ? 8 : m.data_length_code;
+  memset(f.data, 0, sizeof(f.data));
+  memcpy(f.data, m.data, f.len);
+  push(TL_CAN, &f, sizeof(f));
+
+  if (m.identifier == GW_BAMOCAR_TX_ID) {
+    const BamocarRegister *r = bamocarDecode(m.data, f.len, _bamocar);
+    if (r) _lastBamocarMs = now;
+    if (r && r->reg == REG_STATUS) _seenStatus = true;
+  } else if (m.identifier == GW_BAMOCAR_RX_ID && f.len >= 3 && m.data[0] == REG_TORQUE_COMMAND) {
+    _torque = (int16_t)(m.data[1] | (m.data[2] << 8));
+  }
+}
+
+static void pushStatus(uint32_t now) {
+  bool online = _seenStatus && now - _lastBamocarMs < GW_ONLINE_MS;
+  TlStatus s = {};
+  s.ms             = now;
+  s.rpm            = (int16_t)((float)_bamocar.rpmFeedback / 32767.0f * GW_RPM_MAX);
+  s.torquePermille = (int16_t)((int32_t)_torque * 1000 / GW_TORQUE_MAX);
+  s.dcBusDeciVolts = (uint16_t)(_bamocar.dcBusVoltage * 10.0f);
+  s.motorTempDeci  = (int16_t)(_bamocar.motorTemp * 10.0f);
+  s.igbtTempDeci   = (int16_t)(_bamocar.inverterTemp * 10.0f);
+  s.errorWord      = (uint16_t)_bamocar.errorWord;
+  s.step           = _seenStatus ? 7 : 0;
+  s.flags          = (online ? TL_FLAG_ONLINE : 0) | ((_bamocar.statusWord & 0x0001) ? TL_FLAG_DRIVE : 0);
+  push(TL_STATUS, &s, sizeof(s));
+}
+
+static void ingestTask(void *) {
+  uint32_t lastStatus = 0;
+  for (;;) {
+    twai_message_t m;
+    if (twai_receive(&m, pdMS_TO_TICKS(GW_STATUS_PERIOD_MS)) == ESP_OK && !m.rtr) handleFrame(m, millis());
+    uint32_t now = millis();
+    if (now - lastStatus >= GW_STATUS_PERIOD_MS) {
+      lastStatus = now;
+      pushStatus(now);
+      twai_status_info_t info;
+      if (twai_get_status_info(&info) == ESP_OK) {
+        _linkLost.store(info.rx_missed_count, std::memory_order_relaxed);
+        _linkCrc.store(info.bus_error_count, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+static void sourceBegin() {
+  twai_general_config_t g = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)GW_CAN_TX_PIN, (gpio_num_t)GW_CAN_RX_PIN,
+                                                        TWAI_MODE_LISTEN_ONLY);
+  g.rx_queue_len = GW_CAN_RX_QUEUE;
+  twai_timing_config_t t = TWAI_TIMING_CONFIG_500KBITS();
+  twai_filter_config_t f = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+  if (twai_driver_install(&g, &t, &f) != ESP_OK || twai_start() != ESP_OK) {
+    Serial.println("TWAI start failed");
+  }
+}
+#endif
+
+void ingestBegin() {
+  sourceBegin();
+  xTaskCreatePinnedToCore(ingestTask, "ingest", 4096, nullptr, configMAX_PRIORITIES - 2, nullptr, GW_INGEST_CORE);
+}
@@ -1,34 +1,271 @@
+// Telemetry gateway: car telemetry in on one core, dashboard out on the other.
+//
+//   ingest core  UART link from the Teensy or TWAI on the bus (ingest.cpp)
+//                -> ingestQueue (lock-free SPSC)
+//   serve core   ingestQueue -> history (PSRAM) + coalesced tick
+//                -> one binary WebSocket message per GW_UI_TICK_MS
+//                -> one multicast UDP snapshot per GW_UI_TICK_MS
+//                HTTP: /          dashboard page
+//                      /history   ?from=<ms>&max=<n>, binary records
+//
+// The page backfills from /history after every (re)connect and can scrub
+// back through it, so a browser that drops off loses nothing still held.
+#include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
+#include <WebSocketsServer.h>
+#include <WiFiUdp.h>
+#include "gateway_config.h"
+#include "ingest.h"
+#include "history.h"
+#include "telemetry_page.h"
 
 const char* ssid = "ESP32_Hotspot";
 const char* password = "12345678"; // must be at least 8 chars
 
 // Create a web server on port 80
 WebServer server(80);
+WebSocketsServer webSocket(81);
+WiFiUDP udp;
+
+// ---------- Dashboard page ----------
+const char webpage[] PROGMEM = R"rawliteral(
+<!DOCTYPE html>
+<html>
+<head>
+  <meta charset="utf-8">
+  <title>FS Telemetry Gateway</title>
+  <style>
+    body { font-family: Arial; background:#0e1111; color:white; margin:0; padding:20px; }
+    h1 { color:#2e5786; text-align:center; }
+    .flex { display:flex; justify-content:center; gap:20px; margin-bottom:20px; }
+    .box { border:1px solid #2e5786; border-radius:8px; padding:15px; width:150px; text-align:center; }
+    #log { background:#111; color:#ccc; border:1px solid #333; padding:10px; height:300px; overflow:hidden; font-family:monospace; font-size:13px; margin:0; }
+    #info { color:#888; font-size:12px; }
+    #scrub { width:100%; }
+  </style>
+</head>
+<body>
+  <h1>Formula Student Telemetry Gateway</h1>
+  <div class="flex">
+    <div class="box"><b>Status:</b><br><span id="status">Unknown</span></div>
+    <div class="box"><b>RPM:</b><br><span id="rpm">0</span></div>
+    <div class="box"><b>Torque:</b><br><span id="torque">0</span></div>
+    <div class="box"><b>DC bus:</b><br><span id="dcbus">0</span></div>
+  </div>
+
+  <div><b>CAN Frames:</b> <span id="info"></span> <button id="live">Live</button></div>
+  <pre id="log"></pre>
+  <input type="range" id="scrub" min="0" max="0" value="0">
+
+<script src="/telemetry.js"></script>
+<script>
+  const $ = id => document.getElementById(id);
+
+  // GwRecord sizes, see ingest.h.
+  const RECORD_SIZE = 24, HISTORY_HEADER = 12;
+  const TYPE_STATUS = 0x53, TYPE_CAN = 0x43, HISTORY_MAX = 256;
+
+  function applyStatus(v, off) {
+    $('status').textContent = statusText(v.getUint16(off + 14, true), v.getInt8(off + 20), v.getUint8(off + 21));
+    $('rpm').textContent = v.getInt16(off + 4, true);
+    $('torque').textContent = (v.getInt16(off + 6, true) / 10).toFixed(1) + " %";
+    $('dcbus').textContent = (v.getUint16(off + 8, true) / 10).toFixed(1) + " V";
+  }
+
+  // logNewestMs also follows status records: it is where a backfill resumes.
+  function seenStatus(v, off) {
+    logNewestMs = Math.max(logNewestMs, v.getUint32(off, true));
+  }
+
+  let live = true, scrubRows = [], counters = "";
+
+  function render() {
+    $('log').textContent = (live ? logRows(0) : scrubRows).join("\n");
+    $('info').textContent = (live ? "live" : "history at " + $('scrub').value + " ms") + " | " + counters;
+    if (live) $('scrub').value = $('scrub').max;
+  }
+
+  // ---- History ----
+  async function fetchHistory(from, max) {
+    const r = await fetch('/history?from=' + from + '&max=' + max);
+    const v = new DataView(await r.arrayBuffer());
+    $('scrub').min = v.getUint32(0, true);
+    $('scrub').max = v.getUint32(4, true);
+    return { v: v, count: v.getUint32(8, true) };
+  }
+
+  // After a (re)connect: everything newer than what the page already has.
+  async function backfill() {
+    for (;;) {
+      const h = await fetchHistory(logNewestMs, HISTORY_MAX);
+      let status = -1;
+      for (let n = 0, off = HISTORY_HEADER; n < h.count; n++, off += RECORD_SIZE) {
+        if (h.v.getUint8(off) === TYPE_CAN) logPush(h.v, off + 2);
+        else if (h.v.getUint8(off) === TYPE_STATUS) { status = off + 2; seenStatus(h.v, status); }
+      }
+      if (status >= 0) applyStatus(h.v, status);
+      scheduleRender();
+      if (h.count < HISTORY_MAX) return;
+    }
+  }
+
+  async function scrubTo(ms) {
+    live = false;
+    const h = await fetchHistory(ms - 1, HISTORY_MAX);
+    scrubRows = [];
+    let statusDone = false;
+    for (let n = 0, off = HISTORY_HEADER; n < h.count; n++, off += RECORD_SIZE) {
+      const type = h.v.getUint8(off);
+      if (type === TYPE_CAN && scrubRows.length < LOG_ROWS) scrubRows.push(frameText(h.v, off + 2));
+      else if (type === TYPE_STATUS && !statusDone) { applyStatus(h.v, off + 2); statusDone = true; }
+    }
+    scheduleRender();
+  }
+
+  $('scrub').addEventListener('change', e => scrubTo(+e.target.value));
+  $('live').addEventListener('click', () => { live = true; scheduleRender(); });
+
+  // ---- Binary tick, see TlTickHeader in telemetry_link.h ----
+  function connect() {
+    const ws = new WebSocket('ws://' + location.hostname + ':81/');
+    ws.binaryType = 'arraybuffer';
+    ws.onopen = backfill;
+    ws.onclose = () => setTimeout(connect, 1000);
+    ws.onmessage = function(event) {
+      if (!(event.data instanceof ArrayBuffer)) return;
+      const v = new DataView(event.data);
+      const t = readTick(v, (s, off) => { if (live) applyStatus(s, off); seenStatus(s, off); });
+      if (!t) return;
+      counters = "link " + t.link[0] + " records, " + t.link[1] + " lost, " + t.link[2] + " bad";
+      $('scrub').max = logNewestMs;
+      scheduleRender();
+    };
+  }
+  connect();
+</script>
+</body>
+</html>
+)rawliteral";
 
 // Define what happens when someone visits the root page
 void handleRoot() {
-  server.send(200, "text/html", "<h1>Hello from ESP32!</h1><p>You’re connected to my Wi-Fi network.</p>");
+  server.send_P(200, "text/html", webpage);
+}
+
+void handleScript() {
+  server.send_P(200, "application/javascript", TL_PAGE_SCRIPT);
+}
+
+// Response: u32 oldest ms, u32 newest ms, u32 count, then count GwRecords.
+void handleHistory() {
+  static uint8_t buf[12 + GW_HISTORY_MAX_READ * sizeof(GwRecord)];
+  uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), nullptr, 10) : 0;
+  uint32_t max = server.hasArg("max") ? strtoul(server.arg("max").c_str(), nullptr, 10) : GW_HISTORY_MAX_READ;
+  if (max > GW_HISTORY_MAX_READ) max = GW_HISTORY_MAX_READ;
+
+  uint32_t head[3] = { historyOldestMs(), historyNewestMs(), 0 };
+  head[2] = historyRead(from, (GwRecord *)(buf + sizeof(head)), max);
+  memcpy(buf, head, sizeof(head));
+  server.send_P(200, "application/octet-stream", (const char *)buf, sizeof(head) + head[2] * sizeof(GwRecord));
+}
+
+// ---------- Tick ----------
+// Newest status plus the frames since the last tick (see TlTick), out as
+// one WebSocket message and one multicast UDP snapshot.
+static TlTick<GW_UI_MAX_FRAMES> _tick;
+
+static TlLinkCounts linkCounts() {
+  GwIngestStats in = ingestStats();
+  return { in.records, in.linkLost + in.dropped, in.linkCrc };
+}
+
+static void tickAdd(const GwRecord &r) {
+  if (r.type == TL_STATUS) _tick.status(r.status);
+  else _tick.frame(r.frame);
+}
+
+static void tickSend() {
+  static uint8_t msg[TlTick<GW_UI_MAX_FRAMES>::TICK_BYTES];
+  webSocket.broadcastBIN(msg, _tick.pack(msg, linkCounts()));
+}
+
+static void udpSend(uint32_t now) {
+  static uint8_t msg[TlTick<GW_UI_MAX_FRAMES>::UDP_BYTES];
+  size_t n = _tick.packUdp(msg, linkCounts(), now);
+  udp.beginMulticastPacket();
+  udp.write(msg, n);
+  udp.endPacket();
+}
+
+// Resync requests from receivers that saw a gap.
+static void udpPoll() {
+  while (udp.parsePacket() > 0) {
+    uint8_t req[2];
+    int n = udp.read(req, sizeof(req));
+    if (n > 0) _tick.request(req, n);
+    udp.flush();
+  }
+}
+
+// ---------- Serving task ----------
+static void serveTask(void *) {
+  uint32_t lastTickMs = 0;
+  for (;;) {
+    server.handleClient();
+    webSocket.loop();
+
+    GwRecord r;
+    while (ingestQueue.pop(r)) {
+      historyAppend(r);
+      tickAdd(r);
+    }
+#if GW_UDP_STREAM
+    udpPoll();
+#endif
+
+    uint32_t now = millis();
+    if (now - lastTickMs >= GW_UI_TICK_MS) {
+      lastTickMs = now;
+      if (_tick.pending() && webSocket.connectedClients() > 0) tickSend();
+#if GW_UDP_STREAM
+      udpSend(now);
+#endif
+      _tick.reset();
+    }
+    vTaskDelay(1);
+  }
 }
 
 void setup() {
   Serial.begin(115200);
   delay(1000);
 
+  size_t records = historyBegin();
+  Serial.printf("History: %u records (%s)\n", (unsigned)records, psramFound() ? "PSRAM" : "internal RAM");
+
   Serial.println("Starting Access Point...");
   WiFi.softAP(ssid, password);
   IPAddress IP = WiFi.softAPIP();
   Serial.print("AP IP address: ");
   Serial.println(IP);
 
-  // Define route and start server
+  // Define routes and start servers
   server.on("/", handleRoot);
+  server.on(TL_PAGE_SCRIPT_PATH, handleScript);
+  server.on("/history", handleHistory);
   server.begin();
+  webSocket.begin();
   Serial.println("HTTP server started");
+#if GW_UDP_STREAM
+  udp.beginMulticast(IPAddress(TL_UDP_GROUP), TL_UDP_PORT);
+#endif
+
+  ingestBegin();
+  xTaskCreatePinnedToCore(serveTask, "serve", 8192, nullptr, 1, nullptr, GW_SERVE_CORE);
 }
 
+// Everything runs in the two pinned tasks.
 void loop() {
-  // Listen for client requests
-  server.handleClient();
+  vTaskDelete(nullptr);
 }
@@ -1,21 +1,35 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <mcp_can.h>
+#include "can_capture.h"
 
 // Pin definitions for SparkFun Pro Micro
 #define CAN_CS_PIN    10    // Chip Select pin
-#define CAN_INT_PIN   2     // Interrupt pin (optional)
+#define CAN_INT_PIN   2     // Interrupt pin (INT1), required for capture
+
+// Capture: the MCP2515 interrupt drains both RX buffers into a ring; loop()
+// empties the ring to USB. Binary streams SLIP-framed CapFrame/CapStats
+// records (include/can_capture.h); text is the human-readable table, which
+// is much slower and overflows the ring long before 500 kbps bus load.
+#define CAPTURE_BINARY    0
+#define CAPTURE_TEXT      1
+#define CAPTURE_MODE      CAPTURE_BINARY
+#define CAPTURE_RING      32      // power of two, 17 bytes each
+#define CAPTURE_STATS_MS  1000
 
 // Create MCP_CAN object
 MCP_CAN CAN(CAN_CS_PIN);
 
-// Variables for CAN message handling
-unsigned long rxId;
-unsigned char len = 0;
-unsigned char rxBuf[8];
+// Ring between the interrupt (producer) and loop() (consumer). Indices
+// are single bytes, so reads and writes of them are atomic on AVR.
+CapFrame captureRing[CAPTURE_RING];
+volatile uint8_t ringHead = 0;
+volatile uint8_t ringTail = 0;
+volatile unsigned long overflowCount = 0;
+unsigned long reportedOverflows = 0;
 
 // Statistics and configuration
-unsigned long messageCount = 0;
+volatile unsigned long messageCount = 0;  // written by canInterrupt()
 unsigned long lastStatsTime = 0;
 unsigned long lastHeartbeat = 0;
 const unsigned long STATS_INTERVAL = 10000;    // Print stats every 10 seconds
@@ -26,7 +40,11 @@ const bool SEND_HEARTBEAT = false;
 const unsigned long HEARTBEAT_ID = 0x7DF;  // OBD2 functional addressing
 
 // Function prototypes
-void printCANMessage(unsigned long id, unsigned char dlc, unsigned char *data);
+void canInterrupt();
+bool popFrame(CapFrame &f);
+void sendRecord(uint8_t type, const void *payload, size_t len);
+void sendStats();
+void printCANMessage(unsigned long timestampMs, unsigned long id, unsigned char dlc, unsigned char *data);
 void setupCANFilters();
 void sendHeartbeat();
 void printCANStatistics();
@@ -39,6 +57,7 @@ void setup() {
     delay(10);
   }
   
+#if CAPTURE_MODE == CAPTURE_TEXT
   Serial.println(F("========================================="));
   Serial.println(F("  Advanced CAN Bus Listener"));
   Serial.println(F("  SparkFun Pro Micro + HW-184 MCP2515"));
@@ -46,9 +65,12 @@ void setup() {
   
   // Initialize MCP2515
   Serial.print(F("Initializing MCP2515..."));
+#endif
   
   if(CAN.begin(MCP_ANY, CAN_500KBPS, MCP_8MHZ) == CAN_OK) {
+#if CAPTURE_MODE == CAPTURE_TEXT
     Serial.println(F(" SUCCESS!"));
+#endif
   } else {
     Serial.println(F(" FAILED!"));
     Serial.println(F("Check your wiring and settings."));
@@ -65,6 +87,14 @@ void setup() {
   // Optional: Setup message filters (uncomment to enable)
   // setupCANFilters();
   
+  // INT stays low while either RX buffer is full, so a LOW-level interrupt
+  // cannot miss a frame that lands while the handler is still reading.
+  // Heartbeat SPI traffic from loop() masks it for the transaction.
+  pinMode(CAN_INT_PIN, INPUT_PULLUP);
+  SPI.usingInterrupt(digitalPinToInterrupt(CAN_INT_PIN));
+  attachInterrupt(digitalPinToInterrupt(CAN_INT_PIN), canInterrupt, LOW);
+  
+#if CAPTURE_MODE == CAPTURE_TEXT
   Serial.println(F("\nConfiguration:"));
   Serial.println(F("- Bitrate: 500 kbps"));
   Serial.println(F("- Crystal: 8 MHz"));
@@ -75,17 +105,21 @@ void setup() {
   Serial.println(F("\nListening for CAN messages..."));
   Serial.println(F("Time(ms)   | ID      | DLC | Data                | ASCII    | Info"));
   Serial.println(F("-----------|---------|-----|---------------------|----------|--------"));
+#endif
   
   lastStatsTime = millis();
   lastHeartbeat = millis();
 }
 
 void loop() {
-  // Check for received messages
-  if(CAN_MSGAVAIL == CAN.checkReceive()) {
-    CAN.readMsgBuf(&rxId, &len, rxBuf);
-    messageCount++;
-    printCANMessage(rxId, len, rxBuf);
+  // Empty the ring; the interrupt keeps capturing while USB blocks.
+  CapFrame f;
+  while (popFrame(f)) {
+#if CAPTURE_MODE == CAPTURE_BINARY
+    sendRecord(CAP_FRAME, &f, sizeof(f));
+#else
+    printCANMessage(f.us / 1000, f.id, f.len, f.data);
+#endif
   }
   
   // Send heartbeat if enabled
@@ -94,18 +128,78 @@ void loop() {
     lastHeartbeat = millis();
   }
   
+#if CAPTURE_MODE == CAPTURE_BINARY
+  // Periodic statistics, and straight away when frames were dropped
+  noInterrupts();
+  unsigned long overflows = overflowCount;
+  interrupts();
+  if (overflows != reportedOverflows || millis() - lastStatsTime >= CAPTURE_STATS_MS) {
+    sendStats();
+    reportedOverflows = overflows;
+    lastStatsTime = millis();
+  }
+#else
   // Print periodic statistics
   if (millis() - lastStatsTime >= STATS_INTERVAL) {
     printCANStatistics();
     lastStatsTime = millis();
   }
+#endif
+}
+
+// Reads both RX buffers until the MCP2515 releases INT. A full ring still
+// has to read the frame out to clear the buffer; it is counted and dropped.
+void canInterrupt() {
+  while (CAN.checkReceive() == CAN_MSGAVAIL) {
+    CapFrame f;
+    unsigned long id;
+    unsigned char len;
+    f.us = micros();
+    CAN.readMsgBuf(&id, &len, f.data);
+    f.id = id;
+    f.len = len;
   
-  delay(1);
+    uint8_t next = (ringHead + 1) & (CAPTURE_RING - 1);
+    if (next == ringTail) {
+      overflowCount++;
+      continue;
+    }
+    captureRing[ringHead] = f;
+    ringHead = next;
+    messageCount++;
+  }
+}
+
+bool popFrame(CapFrame &f) {
+  uint8_t tail = ringTail;
+  if (tail == ringHead) return false;
+  f = captureRing[tail];
+  ringTail = (tail + 1) & (CAPTURE_RING - 1);
+  return true;
+}
+
+void sendRecord(uint8_t type, const void *payload, size_t len) {
+  uint8_t out[CAP_MAX_ENCODED];
+  size_t n = capEncode(type, payload, len, out);
+  Serial.write(out, n);
+}
+
+void sendStats() {
+  CapStats s;
+  noInterrupts();
+  s.frames = messageCount;
+  s.overflows = overflowCount;
+  interrupts();
+  s.us = micros();
+  s.rxErrors = CAN.errorCountRX();
+  s.txErrors = CAN.errorCountTX();
+  s.eflg = CAN.getError();
+  sendRecord(CAP_STATS, &s, sizeof(s));
 }
 
-void printCANMessage(unsigned long id, unsigned char dlc, unsigned char *data) {
-  // Print timestamp (truncated to fit)
-  unsigned long timestamp = millis();
+void printCANMessage(unsigned long timestampMs, unsigned long id, unsigned char dlc, unsigned char *data) {
+  // Print capture timestamp (truncated to fit)
+  unsigned long timestamp = timestampMs;
   Serial.print(timestamp);
   
   // Pad timestamp to 10 characters
@@ -200,16 +294,23 @@ void sendHeartbeat() {
 }
 
 void printCANStatistics() {
+  noInterrupts();
+  unsigned long received = messageCount;
+  unsigned long overflows = overflowCount;
+  interrupts();
+  
   Serial.println();
   Serial.println(F("=== STATISTICS ==="));
   Serial.print(F("Messages received: "));
-  Serial.println(messageCount);
+  Serial.println(received);
+  Serial.print(F("Ring overflows: "));
+  Serial.println(overflows);
   Serial.print(F("Uptime: "));
   Serial.print(millis() / 1000);
   Serial.println(F(" seconds"));
   Serial.print(F("Rate: "));
-  if (messageCount > 0 && millis() > 1000) {
-    float rate = (float)messageCount / (millis() / 1000.0);
+  if (received > 0 && millis() > 1000) {
+    float rate = (float)received / (millis() / 1000.0);
     Serial.print(rate, 2);
     Serial.println(F(" msg/sec"));
   } else {
@@ -0,0 +1,133 @@
+#ifndef CAN_CAPTURE_H
+#define CAN_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Binary capture stream from examples/advanced_can_listener.cpp to the host.
+// No Arduino dependencies so host tools can share it.
+//
+// Each record is SLIP-framed (RFC 1055):
+//   END [type][payload ...] END        with END/ESC bytes escaped
+// A leading END flushes any line noise, so a host that opens the port
+// mid-stream just drops the first partial record. USB CDC already checks
+// every packet, so there is no CRC. Multi-byte fields are little-endian
+// (AVR and the hosts are).
+
+#define CAP_SLIP_END      0xC0
+#define CAP_SLIP_ESC      0xDB
+#define CAP_SLIP_ESC_END  0xDC
+#define CAP_SLIP_ESC_ESC  0xDD
+
+#define CAP_MAX_PAYLOAD   17
+#define CAP_MAX_ENCODED   (2 * (CAP_MAX_PAYLOAD + 1) + 2)
+
+// ---------- Record types ----------
+enum CapType : uint8_t {
+  CAP_FRAME = 'F',  // CapFrame, every frame the MCP2515 received
+  CAP_STATS = 'O',  // CapStats, once per CAPTURE_STATS_MS and after an overflow
+};
+
+// Same flag bits mcp_can's readMsgBuf() sets in the id.
+#define CAP_ID_EXT  0x80000000UL
+#define CAP_ID_RTR  0x40000000UL
+
+struct __attribute__((packed)) CapFrame {
+  uint32_t us;         // micros() when the interrupt fired
+  uint32_t id;         // 11 or 29 bits plus CAP_ID_* flags
+  uint8_t  len;
+  uint8_t  data[8];
+};
+
+struct __attribute__((packed)) CapStats {
+  uint32_t us;
+  uint32_t frames;     // captured into the ring since boot
+  uint32_t overflows;  // read from the MCP2515 but dropped, ring full
+  uint8_t  rxErrors;   // MCP2515 REC
+  uint8_t  txErrors;   // MCP2515 TEC
+  uint8_t  eflg;       // MCP2515 EFLG, RX0OVR/RX1OVR = frames the controller lost
+};
+
+static_assert(sizeof(CapFrame) <= CAP_MAX_PAYLOAD && sizeof(CapStats) <= CAP_MAX_PAYLOAD,
+              "CAP_MAX_PAYLOAD too small");
+
+// ---------- Encoder ----------
+// Writes the framed record to out (>= CAP_MAX_ENCODED bytes) and returns
+// its length, or 0 if the payload is too long.
+inline size_t capEncode(uint8_t type, const void *payload, size_t len, uint8_t *out) {
+  if (len > CAP_MAX_PAYLOAD) return 0;
+  size_t o = 0;
+  out[o++] = CAP_SLIP_END;
+  const uint8_t *p = (const uint8_t *)payload;
+  for (size_t i = 0; i <= len; i++) {
+    uint8_t b = i == 0 ? type : p[i - 1];
+    if (b == CAP_SLIP_END) {
+      out[o++] = CAP_SLIP_ESC;
+      out[o++] = CAP_SLIP_ESC_END;
+    } else if (b == CAP_SLIP_ESC) {
+      out[o++] = CAP_SLIP_ESC;
+      out[o++] = CAP_SLIP_ESC_ESC;
+    } else {
+      out[o++] = b;
+    }
+  }
+  out[o++] = CAP_SLIP_END;
+  return o;
+}
+
+// ---------- Decoder ----------
+// Byte-at-a-time, for host tools reading the serial port.
+class CapDecoder {
+public:
+  // Returns true when b completed a record; type() and payload() then
+  // describe it until the next call.
+  bool push(uint8_t b) {
+    if (b == CAP_SLIP_END) {
+      bool ok = !_bad && _len > 0 && _len <= sizeof(_buf);
+      if (_bad || _len > sizeof(_buf)) _errors++;
+      _recordLen = ok ? _len : 0;
+      if (ok) memcpy(_record, _buf, _len);
+      _len = 0;
+      _esc = _bad = false;
+      if (ok) _records++;
+      return ok;
+    }
+    if (_esc) {
+      _esc = false;
+      if (b == CAP_SLIP_ESC_END) b = CAP_SLIP_END;
+      else if (b == CAP_SLIP_ESC_ESC) b = CAP_SLIP_ESC;
+      else _bad = true;
+    } else if (b == CAP_SLIP_ESC) {
+      _esc = true;
+      return false;
+    }
+    if (_len < sizeof(_buf)) _buf[_len] = b;
+    _len++;
+    return false;
+  }
+
+  uint8_t        type() const    { return _record[0]; }
+  const uint8_t *payload() const { return _record + 1; }
+  size_t         length() const  { return _recordLen ? _recordLen - 1 : 0; }
+
+  // Copies the payload into a fixed-size record; false if the size differs.
+  template <typename T>
+  bool read(T &out) const {
+    if (length() != sizeof(T)) return false;
+    memcpy(&out, payload(), sizeof(T));
+    return true;
+  }
+
+  uint32_t records() const { return _records; }
+  uint32_t errors() const  { return _errors; }  // bad escapes, oversized records
+
+private:
+  uint8_t  _buf[CAP_MAX_PAYLOAD + 1];
+  uint8_t  _record[CAP_MAX_PAYLOAD + 1];
+  size_t   _len = 0, _recordLen = 0;
+  bool     _esc = false, _bad = false;
+  uint32_t _records = 0, _errors = 0;
+};
+
+#endif
@@ -9,24 +9,39 @@ Example:
 
 Each new CAN identifier gets its own row; subsequent updates refresh the
 existing row in-place so the table stays compact.
+
+With --udp it listens to the multicast snapshots the Wi-Fi bridges send
+instead (TlUdpHeader in TEENSY_COMMAND_MOTOR/include/telemetry_link.h):
+sequence gaps are counted and answered with a resync request, which makes
+the bridge send a keyframe holding the newest frame of every register.
+Any number of laptops can listen at once.
+
+Serial input is parsed by the native backend in can_ingest.cpp when
+libcan_ingest is built (see that file), which also reads the listener's
+binary SLIP capture stream (--binary). The table is redrawn at a fixed
+UI_HZ with only the rows that changed, so the window stays responsive at
+any frame rate; without the library the Python parser is used.
 """
 
 from __future__ import annotations
 
 import argparse
+import ctypes
 import csv
+import errno
+import os
 import queue
+import socket
+import struct
 import threading
 import time
 from dataclasses import dataclass
-from typing import Dict, List, Optional
+from typing import Callable, Dict, List, Optional, Tuple
 
 try:
     import serial  # type: ignore
-except ImportError as exc:  # pragma: no cover - handled at runtime
-    raise SystemExit(
-        "pyserial is required for this tool. Install it with 'pip install pyserial'."
-    ) from exc
+except ImportError:  # pragma: no cover - handled at runtime
+    serial = None  # only needed when the native backend cannot open the port
 
 import tkinter as tk
 from tkinter import ttk
@@ -41,6 +56,8 @@ class CANFrame:
     dlc: int
     data_bytes: List[str]
     interpretation: str
+    count: Optional[int] = None  # native backend only
+    rate_hz: Optional[float] = None
 
     @property
     def data_display(self) -> str:
@@ -51,6 +68,10 @@ class CANFrame:
     def elapsed_seconds(self) -> str:
         return f"{self.timestamp_ms / 1000.0:.3f}s"
 
+    @property
+    def rate_display(self) -> str:
+        return "" if self.rate_hz is None else f"{self.rate_hz:.1f} Hz"
+
 
 def parse_csv_line(line: str) -> Optional[CANFrame]:
     """Parse a CSV line into a CANFrame, returning None when the format does not match."""
@@ -86,6 +107,293 @@ def parse_csv_line(line: str) -> Optional[CANFrame]:
     )
 
 
+# ---------- UDP snapshots (telemetry_link.h) ----------
+UDP_GROUP = "239.255.70.83"
+UDP_PORT = 5005
+UDP_HEADER = struct.Struct("<BBBBI")         # TlUdpHeader
+TICK_HEADER = struct.Struct("<BBBBHHIII")    # TlTickHeader
+STATUS = struct.Struct("<IhhHhhHHHbB")       # TlStatus
+FRAME = struct.Struct("<IHB8s")              # TlCanFrame
+UDP_MAGIC, UDP_VERSION, UDP_KEYFRAME, UDP_RESYNC = ord("U"), 1, 0x01, ord("R")
+TICK_MAGIC, TICK_VERSION, TICK_HAS_STATUS = ord("D"), 1, 0x01
+RESYNC_INTERVAL_S = 0.5  # at most one request per interval
+
+
+@dataclass
+class Snapshot:
+    """One decoded UDP datagram."""
+
+    seq: int
+    keyframe: bool
+    status: Optional[CANFrame]
+    frames: List[CANFrame]
+    link: Tuple[int, int, int]  # car link frames, lost, bad on the bridge
+
+
+def status_row(fields: Tuple) -> CANFrame:
+    """Turn a TlStatus into a table row keyed "STATUS"."""
+
+    ms, rpm, torque, dc_bus, motor_t, igbt_t, error_word, apps1, apps2, step, flags = fields
+    state = "DRIVE" if flags & 0x01 else "IDLE"
+    if not flags & 0x02:
+        state = "OFFLINE"
+    if flags & 0x04:
+        state += " PEDAL FAULT"
+    text = (
+        f"step {step} {state}, {rpm} rpm, torque {torque / 10:.1f} %, {dc_bus / 10:.1f} V, "
+        f"motor {motor_t / 10:.1f} C, igbt {igbt_t / 10:.1f} C, errors 0x{error_word:04X}, "
+        f"apps {apps1}/{apps2}"
+    )
+    return CANFrame(timestamp_ms=ms, can_id="STATUS", dlc=0, data_bytes=[], interpretation=text)
+
+
+def parse_snapshot(data: bytes) -> Optional[Snapshot]:
+    """Decode a datagram, returning None for anything that is not a snapshot."""
+
+    if len(data) < UDP_HEADER.size + TICK_HEADER.size:
+        return None
+    magic, version, flags, _, seq = UDP_HEADER.unpack_from(data, 0)
+    if magic != UDP_MAGIC or version != UDP_VERSION:
+        return None
+    off = UDP_HEADER.size
+    tick = TICK_HEADER.unpack_from(data, off)
+    if tick[0] != TICK_MAGIC or tick[1] != TICK_VERSION:
+        return None
+    off += TICK_HEADER.size
+
+    status = None
+    if tick[2] & TICK_HAS_STATUS:
+        if len(data) < off + STATUS.size:
+            return None
+        status = status_row(STATUS.unpack_from(data, off))
+        off += STATUS.size
+
+    frames = []
+    for _ in range(tick[3]):
+        if len(data) < off + FRAME.size:
+            break
+        ms, can_id, dlc, payload = FRAME.unpack_from(data, off)
+        off += FRAME.size
+        dlc = min(dlc, 8)
+        frames.append(
+            CANFrame(
+                timestamp_ms=ms,
+                can_id=f"0x{can_id:03X}",
+                dlc=dlc,
+                data_bytes=[f"0x{b:02X}" for b in payload],
+                interpretation=f"reg 0x{payload[0]:02X}" if dlc else "",
+            )
+        )
+    return Snapshot(seq, bool(flags & UDP_KEYFRAME), status, frames, (tick[6], tick[7], tick[8]))
+
+
+@dataclass
+class GapTracker:
+    """Counts datagrams the bridge sent but this receiver never saw."""
+
+    received: int = 0
+    lost: int = 0
+    gaps: int = 0
+    keyframes: int = 0
+    resyncs: int = 0
+    link: Tuple[int, int, int] = (0, 0, 0)
+    last_seq: Optional[int] = None
+    synced: bool = False  # have a keyframe since the last gap
+    last_resync: float = -RESYNC_INTERVAL_S
+
+    def feed(self, snap: Snapshot) -> bool:
+        """Account for one snapshot; True when a resync request is due."""
+
+        self.received += 1
+        self.link = snap.link
+        if self.last_seq is not None:
+            delta = (snap.seq - self.last_seq) & 0xFFFFFFFF
+            if delta == 0:
+                return False  # duplicate
+            if delta & 0x80000000:
+                self.synced = False  # went backwards: the bridge restarted
+            elif delta > 1:
+                self.lost += delta - 1
+                self.gaps += 1
+                self.synced = False
+        self.last_seq = snap.seq
+        if snap.keyframe:
+            self.keyframes += 1
+            self.synced = True
+
+        now = time.monotonic()
+        if self.synced or now - self.last_resync < RESYNC_INTERVAL_S:
+            return False
+        self.last_resync = now
+        self.resyncs += 1
+        return True
+
+    def summary(self) -> str:
+        return (
+            f"{self.received} snapshots, {self.lost} lost in {self.gaps} gaps, "
+            f"{self.resyncs} resyncs | car link {self.link[0]} frames, {self.link[1]} lost, "
+            f"{self.link[2]} bad"
+        )
+
+
+def udp_socket(group: str, port: int) -> socket.socket:
+    """Bind the snapshot port and join the multicast group on all interfaces."""
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    mreq = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    sock.settimeout(0.5)
+    return sock
+
+
+def udp_reader(
+    sock: socket.socket, q: queue.Queue[CANFrame], stop_event: threading.Event, tracker: GapTracker
+) -> None:
+    """Receive snapshots, push their rows into the queue and ask for a keyframe after a gap."""
+
+    with sock:
+        while not stop_event.is_set():
+            try:
+                data, sender = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            except OSError:
+                break
+
+            snap = parse_snapshot(data)
+            if snap is None:
+                continue
+
+            if tracker.feed(snap):
+                sock.sendto(bytes((UDP_RESYNC, UDP_VERSION)), sender)
+            if snap.status is not None:
+                q.put(snap.status)
+            for frame in snap.frames:
+                q.put(frame)
+
+
+# ---------- Native backend (can_ingest.h) ----------
+UI_HZ = 30
+SNAPSHOT_ROWS = 256  # rows fetched per ci_snapshot() call
+CI_FORMAT_CSV, CI_FORMAT_SLIP = 0, 1
+CAP_ID_EXT, CAP_ID_RTR = 0x80000000, 0x40000000
+
+
+class CiRow(ctypes.Structure):
+    _fields_ = [
+        ("id", ctypes.c_uint32),
+        ("dlc", ctypes.c_uint8),
+        ("data", ctypes.c_uint8 * 8),
+        ("last_ms", ctypes.c_uint32),
+        ("count", ctypes.c_uint32),
+        ("rate_hz", ctypes.c_float),
+        ("max_gap_ms", ctypes.c_uint32),
+        ("interp", ctypes.c_char * 48),
+    ]
+
+
+class CiStats(ctypes.Structure):
+    _fields_ = [
+        ("bytes", ctypes.c_uint64),
+        ("frames", ctypes.c_uint64),
+        ("bad", ctypes.c_uint64),
+        ("untracked", ctypes.c_uint64),
+        ("ids", ctypes.c_uint32),
+        ("dev_overflows", ctypes.c_uint32),
+        ("dev_rx_errors", ctypes.c_uint8),
+        ("dev_eflg", ctypes.c_uint8),
+    ]
+
+
+def load_native() -> Optional[ctypes.CDLL]:
+    """Load libcan_ingest from next to this script, or None if it is not built."""
+
+    here = os.path.dirname(os.path.abspath(__file__))
+    for name in ("libcan_ingest.so", "libcan_ingest.dylib", "can_ingest.dll"):
+        path = os.path.join(here, name)
+        if not os.path.exists(path):
+            continue
+        lib = ctypes.CDLL(path)
+        lib.ci_create.restype = ctypes.c_void_p
+        lib.ci_create.argtypes = [ctypes.c_int]
+        lib.ci_destroy.argtypes = [ctypes.c_void_p]
+        lib.ci_open_serial.restype = ctypes.c_int
+        lib.ci_open_serial.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+        lib.ci_feed.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+        lib.ci_snapshot.restype = ctypes.c_size_t
+        lib.ci_snapshot.argtypes = [ctypes.c_void_p, ctypes.POINTER(CiRow), ctypes.c_size_t]
+        lib.ci_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(CiStats)]
+        return lib
+    return None
+
+
+class NativeIngest:
+    """One ci_ingest handle; the C side parses, the GUI only takes snapshots."""
+
+    def __init__(self, lib: ctypes.CDLL, fmt: int) -> None:
+        self.lib = lib
+        self.handle = lib.ci_create(fmt)
+        self.rows = (CiRow * SNAPSHOT_ROWS)()
+
+    def open_serial(self, port: str, baud: int) -> int:
+        return self.lib.ci_open_serial(self.handle, port.encode(), baud)
+
+    def feed(self, data: bytes) -> None:
+        self.lib.ci_feed(self.handle, data, len(data))
+
+    def snapshot(self) -> List[CANFrame]:
+        frames = []
+        while True:
+            n = self.lib.ci_snapshot(self.handle, self.rows, SNAPSHOT_ROWS)
+            for r in self.rows[:n]:
+                can_id = r.id & 0x1FFFFFFF
+                text = f"0x{can_id:08X}" if r.id & CAP_ID_EXT else f"0x{can_id:03X}"
+                frames.append(
+                    CANFrame(
+                        timestamp_ms=r.last_ms,
+                        can_id=text + (" RTR" if r.id & CAP_ID_RTR else ""),
+                        dlc=r.dlc,
+                        data_bytes=[f"0x{b:02X}" for b in r.data],
+                        interpretation=r.interp.decode("utf-8", errors="replace"),
+                        count=r.count,
+                        rate_hz=r.rate_hz,
+                    )
+                )
+            if n < SNAPSHOT_ROWS:
+                return frames
+
+    def summary(self) -> str:
+        st = CiStats()
+        self.lib.ci_get_stats(self.handle, ctypes.byref(st))
+        text = f"{st.frames} frames, {st.ids} IDs, {st.bad} bad"
+        if st.untracked:
+            text += f", {st.untracked} untracked"
+        if st.dev_overflows or st.dev_rx_errors or st.dev_eflg:
+            text += f" | listener {st.dev_overflows} overflows, REC {st.dev_rx_errors}, EFLG 0x{st.dev_eflg:02X}"
+        return text
+
+    def close(self) -> None:
+        if self.handle:
+            self.lib.ci_destroy(self.handle)
+            self.handle = None
+
+
+def serial_feeder(serial_port: serial.Serial, ingest: NativeIngest, stop_event: threading.Event) -> None:
+    """Hand raw serial bytes to the native backend (when it cannot open the port itself)."""
+
+    with serial_port:
+        serial_port.reset_input_buffer()
+        while not stop_event.is_set():
+            try:
+                data = serial_port.read(max(1, serial_port.in_waiting))
+            except serial.SerialException:
+                break
+            if data:
+                ingest.feed(data)
+
+
 def serial_reader(serial_port: serial.Serial, q: queue.Queue[CANFrame], stop_event: threading.Event) -> None:
     """Continuously read lines from the serial port and push parsed frames into a queue."""
 
@@ -111,55 +419,80 @@ def serial_reader(serial_port: serial.Serial, q: queue.Queue[CANFrame], stop_eve
 
 
 class CANMonitorGUI:
-    def __init__(self, root: tk.Tk, q: queue.Queue[CANFrame], stop_event: threading.Event) -> None:
+    def __init__(
+        self,
+        root: tk.Tk,
+        q: queue.Queue[CANFrame],
+        stop_event: threading.Event,
+        status_fn: Optional[Callable[[], str]] = None,
+        poll_fn: Optional[Callable[[], List[CANFrame]]] = None,
+    ) -> None:
         self.root = root
         self.queue = q
         self.stop_event = stop_event
+        self.status_fn = status_fn
+        self.poll_fn = poll_fn
         self.rows: Dict[str, str] = {}
 
         self.root.title("CAN Message Monitor")
-        self.root.geometry("720x400")
+        self.root.geometry("860x400")
 
         self.status_var = tk.StringVar(value="Connecting...")
         status_label = ttk.Label(self.root, textvariable=self.status_var, anchor="w")
         status_label.pack(fill=tk.X, padx=8, pady=(8, 4))
 
-        columns = ("id", "data", "timestamp", "interpretation")
+        columns = ("id", "data", "timestamp", "count", "rate", "interpretation")
         self.tree = ttk.Treeview(self.root, columns=columns, show="headings")
         self.tree.heading("id", text="CAN ID")
         self.tree.heading("data", text="Hex Data")
         self.tree.heading("timestamp", text="Last Timestamp")
+        self.tree.heading("count", text="Count")
+        self.tree.heading("rate", text="Rate")
         self.tree.heading("interpretation", text="Interpretation")
 
         self.tree.column("id", width=90, anchor=tk.CENTER)
         self.tree.column("data", width=250, anchor=tk.W)
         self.tree.column("timestamp", width=120, anchor=tk.CENTER)
+        self.tree.column("count", width=70, anchor=tk.E)
+        self.tree.column("rate", width=70, anchor=tk.E)
         self.tree.column("interpretation", width=220, anchor=tk.W)
 
         self.tree.pack(fill=tk.BOTH, expand=True, padx=8, pady=4)
 
-        self.root.after(100, self.process_queue)
+        self.root.after(1000 // UI_HZ, self.process_queue)
         self.root.protocol("WM_DELETE_WINDOW", self.on_close)
 
     def set_status(self, message: str) -> None:
         self.status_var.set(message)
 
     def process_queue(self) -> None:
+        # Newest frame per ID only: one Tk update per changed row per refresh.
+        latest: Dict[str, CANFrame] = {}
         try:
             while True:
                 frame = self.queue.get_nowait()
-                self.update_row(frame)
+                latest[frame.can_id] = frame
         except queue.Empty:
             pass
+        if self.poll_fn is not None:
+            for frame in self.poll_fn():
+                latest[frame.can_id] = frame
+        for frame in latest.values():
+            self.update_row(frame)
+
+        if self.status_fn is not None:
+            self.set_status(self.status_fn())
 
         if not self.stop_event.is_set():
-            self.root.after(100, self.process_queue)
+            self.root.after(1000 // UI_HZ, self.process_queue)
 
     def update_row(self, frame: CANFrame) -> None:
         values = (
             frame.can_id,
             frame.data_display,
             frame.elapsed_seconds,
+            "" if frame.count is None else frame.count,
+            frame.rate_display,
             frame.interpretation,
         )
 
@@ -175,38 +508,92 @@ class CANMonitorGUI:
         self.root.quit()
 
 
+def open_serial_port(port: str, baud: int, timeout: float) -> serial.Serial:
+    if serial is None:
+        raise SystemExit("pyserial is required for this tool. Install it with 'pip install pyserial'.")
+    try:
+        return serial.Serial(port, baudrate=baud, timeout=timeout)
+    except serial.SerialException as exc:
+        raise SystemExit(f"Failed to open serial port {port!r}: {exc}") from exc
+
+
 def main() -> None:
     parser = argparse.ArgumentParser(description="Visualise CAN messages streamed from an Arduino over serial.")
-    parser.add_argument("port", help="Serial port to open, e.g. /dev/tty.usbmodem101")
+    parser.add_argument("port", nargs="?", help="Serial port to open, e.g. /dev/tty.usbmodem101")
     parser.add_argument("--baud", type=int, default=115200, help="Baud rate to use (default: 115200)")
     parser.add_argument("--timeout", type=float, default=0.5, help="Serial read timeout in seconds (default: 0.5)")
+    parser.add_argument("--binary", action="store_true", help="Port carries the SLIP capture stream (native backend)")
+    parser.add_argument("--python", action="store_true", help="Use the Python CSV parser even if libcan_ingest is built")
+    parser.add_argument("--udp", action="store_true", help="Listen to the Wi-Fi bridge's UDP snapshots instead")
+    parser.add_argument("--group", default=UDP_GROUP, help=f"Multicast group for --udp (default: {UDP_GROUP})")
+    parser.add_argument("--udp-port", type=int, default=UDP_PORT, help=f"UDP port for --udp (default: {UDP_PORT})")
     args = parser.parse_args()
-
-    try:
-        serial_port = serial.Serial(args.port, baudrate=args.baud, timeout=args.timeout)
-    except serial.SerialException as exc:
-        raise SystemExit(f"Failed to open serial port {args.port!r}: {exc}") from exc
+    if not args.udp and args.port is None:
+        parser.error("a serial port is required unless --udp is given")
 
     stop_event = threading.Event()
     frame_queue: queue.Queue[CANFrame] = queue.Queue()
+    status_fn: Optional[Callable[[], str]] = None
+    poll_fn: Optional[Callable[[], List[CANFrame]]] = None
+    native: Optional[NativeIngest] = None
+    reader_thread: Optional[threading.Thread] = None
+    source = f"{args.port} @ {args.baud} baud"
 
-    reader_thread = threading.Thread(
-        target=serial_reader,
-        args=(serial_port, frame_queue, stop_event),
-        daemon=True,
-        name="SerialReader",
-    )
-    reader_thread.start()
+    if args.udp:
+        try:
+            sock = udp_socket(args.group, args.udp_port)
+        except OSError as exc:
+            raise SystemExit(f"Failed to join {args.group}:{args.udp_port}: {exc}") from exc
+        tracker = GapTracker()
+        status_fn = lambda: f"UDP {args.group}:{args.udp_port} | {tracker.summary()}"
+        reader_thread = threading.Thread(
+            target=udp_reader,
+            args=(sock, frame_queue, stop_event, tracker),
+            daemon=True,
+            name="UdpReader",
+        )
+    else:
+        lib = None if args.python else load_native()
+        if lib is None and args.binary:
+            parser.error("--binary needs the native backend, build tools/libcan_ingest (see can_ingest.cpp)")
+
+        if lib is not None:
+            native = NativeIngest(lib, CI_FORMAT_SLIP if args.binary else CI_FORMAT_CSV)
+            poll_fn = native.snapshot
+            status_fn = lambda: f"{source} (native) | {native.summary()}"
+            rc = native.open_serial(args.port, args.baud)
+            if rc == -errno.ENOSYS:  # no POSIX serial in the library: feed it from pyserial
+                reader_thread = threading.Thread(
+                    target=serial_feeder,
+                    args=(open_serial_port(args.port, args.baud, args.timeout), native, stop_event),
+                    daemon=True,
+                    name="SerialFeeder",
+                )
+            elif rc != 0:
+                raise SystemExit(f"Failed to open serial port {args.port!r}: {os.strerror(-rc)}")
+        else:
+            reader_thread = threading.Thread(
+                target=serial_reader,
+                args=(open_serial_port(args.port, args.baud, args.timeout), frame_queue, stop_event),
+                daemon=True,
+                name="SerialReader",
+            )
+    if reader_thread is not None:
+        reader_thread.start()
 
     root = tk.Tk()
-    gui = CANMonitorGUI(root, frame_queue, stop_event)
-    gui.set_status(f"Connected to {args.port} @ {args.baud} baud")
+    gui = CANMonitorGUI(root, frame_queue, stop_event, status_fn, poll_fn)
+    if status_fn is None:
+        gui.set_status(f"Connected to {source}")
 
     try:
         root.mainloop()
     finally:
         stop_event.set()
-        reader_thread.join(timeout=1.0)
+        if reader_thread is not None:
+            reader_thread.join(timeout=1.0)
+        if native is not None:
+            native.close()
 
 
 if __name__ == "__main__":
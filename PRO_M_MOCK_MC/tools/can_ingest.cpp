@@ -0,0 +1,298 @@
+// Native ingest/decode backend for can_gui.py, see can_ingest.h.
+//
+// Build (from PRO_M_MOCK_MC):
+//   g++ -O2 -std=c++17 -shared -fPIC -pthread -Iinclude tools/can_ingest.cpp -o tools/libcan_ingest.so
+// can_gui.py loads tools/libcan_ingest.so (.dylib on macOS, can_ingest.dll
+// on Windows) when it exists and falls back to its Python parser otherwise.
+
+#include "can_ingest.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "can_capture.h"
+
+#define CI_TABLE_SIZE  2048   // power of two; all 11-bit IDs fit
+#define CI_TABLE_MAX   (CI_TABLE_SIZE * 3 / 4)
+#define CI_LINE_MAX    256
+#define CI_RATE_WINDOW std::chrono::seconds(1)
+
+typedef std::chrono::steady_clock Clock;
+
+struct Entry {
+  bool     used;
+  bool     dirty;
+  uint32_t windowCount;  // frames since the rate window started
+  ci_row   row;
+};
+
+struct ci_ingest {
+  int format;
+  std::mutex lock;  // everything below; the reader thread and the GUI share it
+  Entry table[CI_TABLE_SIZE];
+  ci_stats stats;
+  size_t scan = 0;  // where the next ci_snapshot() resumes
+  Clock::time_point windowStart = Clock::now();
+
+  // Parser state.
+  char line[CI_LINE_MAX];
+  size_t lineLen = 0;
+  CapDecoder slip;
+
+  std::thread reader;
+  std::atomic<bool> stop{false};
+  int fd = -1;
+};
+
+// ---------- Table ----------
+static uint32_t slotOf(uint32_t id) {
+  return (uint32_t)(id * 2654435761u) & (CI_TABLE_SIZE - 1);
+}
+
+static Entry *lookup(ci_ingest *h, uint32_t id) {
+  for (uint32_t i = slotOf(id);; i = (i + 1) & (CI_TABLE_SIZE - 1)) {
+    Entry &e = h->table[i];
+    if (e.used && e.row.id == id) return &e;
+    if (!e.used) {
+      if (h->stats.ids >= CI_TABLE_MAX) return nullptr;
+      e.used = true;
+      e.row.id = id;
+      h->stats.ids++;
+      return &e;
+    }
+  }
+}
+
+// Parsing runs with h->lock held, one lock per ci_feed() chunk.
+static void record(ci_ingest *h, uint32_t id, uint32_t ms, uint8_t dlc, const uint8_t *data,
+                   const char *interp, size_t interpLen) {
+  h->stats.frames++;
+  Entry *e = lookup(h, id);
+  if (!e) {
+    h->stats.untracked++;
+    return;
+  }
+  ci_row &r = e->row;
+  if (r.count > 0 && ms - r.last_ms > r.max_gap_ms && ms >= r.last_ms) r.max_gap_ms = ms - r.last_ms;
+  r.count++;
+  r.last_ms = ms;
+  r.dlc = dlc;
+  memset(r.data, 0, sizeof(r.data));
+  memcpy(r.data, data, dlc);
+  if (interpLen >= CI_INTERP_LEN) interpLen = CI_INTERP_LEN - 1;
+  memcpy(r.interp, interp, interpLen);
+  r.interp[interpLen] = 0;
+  e->windowCount++;
+  e->dirty = true;
+}
+
+// ---------- CSV ----------
+// timestamp,id,dlc,data0..data7[,interpretation]; ids and bytes in hex with
+// or without 0x, empty data columns for short frames (can_gui.py format).
+static bool parseHex(const char *s, const char *end, uint32_t &out) {
+  if (end - s >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s += 2;
+  if (s >= end) return false;
+  uint32_t v = 0;
+  for (; s < end; s++) {
+    char c = *s;
+    uint32_t d;
+    if (c >= '0' && c <= '9') d = c - '0';
+    else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+    else return false;
+    v = v << 4 | d;
+  }
+  out = v;
+  return true;
+}
+
+static bool parseDec(const char *s, const char *end, uint32_t &out) {
+  if (s >= end) return false;
+  uint32_t v = 0;
+  for (; s < end; s++) {
+    if (*s < '0' || *s > '9') return false;
+    v = v * 10 + (uint32_t)(*s - '0');
+  }
+  out = v;
+  return true;
+}
+
+static void trim(const char *&s, const char *&end) {
+  while (s < end && (*s == ' ' || *s == '\t')) s++;
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+}
+
+static void csvLine(ci_ingest *h, const char *s, size_t len) {
+  const char *field[12], *fieldEnd[12];
+  size_t n = 0;
+  const char *p = s, *end = s + len;
+  while (n < 12) {
+    const char *q = n == 11 ? end : (const char *)memchr(p, ',', end - p);
+    if (!q) q = end;
+    field[n] = p;
+    fieldEnd[n] = q;
+    trim(field[n], fieldEnd[n]);
+    n++;
+    if (q == end) break;
+    p = q + 1;
+  }
+  if (n == 0 || (n == 1 && field[0] == fieldEnd[0])) return;  // blank line
+  if (fieldEnd[0] - field[0] >= 9 && strncmp(field[0], "timestamp", 9) == 0) return;  // header
+
+  uint32_t ms, id, dlc;
+  if (n < 11 || !parseDec(field[0], fieldEnd[0], ms) || !parseHex(field[1], fieldEnd[1], id) ||
+      !parseDec(field[2], fieldEnd[2], dlc)) {
+    h->stats.bad++;
+    return;
+  }
+  if (dlc > 8) dlc = 8;
+  uint8_t data[8] = {};
+  for (uint32_t i = 0; i < dlc; i++) {
+    uint32_t b;
+    if (parseHex(field[3 + i], fieldEnd[3 + i], b)) data[i] = (uint8_t)b;
+  }
+  size_t interpLen = n > 11 ? (size_t)(fieldEnd[11] - field[11]) : 0;
+  record(h, id, ms, (uint8_t)dlc, data, n > 11 ? field[11] : "", interpLen);
+}
+
+// ---------- SLIP ----------
+static void slipRecord(ci_ingest *h) {
+  CapFrame f;
+  CapStats s;
+  if (h->slip.type() == CAP_FRAME && h->slip.read(f)) {
+    record(h, f.id, f.us / 1000, f.len > 8 ? 8 : f.len, f.data, "", 0);
+  } else if (h->slip.type() == CAP_STATS && h->slip.read(s)) {
+    h->stats.dev_overflows = s.overflows;
+    h->stats.dev_rx_errors = s.rxErrors;
+    h->stats.dev_eflg = s.eflg;
+  } else {
+    h->stats.bad++;
+  }
+}
+
+// ---------- API ----------
+extern "C" {
+
+ci_ingest *ci_create(int format) {
+  ci_ingest *h = new ci_ingest();
+  h->format = format;
+  return h;
+}
+
+void ci_destroy(ci_ingest *h) {
+  if (!h) return;
+  h->stop = true;
+  if (h->reader.joinable()) h->reader.join();
+#ifndef _WIN32
+  if (h->fd >= 0) close(h->fd);
+#endif
+  delete h;
+}
+
+void ci_feed(ci_ingest *h, const uint8_t *bytes, size_t len) {
+  std::lock_guard<std::mutex> g(h->lock);
+  h->stats.bytes += len;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = bytes[i];
+    if (h->format == CI_FORMAT_SLIP) {
+      if (h->slip.push(b)) slipRecord(h);
+      continue;
+    }
+    if (b == '\n') {
+      csvLine(h, h->line, h->lineLen);
+      h->lineLen = 0;
+    } else if (h->lineLen < CI_LINE_MAX) {
+      h->line[h->lineLen++] = (char)b;
+    }
+  }
+}
+
+int ci_open_serial(ci_ingest *h, const char *path, int baud) {
+#ifdef _WIN32
+  (void)h; (void)path; (void)baud;
+  return -ENOSYS;
+#else
+  if (h->fd >= 0) return -EBUSY;
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) return -errno;
+
+  struct termios t;
+  if (tcgetattr(fd, &t) == 0) {
+    cfmakeraw(&t);
+    t.c_cc[VMIN] = 0;
+    t.c_cc[VTIME] = 1;  // read() returns after 100 ms so the thread sees stop
+    speed_t speed = B115200;
+    switch (baud) {
+      case 9600:   speed = B9600;   break;
+      case 57600:  speed = B57600;  break;
+      case 230400: speed = B230400; break;
+#ifdef B460800
+      case 460800: speed = B460800; break;
+#endif
+      default: break;  // USB CDC ignores it anyway
+    }
+    cfsetispeed(&t, speed);
+    cfsetospeed(&t, speed);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  tcflush(fd, TCIFLUSH);
+
+  h->fd = fd;
+  h->reader = std::thread([h] {
+    uint8_t buf[4096];
+    while (!h->stop) {
+      ssize_t n = read(h->fd, buf, sizeof(buf));
+      if (n > 0) ci_feed(h, buf, (size_t)n);
+      else if (n < 0 && errno != EINTR && errno != EAGAIN) break;
+    }
+  });
+  return 0;
+#endif
+}
+
+size_t ci_snapshot(ci_ingest *h, ci_row *out, size_t max) {
+  std::lock_guard<std::mutex> g(h->lock);
+
+  // Rates over whole seconds; a rate that changed marks its row dirty.
+  Clock::time_point now = Clock::now();
+  if (now - h->windowStart >= CI_RATE_WINDOW) {
+    float secs = std::chrono::duration<float>(now - h->windowStart).count();
+    for (Entry &e : h->table) {
+      if (!e.used) continue;
+      float rate = e.windowCount / secs;
+      if (rate != e.row.rate_hz) e.dirty = true;
+      e.row.rate_hz = rate;
+      e.windowCount = 0;
+    }
+    h->windowStart = now;
+  }
+
+  size_t n = 0;
+  for (size_t k = 0; k < CI_TABLE_SIZE && n < max; k++) {
+    Entry &e = h->table[(h->scan + k) & (CI_TABLE_SIZE - 1)];
+    if (!e.used || !e.dirty) continue;
+    out[n++] = e.row;
+    e.dirty = false;
+    if (n == max) h->scan = (h->scan + k + 1) & (CI_TABLE_SIZE - 1);
+  }
+  return n;
+}
+
+void ci_get_stats(ci_ingest *h, ci_stats *out) {
+  std::lock_guard<std::mutex> g(h->lock);
+  *out = h->stats;
+}
+
+}  // extern "C"
@@ -0,0 +1,67 @@
+#ifndef CAN_INGEST_H
+#define CAN_INGEST_H
+
+// Native ingest/decode backend for can_gui.py (host library, C ABI for ctypes).
+//
+// Bytes from the listener, either the CSV lines of the Pro Micro sketch or
+// the SLIP capture stream (include/can_capture.h), are parsed into a flat
+// per-ID table: newest payload, frame count, rate over the last second and
+// the longest gap. The GUI polls ci_snapshot() at its frame rate and gets
+// only the rows that changed, so its cost depends on the number of IDs on
+// the bus, never on the frame rate.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CI_FORMAT_CSV   0
+#define CI_FORMAT_SLIP  1
+
+#define CI_INTERP_LEN   48
+
+typedef struct ci_ingest ci_ingest;
+
+typedef struct {
+  uint32_t id;                    // with CAP_ID_EXT / CAP_ID_RTR flags
+  uint8_t  dlc;
+  uint8_t  data[8];
+  uint32_t last_ms;               // device timestamp of the newest frame
+  uint32_t count;                 // frames since ci_create()
+  float    rate_hz;               // frames in the last full second
+  uint32_t max_gap_ms;            // longest time between two frames
+  char     interp[CI_INTERP_LEN]; // CSV interpretation column, "" for SLIP
+} ci_row;
+
+typedef struct {
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t bad;          // unparsable lines or records
+  uint64_t untracked;    // frames of IDs that found no table slot
+  uint32_t ids;          // rows in the table
+  uint32_t dev_overflows;  // SLIP: CapStats.overflows, the listener's ring
+  uint8_t  dev_rx_errors;  // SLIP: MCP2515 REC
+  uint8_t  dev_eflg;       // SLIP: MCP2515 EFLG
+} ci_stats;
+
+ci_ingest *ci_create(int format);
+void       ci_destroy(ci_ingest *h);
+
+// Starts a reader thread on a serial device (POSIX only). Returns 0, or a
+// negative errno; callers that cannot use it read the port themselves and
+// hand the bytes to ci_feed().
+int  ci_open_serial(ci_ingest *h, const char *path, int baud);
+void ci_feed(ci_ingest *h, const uint8_t *bytes, size_t len);
+
+// Copies up to max rows changed since the previous call; returns how many.
+// Rows left over are returned by the next call.
+size_t ci_snapshot(ci_ingest *h, ci_row *out, size_t max);
+void   ci_get_stats(ci_ingest *h, ci_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+// Microbenchmarks for the firmware hot paths. Links the real src/ modules
+// (everything but main.cpp) and times each path on the DWT cycle counter;
+// the native build runs the same code on the replay stubs, where cycles
+// are host time scaled to 600 MHz (replay_hal.h).
+//
+// Output, one line per benchmark:
+//   BENCH <name> <ops> <cycles_per_op> <bytes_per_op>
+// cycles_per_op is the best of BENCH_BATCHES batch averages; bytes_per_op
+// is what the path hands to its sink (log slots, Nextion TX ring, buffer).
+// Flushing and draining happen between batches, outside the timed region.
+//
+// Before timing, the temperature LUTs are checked against their float
+// references over every ADC value: a maximum error of TEMP_LUT_MAX_ERROR_C
+// or more prints a FAIL line and the native build exits with status 1.
+//
+// Build and run (from TEENSY_COMMAND_MOTOR):
+//   pio run -e bench_native && .pio/build/bench_native/program > bench.txt
+//   pio run -e bench_teensy41 -t upload && pio device monitor > bench.txt
+//   python3 bench/compare.py bench/baseline_native.txt bench.txt
+
+#include "config.h"
+#include "logging.h"
+#include "bamocar.h"
+#include "pedal.h"
+#include "torque_shaping.h"
+#include "vehicle_state.h"
+#include "nextion.h"
+#include "MpuController.h"
+#include <math.h>
+
+// ---------- Global definitions (main.cpp is not linked) ----------
+FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can1;
+FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16> Can2;
+#if CAN_FD_TELEMETRY
+FlexCAN_T4FD<CAN3, RX_SIZE_256, TX_SIZE_64> CanFD;
+#else
+FlexCAN_T4<CAN3, RX_SIZE_256, TX_SIZE_16> Can3;
+#endif
+const int chipSelect = BUILTIN_SDCARD;
+int8_t currentStep = 0;
+int16_t currentTorque = 0;
+uint32_t lastTorqueSend = 0;
+bool bamocarOnline = false;
+BamocarState bamocar = {};
+int16_t apps1Raw = 0;
+int16_t apps2Raw = 0;
+bool pedalFault = false;
+bool driveEnabled = false;
+uint32_t lastBAMOCARRx = 0;
+Adafruit_MPU6050 mpu;
+MpuController mpuController(mpu);
+
+#define BENCH_BATCHES   16
+#define BENCH_LOG_FILE  "bench.log"
+#define BENCH_DRAIN_MS  60   // Nextion TX ring empties at 115200 baud
+
+static volatile uint32_t _sink;  // keeps results the compiler could drop
+
+static void out(const char *line) {
+#ifdef ARDUINO
+  Serial.print(line);
+#else
+  fputs(line, stdout);
+#endif
+}
+
+// ---------- Runner ----------
+typedef void (*BenchOp)(uint32_t i);
+
+static void run(const char *name, BenchOp op, uint16_t batch,
+                void (*between)() = nullptr, uint32_t (*bytes)() = nullptr) {
+  if (between) between();
+  uint32_t bytes0 = bytes ? bytes() : 0;
+  uint32_t best = UINT32_MAX;
+  uint32_t i = 0;
+  for (uint8_t b = 0; b < BENCH_BATCHES; b++) {
+    uint32_t t0 = ARM_DWT_CYCCNT;
+    for (uint16_t k = 0; k < batch; k++) op(i++);
+    uint32_t dt = ARM_DWT_CYCCNT - t0;
+    if (dt < best) best = dt;
+    if (between) between();
+  }
+  // 0.1 resolution without float printf.
+  uint32_t cyc10 = (uint32_t)((uint64_t)best * 10 / batch);
+  uint32_t bytes10 = bytes ? (uint32_t)((uint64_t)(bytes() - bytes0) * 10 / i) : 0;
+  char line[96];
+  snprintf(line, sizeof(line), "BENCH %s %lu %lu.%lu %lu.%lu\n", name, (unsigned long)i,
+           (unsigned long)(cyc10 / 10), (unsigned long)(cyc10 % 10),
+           (unsigned long)(bytes10 / 10), (unsigned long)(bytes10 % 10));
+  out(line);
+}
+
+// ---------- Logging ----------
+static uint32_t logBytes() {
+  const LogStats &s = logStats();
+  return s.bytesWritten + s.bytesDropped;
+}
+
+static bool benchLogOpen() {
+#ifndef ARDUINO
+  replaySetSdPath("/dev/null");
+#endif
+  if (!SD.begin(chipSelect)) return false;
+  if (!logOpen(BENCH_LOG_FILE)) return false;
+  logFlush();
+  return true;
+}
+
+static void benchLogCan(uint32_t i) {
+  CAN_message_t msg;
+  msg.id = (i & 1) ? BAMOCAR_TX_ID : BAMOCAR_RX_ID;
+  msg.len = 3;
+  msg.buf[0] = REG_SPEED_ACTUAL;
+  msg.buf[1] = (uint8_t)i;
+  msg.buf[2] = (uint8_t)(i >> 8);
+  logCANFrame(msg, (i & 1) ? "RX" : "TX");
+}
+
+static void benchLogSensor(uint32_t i) {
+  logSensor((int16_t)(i & 4095), (int16_t)(4095 - (i & 4095)), false, (int16_t)i, (int16_t)-i, 5400);
+}
+
+static void benchLogImu(uint32_t i) {
+  int16_t raw[6] = { (int16_t)i, (int16_t)-i, 16384, (int16_t)(i * 3), (int16_t)(i * 5), -7 };
+  logIMU(micros() + i * IMU_PERIOD_US, raw);
+}
+
+// ---------- CAN decode ----------
+// handleFrame() is internal to bamocar.cpp; the decode it runs per frame
+// is bamocarDecode() into the shared state, timed here per register.
+static const BamocarRegister *_decodeRow;
+static BamocarState _decodeState;
+
+static void benchDecode(uint32_t i) {
+  uint8_t buf[8] = { _decodeRow->reg, (uint8_t)(i * 131), (uint8_t)(i >> 2), 0, 0 };
+  if (bamocarDecode(buf, 1 + _decodeRow->width, _decodeState)) _sink++;
+}
+
+// ---------- Temperature LUTs ----------
+static void benchMotorTemp(uint32_t i) {
+  _sink += (uint32_t)motorADCToTemp((uint16_t)(i * 37));
+}
+
+static void benchIgbtTemp(uint32_t i) {
+  _sink += (uint32_t)igbtADCToTemp((uint16_t)(16000 + (i * 13) % 13000));
+}
+
+// ---------- Pedal ----------
+static uint16_t _apps1Block[APPS_DMA_BLOCK], _apps2Block[APPS_DMA_BLOCK];
+
+// One sample per sensor changes every call, so the median sees fresh data.
+static void benchPedalFilter(uint32_t i) {
+  uint16_t k = i % APPS_DMA_BLOCK;
+  _apps1Block[k] = (uint16_t)((APPS1_REST + APPS1_FULL) / 2 + (i * 7) % 5);
+  _apps2Block[k] = (uint16_t)((APPS2_REST + APPS2_FULL) / 2 + (i * 3) % 5);
+  pedalFilter(_apps1Block, _apps2Block, APPS_DMA_BLOCK);
+}
+
+// Filtered values sweep the pedal travel; both sensors agree.
+static void benchPedalTorque(uint32_t i) {
+  int pos = (int)(i % 101);
+  apps1Raw = (int16_t)(APPS1_REST + (APPS1_FULL - APPS1_REST) * pos / 100);
+  apps2Raw = (int16_t)(APPS2_REST + (APPS2_FULL - APPS2_REST) * pos / 100);
+  updateTorqueFromPedal();
+  _sink += (uint32_t)currentTorque;
+}
+
+// pedalSample() finds no DMA block (pedalBegin() was not called); a fresh
+// pedalFilter() keeps updateTorqueFromPedal() off its stale-data path.
+static void pedalRefresh() {
+  pedalFilter(_apps1Block, _apps2Block, APPS_DMA_BLOCK);
+}
+
+// Telemetry sweeps speed, temperatures and DC bus through every limit.
+static void benchTorqueLimits(uint32_t i) {
+  bamocar.rpmFeedback = (int16_t)(i * 131 % 32768);
+  bamocar.motorTemp = 60.0f + (float)(i % 70);
+  bamocar.inverterTemp = 40.0f + (float)(i % 50);
+  bamocar.dcBusVoltage = 300.0f + (float)(i % 300);
+  torqueLimitsTick();
+  _sink += (uint32_t)torqueLimits().limit;
+}
+
+// ---------- Vehicle state ----------
+// Rolling at ~20 m/s with the wheel spinning up every 64 samples.
+static void benchVehicleImu(uint32_t i) {
+  const int16_t raw[6] = { (int16_t)(1200 + (i & 31)), 40, 4096, 3, -2, (int16_t)(i & 63) };
+  bamocar.rpmFeedback = (int16_t)(6200 + ((i & 64) ? 900 : 0));
+  vehicleStateImu(i * IMU_PERIOD_US, raw);
+  _sink += (uint32_t)vehicleState().speedMs;
+}
+
+// ---------- Nextion ----------
+static uint32_t nextionBytes() {
+  return nextionStats().bytes;
+}
+
+static void nextionDrain() {
+  for (uint8_t k = 0; k < BENCH_DRAIN_MS; k++) {
+    nextionService();
+    delay(1);
+  }
+}
+
+// Steady state: one changed value per call.
+static void benchNextionNum(uint32_t i) {
+  nextionNum(NX_DRIVE_RPM, (int)i);
+}
+
+// Page switch plus a full drive page refresh with every value changed.
+static void benchNextionDrive(uint32_t i) {
+  bamocar.rpmFeedback = (int16_t)(i * 97);
+  bamocar.dcBusVoltage = 540.0f + (float)(i & 15);
+  bamocar.motorTemp = 40.0f + (float)(i & 7);
+  bamocar.inverterTemp = 35.0f + (float)(i & 7);
+  currentTorque = (int16_t)(i * 13 % TORQUE_MAX);
+  pedalFault = i & 1;
+  driveEnabled = i & 2;
+  nextionPage(NX_PAGE_DRIVE);
+  nextionUpdateDrive();
+}
+
+// ---------- Error description ----------
+static uint32_t _descBytes = 0;
+
+static uint32_t descBytes() {
+  return _descBytes;
+}
+
+static void benchErrorDescription(uint32_t i) {
+  char buf[96];
+  uint32_t word = (1u << (i & 15)) | ((i & 16) ? 0x0300 : 0);  // one or three bits
+  bamocarErrorDescription(word, buf, sizeof(buf));
+  _descBytes += strlen(buf);
+}
+
+// ---------- Temperature LUT accuracy ----------
+#define TEMP_LUT_MAX_ERROR_C 0.1f
+
+static bool _failed = false;
+
+static void checkTempLut(const char *name, float (*lut)(uint16_t), float (*ref)(uint16_t, bool)) {
+  float worst = 0.0f;
+  uint16_t worstAdc = 0;
+  for (uint32_t adc = 0; adc <= 32767; adc++) {
+    float err = fabsf(lut((uint16_t)adc) - ref((uint16_t)adc, false));
+    if (err > worst) {
+      worst = err;
+      worstAdc = (uint16_t)adc;
+    }
+  }
+  bool ok = worst < TEMP_LUT_MAX_ERROR_C;
+  if (!ok) _failed = true;
+  char line[96];
+  snprintf(line, sizeof(line), "# %s %s: max error %.4f C at adc %u\n",
+           ok ? "ok" : "FAIL", name, worst, worstAdc);
+  out(line);
+}
+
+// ---------- Suite ----------
+static void runAll() {
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  out("# name ops cycles_per_op bytes_per_op\n");
+
+  if (benchLogOpen()) {
+    run("log_can", benchLogCan, 64, logFlush, logBytes);
+    run("log_sensor", benchLogSensor, 64, logFlush, logBytes);
+    run("log_imu", benchLogImu, 64, logFlush, logBytes);
+    logClose();
+  } else {
+    out("# no SD card: log_* skipped\n");
+  }
+
+  for (const BamocarRegister &r : BAMOCAR_REGISTERS) {
+    char name[32];
+    snprintf(name, sizeof(name), "decode_%s", r.name);
+    _decodeRow = &r;
+    run(name, benchDecode, 1024);
+  }
+
+  run("temp_motor", benchMotorTemp, 1024);
+  run("temp_igbt", benchIgbtTemp, 1024);
+
+  // Sensor noise of a few counts around a half-pressed pedal.
+  for (uint16_t k = 0; k < APPS_DMA_BLOCK; k++) {
+    _apps1Block[k] = (uint16_t)((APPS1_REST + APPS1_FULL) / 2 + (k * 7) % 5);
+    _apps2Block[k] = (uint16_t)((APPS2_REST + APPS2_FULL) / 2 + (k * 3) % 5);
+  }
+  run("pedal_filter", benchPedalFilter, 64);
+  run("torque_limits", benchTorqueLimits, 256);
+  bamocar = {};
+  torqueLimitsTick();  // standstill, cold: full torque available
+  run("pedal_torque", benchPedalTorque, 64, pedalRefresh);
+  run("vehicle_imu", benchVehicleImu, 256);
+
+  nextionBegin();
+  nextionDrain();
+  run("nextion_num", benchNextionNum, 16, nextionDrain, nextionBytes);
+  run("nextion_drive", benchNextionDrive, 4, nextionDrain, nextionBytes);
+  if (nextionStats().dropped) out("# nextion TX ring overflowed: nextion_* understated\n");
+
+  run("error_description", benchErrorDescription, 64, nullptr, descBytes);
+
+  checkTempLut("temp_motor_lut", motorADCToTemp, motorADCToTempRef);
+  checkTempLut("temp_igbt_lut", igbtADCToTemp, igbtADCToTempRef);
+  out("# done\n");
+}
+
+#ifdef ARDUINO
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 3000) {}
+  runAll();
+}
+
+void loop() {}
+#else
+int main() {
+  runAll();
+  return _failed ? 1 : 0;
+}
+#endif
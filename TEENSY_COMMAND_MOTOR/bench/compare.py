@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Compare a benchmark run (bench/bench_main.cpp output) against a stored baseline.
+
+A benchmark regresses when its cycles/op grows by more than --threshold
+percent and by more than --slack cycles (host timer noise on the
+few-cycle benchmarks), or when its bytes/op changes at all (output format
+drift). Benchmarks missing from either side are reported but do not fail
+the run.
+
+Teensy cycle counts are deterministic enough for the default threshold.
+Native counts depend on the host, so bench/baseline_native.txt only means
+something on the machine that recorded it: re-record before comparing.
+
+Usage:
+    python3 bench/compare.py bench/baseline_native.txt bench.txt
+    python3 bench/compare.py --threshold 5 bench/baseline_teensy41.txt bench.txt
+    python3 bench/compare.py --update bench/baseline_teensy41.txt bench.txt
+
+Input lines other than "BENCH <name> <ops> <cycles_per_op> <bytes_per_op>"
+(serial monitor chatter, comments) are ignored, so a captured monitor log
+can be passed directly. Exit status is 1 if anything regressed.
+"""
+
+import argparse
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) != 5 or fields[0] != "BENCH":
+                continue
+            results[fields[1]] = (float(fields[3]), float(fields[4]))
+    return results
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Check benchmark results against a baseline")
+    ap.add_argument("baseline")
+    ap.add_argument("results")
+    ap.add_argument("--threshold", type=float, default=10.0,
+                    help="allowed cycles/op increase in percent (default 10)")
+    ap.add_argument("--slack", type=float, default=2.0,
+                    help="cycles/op increase always allowed (default 2)")
+    ap.add_argument("--update", action="store_true",
+                    help="replace the baseline with the results")
+    args = ap.parse_args()
+
+    current = load(args.results)
+    if not current:
+        sys.exit(f"compare: no BENCH lines in {args.results}")
+
+    if args.update:
+        with open(args.results) as src, open(args.baseline, "w") as dst:
+            for line in src:
+                if line.startswith("BENCH "):
+                    dst.write(line)
+        print(f"{args.baseline}: {len(current)} benchmarks")
+        return
+
+    try:
+        base = load(args.baseline)
+    except FileNotFoundError:
+        sys.exit(f"compare: {args.baseline} missing, record one with --update")
+
+    regressed = 0
+    print(f"{'benchmark':<22} {'base':>10} {'now':>10} {'change':>8}")
+    for name in sorted(set(base) | set(current)):
+        if name not in current:
+            print(f"{name:<22} {base[name][0]:>10.1f} {'-':>10}   missing")
+            continue
+        if name not in base:
+            print(f"{name:<22} {'-':>10} {current[name][0]:>10.1f}   new")
+            continue
+        (bc, bb), (nc, nb) = base[name], current[name]
+        change = (nc - bc) * 100.0 / bc if bc > 0 else 0.0
+        flag = ""
+        if change > args.threshold and nc - bc > args.slack:
+            flag = "  REGRESSED"
+        if nb != bb:
+            flag += f"  bytes/op {bb:g} -> {nb:g}"
+        if flag:
+            regressed += 1
+        print(f"{name:<22} {bc:>10.1f} {nc:>10.1f} {change:>+7.1f}%{flag}")
+
+    if regressed:
+        print(f"{regressed} regression(s) over {args.threshold:g}%")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
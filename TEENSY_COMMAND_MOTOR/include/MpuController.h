@@ -2,11 +2,20 @@
 #include "nextion.h"
 #include "logging.h"
 
+// MPU6050 sampled by the sensor into its 1 KB FIFO at IMU_ODR_HZ. service()
+// runs as a low-priority task and drains whatever has accumulated in short
+// burst reads, so no loop iteration waits on a full 14-register read per
+// sample. Each sample is logged raw with a timestamp reconstructed from the
+// FIFO depth and fed to the vehicle state estimator (vehicle_state.h).
 class MpuController {
 private:
-  Adafruit_MPU6050 mpu;
+  Adafruit_MPU6050 &mpu;
+  bool     ready = false;
+  uint32_t overflows = 0;  // FIFO overruns since begin(), each loses the backlog
+  void resetFifo();
 public:
-  MpuController(Adafruit_MPU6050 mpu);
+  MpuController(Adafruit_MPU6050 &mpu);
   bool begin();
-  void logTelemetry();
-};
\ No newline at end of file
+  void service(bool log = true);  // log = false drains without records, still feeds the estimator
+  uint32_t fifoOverflows() const { return overflows; }
+};
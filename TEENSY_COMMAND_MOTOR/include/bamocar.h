@@ -1,18 +1,30 @@
 #pragma once
 #include "config.h"
+#include "bamocar_cmd.h"
+#include "can_bus.h"
 
-void requestStatusCyclic(uint8_t interval_ms);
-void requestErrorsCyclic(uint8_t interval_ms);
-void requestStatusOnce();
-void requestSpeedCyclic(uint8_t interval_ms);
-void requestCurrentCyclic(uint8_t interval_ms);
-void requestTempsCyclic(uint8_t interval_ms);
-void requestDCBusOnce();
-void clearErrors();
-void enableDrive();
-void disableDrive();
-void sendTorqueCommand(int16_t torqueValue);
-void configureCanTimeout(uint16_t ms);
-void sendCAN(const CAN_message_t &msg);
-void readCanMessages();
+// Every send returns false when the TX queue is full (back-pressure, see
+// canBusStats()) instead of dropping the frame silently. Torque commands
+// use the inverter bus's reserved mailbox (CAN_TORQUE_MB).
+namespace bcmd {
+bool send(const Frame &f);
+uint8_t sendBatch(const Frame *frames, uint8_t count);  // returns frames queued
+}
+
+bool requestStatusCyclic(uint8_t interval_ms);
+bool requestErrorsCyclic(uint8_t interval_ms);
+bool requestStatusOnce();
+bool requestSpeedCyclic(uint8_t interval_ms);
+bool requestCurrentCyclic(uint8_t interval_ms);
+bool requestTempsCyclic(uint8_t interval_ms);
+bool requestRegisterCyclic(uint8_t reg, uint8_t interval_ms);
+bool requestDCBusOnce();
+bool clearErrors();
+bool enableDrive();   // enable frame only; send disableDrive() (lock) first
+bool disableDrive();
+bool sendTorqueCommand(int16_t torqueValue);
+bool configureCanTimeout(uint16_t ms);
+bool sendCAN(const CAN_message_t &msg);
+void bamocarBegin();  // routes BAMOCAR_TX_ID; call before canBusBegin()
+uint16_t bamocarRxCount(uint8_t reg);  // frames decoded for reg (wraps)
 void bamocarErrorDescription(uint32_t errorWord, char *buf, size_t len);
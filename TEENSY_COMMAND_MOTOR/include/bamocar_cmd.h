@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include "bamocar_registers.h"
+
+// Typed BAMOCAR command frames (Teensy → BAMOCAR_RX_ID).
+//
+// Every command is the register id plus a 16-bit little-endian value, so a
+// Frame is three bytes built at compile time where the value is constant:
+//
+//   bcmd::send(bcmd::cmd<REG_TORQUE_COMMAND>(torque));
+//   bcmd::send(bcmd::request(REG_STATUS, 100));
+//
+// Only registers with a Command<> specialisation can be written; anything
+// else is a compile error. Host-safe: no Arduino dependencies.
+
+namespace bcmd {
+
+struct Frame {
+  uint8_t reg;
+  uint8_t lo;
+  uint8_t hi;
+};
+
+enum DriveMode : uint8_t {
+  DRIVE_ENABLE = 0x00,
+  DRIVE_LOCK   = 0x04,
+};
+
+// Value type per writable register; arity 0 means no value.
+template <uint8_t REG> struct Command;
+template <> struct Command<REG_TORQUE_COMMAND> { typedef int16_t   value_t; static constexpr int arity = 1; };
+template <> struct Command<REG_CAN_TIMEOUT>    { typedef uint16_t  value_t; static constexpr int arity = 1; };
+template <> struct Command<REG_DRIVE_COMMAND>  { typedef DriveMode value_t; static constexpr int arity = 1; };
+template <> struct Command<REG_CLEAR_ERRORS>   { typedef uint16_t  value_t; static constexpr int arity = 0; };
+
+template <uint8_t REG>
+constexpr Frame cmd(typename Command<REG>::value_t value) {
+  static_assert(Command<REG>::arity == 1, "register takes no value, use cmd<REG>()");
+  return Frame{ REG, (uint8_t)((uint16_t)value & 0xFF), (uint8_t)((uint16_t)value >> 8) };
+}
+
+template <uint8_t REG>
+constexpr Frame cmd() {
+  static_assert(Command<REG>::arity == 0, "register needs a value");
+  return Frame{ REG, 0x00, 0x00 };
+}
+
+// Transmit request for reg: every interval_ms, or once when interval_ms is 0.
+// The interval is one byte on the wire: 1..BAMOCAR_CYCLIC_MAX_MS, and
+// BAMOCAR_CYCLIC_STOP ends a cyclic transmission.
+#define BAMOCAR_CYCLIC_MAX_MS 254
+#define BAMOCAR_CYCLIC_STOP   0xFF
+
+constexpr Frame request(uint8_t reg, uint8_t interval_ms = 0) {
+  return Frame{ REG_TRANSMIT_REQUEST, reg, interval_ms };
+}
+
+}  // namespace bcmd
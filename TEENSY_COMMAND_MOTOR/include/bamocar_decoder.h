@@ -0,0 +1,135 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "bamocar_registers.h"
+#include "temp_converters.h"
+
+// Table-driven decoder for BAMOCAR 0x181 response frames.
+// Frame layout: buf[0] = register id, buf[1..width] = little-endian value.
+// No Arduino dependencies so host tools can share it with the firmware.
+
+// ---------- Decoded state ----------
+// One field per row in BAMOCAR_REGISTERS.
+struct BamocarState {
+  int16_t  statusWord;
+  int16_t  rpmFeedback;    // N_ACT, normalised: 32767 = RPM_MAX
+  int16_t  actualCurrent;  // I_ACT, normalised to IMAX
+  float    motorTemp;      // °C
+  float    inverterTemp;   // °C (IGBT)
+  float    dcBusVoltage;   // V
+  uint32_t errorWord;
+  int16_t  torqueActual;   // M_OUT, normalised like REG_TORQUE_COMMAND
+  int16_t  power;          // P_MOTOR, raw
+};
+
+// ---------- Register descriptors ----------
+enum BamocarFieldType : uint8_t { BF_I16, BF_U16, BF_U32, BF_F32 };
+
+struct BamocarRegister {
+  uint8_t     reg;
+  const char *name;
+  uint8_t     width;     // value bytes after the register id (2 or 4)
+  bool        isSigned;
+  uint8_t     type;      // BamocarFieldType of the target field
+  uint16_t    offset;    // offsetof(BamocarState, <field>)
+  float       scale;     // BF_F32 only: value = raw * scale
+  float     (*convert)(uint16_t raw);  // BF_F32 only: overrides scale
+};
+
+#define BAMOCAR_FIELD(f) offsetof(BamocarState, f)
+
+// Supporting a new register is one row here plus its BamocarState field.
+static constexpr BamocarRegister BAMOCAR_REGISTERS[] = {
+  // reg                 name            width signed type    field                              scale               convert
+  { REG_STATUS,          "status",       2,    true,  BF_I16, BAMOCAR_FIELD(statusWord),         1.0f,               nullptr },
+  { REG_SPEED_ACTUAL,    "rpm",          2,    true,  BF_I16, BAMOCAR_FIELD(rpmFeedback),        1.0f,               nullptr },
+  { REG_CURRENT_ACTUAL,  "current",      2,    true,  BF_I16, BAMOCAR_FIELD(actualCurrent),      1.0f,               nullptr },
+  { REG_TEMP_MOTOR,      "motor_temp",   2,    false, BF_F32, BAMOCAR_FIELD(motorTemp),          1.0f,               motorADCToTemp },
+  { REG_TEMP_INVERTER,   "igbt_temp",    2,    false, BF_F32, BAMOCAR_FIELD(inverterTemp),       1.0f,               igbtADCToTemp },
+  { REG_DC_BUS_VOLTAGE,  "dcbus",        2,    false, BF_F32, BAMOCAR_FIELD(dcBusVoltage),       1.0f / 31.5848f,    nullptr },  // per BAMOCAR FAQ
+  { REG_ERROR_WORD,      "error_word",   2,    false, BF_U32, BAMOCAR_FIELD(errorWord),          1.0f,               nullptr },
+  { REG_TORQUE_ACTUAL,   "torque_act",   2,    true,  BF_I16, BAMOCAR_FIELD(torqueActual),       1.0f,               nullptr },
+  { REG_POWER,           "power",        2,    true,  BF_I16, BAMOCAR_FIELD(power),              1.0f,               nullptr },
+};
+
+static constexpr size_t BAMOCAR_REGISTER_COUNT = sizeof(BAMOCAR_REGISTERS) / sizeof(BAMOCAR_REGISTERS[0]);
+
+// ---------- Error word bits (RegID 0x8F, BAMOCAR-PG-D3 Manual) ----------
+static constexpr const char *BAMOCAR_ERROR_NAMES[16] = {
+  "BADPARAS",     // bit 0  - Parameter damaged
+  "POWERFAULT",   // bit 1  - Hardware error
+  "RFE",          // bit 2  - Safety circuit faulty
+  "BUS TIMEOUT",  // bit 3  - CAN timeout exceeded
+  "FEEDBACK",     // bit 4  - Bad/wrong encoder signal
+  "POWERVOLTAGE", // bit 5  - Power voltage missing
+  "MOTORTEMP",    // bit 6  - Engine temperature too high
+  "DEVICETEMP",   // bit 7  - Unit temperature too high
+  "OVERVOLTAGE",  // bit 8  - Overvoltage
+  "I_PEAK",       // bit 9  - Overcurrent
+  "RACEAWAY",     // bit 10 - Spinning
+  "USER",         // bit 11 - User error selection
+  "",             // bit 12 - (unmapped)
+  "",             // bit 13 - (unmapped)
+  "HW_ERR",       // bit 14 - Current measurement error
+  "BALLAST"       // bit 15 - Ballast circuit overloaded
+};
+
+// ---------- O(1) lookup ----------
+// 256-entry jump table built at compile time: slot[reg] = row index + 1,
+// 0 for registers the table doesn't know.
+struct BamocarRegisterIndex {
+  uint8_t slot[256];
+};
+
+static constexpr BamocarRegisterIndex bamocarMakeIndex() {
+  BamocarRegisterIndex idx = {};
+  for (size_t i = 0; i < BAMOCAR_REGISTER_COUNT; i++) {
+    idx.slot[BAMOCAR_REGISTERS[i].reg] = (uint8_t)(i + 1);
+  }
+  return idx;
+}
+
+static constexpr BamocarRegisterIndex BAMOCAR_REGISTER_INDEX = bamocarMakeIndex();
+
+inline const BamocarRegister *bamocarRegister(uint8_t reg) {
+  uint8_t slot = BAMOCAR_REGISTER_INDEX.slot[reg];
+  return slot ? &BAMOCAR_REGISTERS[slot - 1] : nullptr;
+}
+
+// ---------- Decode ----------
+inline int32_t bamocarRaw(const BamocarRegister &r, const uint8_t *buf) {
+  uint32_t raw = buf[1] | (buf[2] << 8);
+  if (r.width == 4) raw |= ((uint32_t)buf[3] << 16) | ((uint32_t)buf[4] << 24);
+  if (r.isSigned && r.width == 2) return (int16_t)raw;
+  return (int32_t)raw;
+}
+
+// Decodes one response frame into state. Returns the matching descriptor,
+// or nullptr if the register is unknown or the frame is too short.
+inline const BamocarRegister *bamocarDecode(const uint8_t *buf, uint8_t len, BamocarState &state) {
+  if (len < 1) return nullptr;
+  const BamocarRegister *r = bamocarRegister(buf[0]);
+  if (!r || len < 1 + r->width) return nullptr;
+
+  int32_t raw = bamocarRaw(*r, buf);
+  uint8_t *field = (uint8_t *)&state + r->offset;
+  switch (r->type) {
+    case BF_I16: *(int16_t *)field  = (int16_t)raw;  break;
+    case BF_U16: *(uint16_t *)field = (uint16_t)raw; break;
+    case BF_U32: *(uint32_t *)field = (uint32_t)raw; break;
+    case BF_F32: *(float *)field = r->convert ? r->convert((uint16_t)raw) : raw * r->scale; break;
+  }
+  return r;
+}
+
+// Reads a decoded field back as a float, e.g. for time-series output.
+inline float bamocarValue(const BamocarRegister &r, const BamocarState &state) {
+  const uint8_t *field = (const uint8_t *)&state + r.offset;
+  switch (r.type) {
+    case BF_I16: return *(const int16_t *)field;
+    case BF_U16: return *(const uint16_t *)field;
+    case BF_U32: return (float)*(const uint32_t *)field;
+    case BF_F32: return *(const float *)field;
+  }
+  return 0.0f;
+}
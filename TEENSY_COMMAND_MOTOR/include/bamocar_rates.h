@@ -0,0 +1,35 @@
+#pragma once
+#include "config.h"
+
+// Cyclic transmit-request manager for the BAMOCAR telemetry registers.
+//
+// Every RATE_TICK_MS it picks an interval per register: the stream's idle
+// or driving interval, and for the temperatures something between slow
+// and fast depending on how close they are to derating. Then it doubles
+// the least important intervals until the replies plus the torque frames
+// fit in RATE_BUDGET_PERCENT of the inverter bus.
+//
+// A REG_TRANSMIT_REQUEST goes out only when a stream's interval changes.
+// Faster intervals apply at once. Slower ones wait RATE_SLOWDOWN_HOLD_MS
+// after the last change, so a temperature near a band edge does not churn
+// requests. Each RATE_CHECK_MS window, the replies counted for every
+// stream (bamocarRxCount()) are compared with the requested rate. A
+// stream that delivers less than half gets its request sent again: a
+// BAMOCAR reset forgets every cyclic request.
+//
+// Ticked from the supervisor task. Nothing is requested before
+// bamocarRatesStart().
+
+struct BamocarRateInfo {
+  uint8_t  reg;
+  uint8_t  intervalMs;  // last accepted request, 0 = none yet
+  uint16_t received;    // replies in the last check window
+  uint16_t expected;    // RATE_CHECK_MS / intervalMs
+  uint16_t reissues;    // requests sent again after a short window
+};
+
+void bamocarRatesStart();  // (re)request every stream, e.g. after an enable handshake
+void bamocarRatesTick();
+uint8_t bamocarRateCount();
+BamocarRateInfo bamocarRateInfo(uint8_t i);
+uint8_t bamocarRateLoadPercent();  // planned inverter bus load
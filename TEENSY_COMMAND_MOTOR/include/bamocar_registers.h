@@ -13,3 +13,5 @@
 #define REG_CAN_TIMEOUT      0xD0
 #define REG_DRIVE_COMMAND    0x51
 #define REG_TORQUE_COMMAND   0x90
+#define REG_TORQUE_ACTUAL    0xA0
+#define REG_POWER            0xF6
@@ -0,0 +1,69 @@
+#pragma once
+#include "config.h"
+
+// The Teensy 4.1's three FlexCAN controllers behind one interface.
+//
+//   CAN_BUS_INVERTER  Can1  BAMOCAR only, so the torque frame never loses
+//                           arbitration to another node
+//   CAN_BUS_ACCU      Can2  BMS and AMS
+//   CAN_BUS_DASH      Can3  dashboard, unless Can3 carries CAN FD telemetry
+//                           (CAN_FD_TELEMETRY)
+//
+// Each bus has its own RX queue (filled from its FIFO interrupt, see
+// CAN_RX_MODE), its own table of ID routes and its own logging channel:
+// frames are logged with the controller number (C records with dir
+// RX2/TX3 etc., see logging.h) when the bus is in CAN_LOG_BUSES.
+//
+// On the inverter bus the torque frame has a TX mailbox of its own
+// (CAN_TORQUE_MB). Every other frame goes through the remaining TX
+// mailboxes and a software queue behind them, so a burst of requests can
+// never leave the torque frame without a free slot.
+enum CanBus : uint8_t {
+  CAN_BUS_INVERTER,
+  CAN_BUS_ACCU,
+#if !CAN_FD_TELEMETRY
+  CAN_BUS_DASH,
+#endif
+  CAN_BUS_COUNT,
+};
+
+struct CanRxFrame {
+  CAN_message_t msg;  // msg.timestamp is the FlexCAN hardware capture
+  uint32_t rxUs;      // micros() in the ISR
+  uint32_t rxMs;      // millis() in the ISR
+  uint32_t rxCycles;  // traceNow() in the ISR
+  uint8_t  bus;       // CanBus
+};
+
+// Called from canBusService() on the main thread, never from the ISR.
+typedef void (*CanRxHandler)(const CanRxFrame &f);
+
+// Worst-case bits on the wire for a standard-ID classic frame, stuff bits
+// and interframe space included.
+static inline uint32_t canFrameBits(uint8_t dlc) {
+  return 47 + 8u * dlc + (34 + 8u * dlc - 1) / 4;
+}
+
+struct CanBusStats {
+  uint32_t rxFrames;
+  uint32_t rxDropped;  // RX queue full or hardware FIFO overrun
+  uint32_t txFrames;
+  uint32_t txDropped;  // every mailbox and the TX queue full
+  uint32_t unrouted;   // received frames that matched no route
+};
+
+// Routes standard IDs first..last on a bus to handler. Register every route
+// before canBusBegin(): filtered buses (CAN_FILTER_BUSES) program them into
+// the FIFO filters. Returns false when the bus's table is full.
+bool canRoute(uint8_t bus, uint16_t first, uint16_t last, CanRxHandler handler);
+
+void canBusBegin();    // every controller: baud rate, mailboxes, filters, RX interrupt
+void canBusService();  // drains every RX queue through the routes, refills TX mailboxes
+
+// Both return false (and count the frame) when it cannot be queued; callers
+// in loop() and the timer task may use them. Frames are logged on success.
+bool canWrite(uint8_t bus, const CAN_message_t &msg);
+bool canWriteTorque(const CAN_message_t &msg);  // CAN_TORQUE_MB on the inverter bus
+
+CanBusStats canBusStats(uint8_t bus);  // consistent copy
+uint8_t canBusNumber(uint8_t bus);  // FlexCAN controller, 1..3
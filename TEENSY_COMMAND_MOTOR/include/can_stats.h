@@ -0,0 +1,58 @@
+#pragma once
+#include "can_bus.h"
+
+// Live statistics for every CAN bus, fed by can_bus.cpp's RX and TX paths.
+//
+// Per (bus, direction, ID): frames and the shortest and longest gap between
+// them, so rate and inter-arrival jitter can be read off each window. Per
+// bus: load from each frame's stuffed length (canStuffedBits(), data
+// included, not the worst case), averaged over the window and peaked over
+// CAN_STATS_PEAK_MS slices, plus busy-mailbox and dropped writes and the
+// FlexCAN error state (TEC/REC from ECR, error passive / bus off from ESR1,
+// bus-off events from the latched BOFFINT flag, polled from
+// canBusService()). IDs beyond the first CAN_STATS_IDS still count toward
+// the bus load but get no CI record.
+//
+// canStatsLog() writes one CB record per bus and one CI record per ID seen
+// in the window (logging.h), then starts a new window. Counters are updated
+// with interrupts masked: the torque frame is counted from the timer task.
+
+enum CanErrorState : uint8_t {
+  CAN_ERROR_ACTIVE,
+  CAN_ERROR_PASSIVE,
+  CAN_BUS_OFF,
+};
+
+struct CanLoadSummary {
+  uint16_t loadPermille;  // window average
+  uint16_t peakPermille;  // busiest CAN_STATS_PEAK_MS slice
+  uint32_t rxFrames;
+  uint32_t txFrames;
+  uint32_t txBusy;        // inverter bus: no free mailbox, frame waited in the TX queue
+  uint32_t txDropped;     // frames lost, see CanBusStats
+  uint8_t  tec;           // TEC, REC and state: worst seen in the window
+  uint8_t  rec;
+  uint8_t  state;         // CanErrorState
+  uint32_t busOffEvents;  // in the window
+};
+
+struct CanIdSummary {
+  uint32_t id;
+  uint8_t  bus;       // FlexCAN controller, 1..3
+  bool     tx;
+  bool     extended;
+  uint32_t frames;
+  uint32_t minGapUs;  // 0 when fewer than two frames
+  uint32_t maxGapUs;
+};
+
+uint16_t canStuffedBits(const CAN_message_t &msg);  // SOF to intermission
+
+void canStatsRx(const CanRxFrame &f);
+void canStatsTx(uint8_t bus, const CAN_message_t &msg, bool ok);  // ok: accepted by write()
+void canStatsTxBusy(uint8_t bus);  // no free mailbox, frame goes to the TX queue
+void canStatsPoll();               // error registers; call often, from canBusService()
+void canStatsLog();                // CB and CI records, then reset; from the stats task
+
+const CanLoadSummary &canStatsLast(uint8_t bus);  // CanBus, from the latest canStatsLog()
+uint8_t canStatsBusiest(CanIdSummary *out, uint8_t max);  // latest window, most frames first
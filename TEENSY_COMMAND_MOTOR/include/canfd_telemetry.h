@@ -0,0 +1,45 @@
+#pragma once
+#include "config.h"
+#include "logging.h"
+
+// Live telemetry on Can3 as CAN FD (CAN_FD_TELEMETRY in config.h).
+//
+// Every frame has id CANFD_TELEMETRY_ID, 64 data bytes and a switched
+// data-phase bitrate:
+//   [seq][count][reserved x2][LogRecord x count][zero padding]
+// The records are the binary log's (logging.h): every S and XR record as
+// it is logged, a B record every CANFD_STATE_PERIOD_US and an H record
+// every CANFD_HEADER_MS. A logger that writes them out back to back
+// starting at an H record has a binary log that tools/log_to_csv.py reads
+// (tools/canfd_logger.py does exactly that). seq counts frames, so a gap
+// shows lost ones. A partly filled frame goes out after CANFD_FLUSH_US.
+// Call everything from loop context; with CAN_FD_TELEMETRY 0 it all
+// compiles to nothing.
+
+#define CANFD_RECORDS_PER_FRAME 3
+
+struct CanFdFrame {
+  uint8_t   seq;
+  uint8_t   count;
+  uint16_t  reserved;
+  LogRecord rec[CANFD_RECORDS_PER_FRAME];
+};
+static_assert(sizeof(CanFdFrame) == 64, "CanFdFrame is one 64-byte CAN FD payload");
+
+struct CanFdStats {
+  uint32_t frames;
+  uint32_t dropped;  // TX queue full
+};
+
+#if CAN_FD_TELEMETRY
+void canFdBegin();
+void canFdRecord(const LogRecord &rec);
+void canFdState();    // B record (and H when due), every CANFD_STATE_PERIOD_US
+void canFdService();  // sends a partial frame once CANFD_FLUSH_US old
+const CanFdStats &canFdStats();
+#else
+static inline void canFdBegin() {}
+static inline void canFdRecord(const LogRecord &) {}
+static inline void canFdState() {}
+static inline void canFdService() {}
+#endif
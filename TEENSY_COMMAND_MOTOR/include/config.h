@@ -5,6 +5,7 @@
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
+#include "bamocar_decoder.h"
 
 // ---------- BAMOCAR IDs ----------
 #define BAMOCAR_RX_ID 0x201  // Teensy → Bamocar
@@ -15,7 +16,6 @@
 #define TORQUE_MAX 32767
 #define RPM_MAX    6000    // EMRAX 208: BAMOCAR inverter cap (1000 Hz, 10 pole pairs)
 #define CAN_TIMEOUT_MS 100  // if no messages received within this time, assume BAMOCAR offline
-#define TEMP_CAN_TIMEOUT_MS 500  // max time for temp of motor to be reported
 #define CAN_READ_DELAY_MS 50  // delay between CAN read cycles in main loop
 
 // ---------- APPS (pedal sensor) config ----------
@@ -37,39 +37,228 @@
 // Fault clears only when both sensors return below the dead band.
 #define PEDAL_PLAUSIBILITY_PERCENT 10
 
+// APPS acquisition. ANALOGREAD takes one blocking conversion per sensor per
+// torque tick. DMA samples both sensors continuously on ADC0/ADC1 hardware
+// timers; the torque task filters the newest DMA block (median-of-3, then
+// mean) and checks plausibility on every filtered sample pair.
+#define APPS_ACQ_ANALOGREAD 0
+#define APPS_ACQ_DMA        1
+#define APPS_ACQ_MODE       APPS_ACQ_DMA
+#define APPS_SAMPLE_HZ      8000   // per sensor
+#define APPS_DMA_BLOCK      16     // samples per DMA buffer: 2 ms at 8 kHz
+#define APPS_STALE_MS       10     // no fresh samples for this long = fault
+#if APPS_ACQ_MODE == APPS_ACQ_DMA
+#define APPS_FAULT_SAMPLES  8      // consecutive bad filtered pairs to latch (1 ms)
+#else
+#define APPS_FAULT_SAMPLES  3      // one pair per torque tick
+#endif
+
 // ---------- Button ----------
 #define BUTTON_PIN 2
 
 // ---------- Drive ----------
 #define DRIVE_HOLD_MS 3000  // ms the button must be held to enable/re-enable drive
 
+// Enable handshake (drive_sequence.h). Each step advances on the BAMOCAR's
+// answer; these are fallbacks when the answer never comes.
+#define SEQ_SPLASH_MS         800   // SD status shown before the start prompt
+#define SEQ_HEARTBEAT_MS      500   // status request while waiting on the driver
+#define SEQ_POLL_MS           300   // status request while waiting for BAMOCAR
+#define SEQ_ACK_TIMEOUT_MS    200   // per-step wait for the DC bus reply (the ack)
+#define SEQ_ACK_MIN_MS        5     // per-step dwell: the command may leave after the request
+#define SEQ_ENABLE_TIMEOUT_MS 1000  // wait for the ENA status bit before giving up
+#define BAMOCAR_STATUS_ENA    0x0001  // status word: drive enabled
+
+// ---------- BAMOCAR cyclic rates ----------
+// bamocar_rates.h: per-register intervals by drive state and temperature,
+// trimmed to a share of the inverter bus. Derate points: set to the
+// BAMOCAR's configured derating start (placeholders until calibrated).
+#define RATE_TICK_MS          100
+#define RATE_BUDGET_PERCENT   40      // of CAN_INVERTER_BAUD: BAMOCAR replies + torque frames
+#define RATE_SLOWDOWN_HOLD_MS 5000    // a stream only slows down this long after its last change
+#define RATE_CHECK_MS         1000    // arrival-rate check window
+#define MOTOR_TEMP_DERATE_C   100.0f
+#define IGBT_TEMP_DERATE_C    70.0f
+#define TEMP_DERATE_WINDOW_C  20.0f   // temps speed up linearly over this span below derate
+
+// ---------- Torque shaping ----------
+// torque_shaping.h, in the torque task: pedal map, then the lowest of the
+// speed, temperature and DC power limits, then the slew limit. Nm and
+// derate points are placeholders until calibrated on the dyno.
+#define TORQUE_MAP                { 0, 3, 8, 15, 24, 35, 47, 60, 73, 87, 100 }  // % of TORQUE_MAX at 0, 10 .. 100 % pedal
+#define TORQUE_RISE_MS            150      // fastest 0 to TORQUE_MAX
+#define TORQUE_FALL_MS            30       // fastest TORQUE_MAX to 0 on pedal release; faults cut at once
+#define TORQUE_NM_AT_MAX          140      // motor torque at TORQUE_MAX (BAMOCAR I_max)
+#define TORQUE_RPM_DERATE_START   5000     // linear to 0 at RPM_MAX
+#define TORQUE_MOTOR_TEMP_START_C 90       // linear to 0 at the END temperature
+#define TORQUE_MOTOR_TEMP_END_C   120
+#define TORQUE_IGBT_TEMP_START_C  60
+#define TORQUE_IGBT_TEMP_END_C    80
+#define TORQUE_POWER_LIMIT_W      80000    // accumulator output, FS rules
+#define TORQUE_DC_CURRENT_A       250      // accumulator fuse / BMS discharge limit
+#define TORQUE_EFFICIENCY_PERCENT 90       // DC to shaft, motor and inverter
+#define TORQUE_DCBUS_MIN_V        50       // below this, no reading yet: power limit only
+
 // ---------- Adafruit MPU -----------
 #define MPU_ACCEL_RANGE MPU6050_RANGE_8_G
 #define MPU_GYRO_RANGE MPU6050_RANGE_500_DEG
 #define MPU_FILTER_BW MPU6050_BAND_21_HZ
 
+// FIFO acquisition (MpuController::service). ODR must divide 1 kHz; the
+// 1 KB FIFO holds 85 samples (170 ms at 500 Hz) before it overflows.
+#define IMU_ODR_HZ              500
+#define IMU_PERIOD_US           (1000000 / IMU_ODR_HZ)
+#define IMU_SERVICE_PERIOD_US   10000   // ~5 samples per run
+#define IMU_MAX_SAMPLES_PER_RUN 8       // bounds one run to ~3 ms of I2C
+
+// ---------- Vehicle state ----------
+// vehicle_state.h: speed, longitudinal acceleration, yaw rate and drive
+// wheel slip, fusing the IMU with motor speed at IMU_ODR_HZ. Wheel speed
+// v = 2π × n × r_w / (60 × G) with n the motor RPM.
+#define VEHICLE_WHEEL_RADIUS_M 0.247f
+#define VEHICLE_GEAR_RATIO     5.25f
+#define IMU_FORWARD_AXIS       0       // accel index pointing forward: 0 x, 1 y, 2 z
+#define IMU_FORWARD_SIGN       1       // -1 when that axis points backwards
+#define IMU_YAW_AXIS           2       // gyro index of the vertical axis
+#define VSE_TAU_S              0.5f    // crossover: integrated accel below, wheel speed above
+#define VSE_SLIP_TAU_S         5.0f    // crossover while the drive wheels slip
+#define VSE_SLIP_LIMIT         0.10f   // |slip| above this: wheel speed distrusted
+#define VSE_MIN_SPEED_MS       1.0f    // slip denominator floor; below it with the motor stopped = standstill
+#define VSE_BIAS_TAU_S         2.0f    // accelerometer offset (mounting tilt) learnt at standstill
+#define VSE_ACCEL_TAU_S        0.02f   // low-pass of the acceleration output
+#define VSE_IMU_TIMEOUT_MS     50      // no IMU sample this long: wheel speed only
+
 // ---------- Logging ----------
 #define FILE_NAME_LEN 32
 
+// SD record format. CSV is human-readable; BINARY writes fixed-size
+// LogRecord structs (see logging.h) with no formatting cost in the loop.
+// Convert binary logs back to CSV with tools/log_to_csv.py.
+#define LOG_FORMAT_CSV    0
+#define LOG_FORMAT_BINARY 1
+#define LOG_FORMAT        LOG_FORMAT_CSV
+
+// Write buffer: LOG_SLOT_COUNT slots of LOG_SLOT_SIZE bytes (multiple of
+// 512). Full slots are committed from loop slack by logService().
+#define LOG_SLOT_SIZE        4096
+#define LOG_SLOT_COUNT       4
+#define LOG_SYNC_INTERVAL_MS 500   // directory-entry flush interval
+
+// Log files (logging.cpp): each is pre-allocated and erased, then trimmed
+// by logClose() or, after a power cut, at the next boot. The next index
+// lives in EEPROM so startup does not probe the card for a free name.
+#define LOG_PREALLOC_BYTES    (256ull << 20)  // ~3.5 h of CSV at full bus traffic
+#define LOG_INDEX_EEPROM_ADDR 0
+#define LOG_INDEX_MAX         9999            // CAN_log_0001 .. CAN_log_9999
+
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+#define LOG_FILE_EXT "bin"
+#else
+#define LOG_FILE_EXT "csv"
+#endif
+
+// ---------- Fault capture ----------
+// fault_capture.h: every CAN frame, raw APPS sample, IMU sample and S
+// record goes into a RAM ring; a BAMOCAR error, BAMOCAR offline or pedal
+// fault writes the window around it to CAN_log_NNNN_Fxx.bin. The ring must
+// hold CAPTURE_PRE_MS + CAPTURE_POST_MS at full traffic (~6 k records/s).
+// It sits in RAM2 (DMAMEM); with the optional PSRAM chip fitted,
+// CAPTURE_EXTMEM moves it there and leaves room for a longer ring.
+#define CAPTURE_ENABLED       1
+#define CAPTURE_EXTMEM        0
+#define CAPTURE_RING_RECORDS  16384    // 320 KB, power of two
+#define CAPTURE_PRE_MS        1000
+#define CAPTURE_POST_MS       250
+#define CAPTURE_MAX_FILES     99       // per log
+#define CAPTURE_WRITE_RECORDS 204      // per captureService() call, ~4 KB
+
+// ---------- Scheduler ----------
+// Torque/pedal runs from an IntervalTimer at a fixed rate; everything else
+// is a cooperative task ordered by priority (0 = highest), see scheduler.h.
+#define SCHED_MAX_TASKS       14
+#define TORQUE_PERIOD_US      2000     // 500 Hz torque task (timer ISR)
+#define TORQUE_DEADLINE_US    500
+#define SUPERVISOR_PERIOD_US  1000     // CAN RX drain, fault detection, button
+#define SNAPSHOT_PERIOD_US    20000    // S record logging
+#define TELEMETRY_PERIOD_US   50000    // TL_STATUS to the Wi-Fi bridge (20 Hz UI tick)
+#define DISPLAY_PERIOD_US     50000    // Nextion diff update, see NX_*_PERIOD_MS
+#define DCBUS_PERIOD_US       500000   // DC bus voltage request
+#define SCHED_STATS_PERIOD_US 1000000  // K/KH records, stats reset after each
+
+// ---------- Tracing ----------
+// DWT cycle-counter latency tracing (trace.h): pedal-to-CAN and BAMOCAR
+// request round trips, summarised into LT records by the stats task.
+#define TRACE_ENABLED 1
+
+// ---------- CAN RX ----------
+// POLL drains each controller's read() from canBusService().
+// INTERRUPT receives through the FlexCAN FIFO interrupt; frames are
+// timestamped in the ISR and queued per bus until canBusService() runs, so
+// blocking waits no longer lose frames.
+#define CAN_RX_POLL      0
+#define CAN_RX_INTERRUPT 1
+#define CAN_RX_MODE      CAN_RX_INTERRUPT
+#define CAN_RX_QUEUE_LEN 256   // per bus, power of two
+
+// ---------- CAN buses ----------
+// One controller per CanBus (can_bus.h). Masks are bits of CanBus.
+// Filtered buses receive only their routed IDs (hardware FIFO filters, at
+// most CAN_FIFO_FILTERS routes); the others receive and log everything.
+#define CAN_INVERTER_BAUD 500000
+#define CAN_ACCU_BAUD     500000   // BMS + AMS
+#define CAN_DASH_BAUD     500000
+#define CAN_LOG_BUSES     0x7      // all three
+#define CAN_FILTER_BUSES  0x1      // inverter: BAMOCAR_TX_ID only
+#define CAN_MAX_ROUTES    8        // per bus
+#define CAN_FIFO_FILTERS  8
+#define CAN_TX_QUEUE_LEN  32       // inverter bus, frames waiting for a mailbox, power of two
+#define CAN_TORQUE_MB     MB8      // lowest TX mailbox: wins ties against queued requests
+#define CAN_TX_MB_FIRST   MB9      // the rest of the inverter bus's TX mailboxes
+#define CAN_TX_MB_LAST    MB15
+#define CAN_STATS_IDS     64       // (bus, direction, ID) counters for the CI records
+#define CAN_STATS_PEAK_MS 10       // window of the peak load figure in the CB record
+
+// ---------- CAN FD telemetry ----------
+// Optional: Can3 runs as CAN FD and broadcasts the S and XR records plus
+// B (BAMOCAR state) records, three per 64-byte frame, at the data-phase
+// bitrate (canfd_telemetry.h). A classic CAN node on that bus would error
+// every FD frame, so Can3 then carries nothing else and CAN_BUS_DASH does
+// not exist; wire the dashboard to the accu bus instead.
+#define CAN_FD_TELEMETRY      0
+#define CANFD_ARB_BAUD        500000
+#define CANFD_DATA_BAUD       2000000  // 2-5 Mbps, limited by the transceiver and stub lengths
+#define CANFD_TELEMETRY_ID    0x700
+#define CANFD_FLUSH_US        5000     // longest a record waits for its frame to fill
+#define CANFD_STATE_PERIOD_US 10000    // B record
+#define CANFD_HEADER_MS       1000     // H record, so a logger can start mid-run
+
+// ---------- Telemetry link ----------
+// COBS-framed binary telemetry to the Wi-Fi bridge (telemetry_link.h) on
+// TX2 (pin 8). TX ring and extra UART buffer sizes in bytes; the ring must
+// be a power of two.
+#define TELEMETRY_SERIAL        Serial2
+#define TELEMETRY_BAUD          460800
+#define TELEMETRY_TX_RING       2048
+#define TELEMETRY_TX_SERIAL_MEM 256
+
 // ---------- CAN bus ----------
-extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can1;
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can1;  // CAN_BUS_INVERTER
+extern FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16> Can2;  // CAN_BUS_ACCU
+#if CAN_FD_TELEMETRY
+extern FlexCAN_T4FD<CAN3, RX_SIZE_256, TX_SIZE_64> CanFD;
+#else
+extern FlexCAN_T4<CAN3, RX_SIZE_256, TX_SIZE_16> Can3;  // CAN_BUS_DASH
+#endif
 extern const int chipSelect;
 
 // ---------- Globals ----------
-extern File logFile;
-extern int currentStep;
+extern int8_t currentStep;
 extern int16_t currentTorque;
 extern uint32_t lastTorqueSend;
 extern bool bamocarOnline;
-extern int rpmFeedback;
-extern int statusWord;
-extern uint32_t bamocarErrorWord;
-extern int16_t actualCurrent;
-extern float motorTemp;
-extern float inverterTemp;
-extern float dcBusVoltage;
-extern int apps1Raw;
-extern int apps2Raw;
+extern BamocarState bamocar;  // decoded 0x181 telemetry, see bamocar_decoder.h
+extern int16_t apps1Raw;
+extern int16_t apps2Raw;
 extern bool pedalFault;
 extern bool driveEnabled;
 extern uint32_t lastBAMOCARRx;
@@ -0,0 +1,31 @@
+#pragma once
+#include "config.h"
+
+// Non-blocking boot / re-enable handshake (startup steps 1-7).
+//
+// Each state sends its command plus a one-shot DC bus request, then
+// advances as soon as the BAMOCAR answers it (or, for the enable, sets the
+// ENA status bit) instead of sleeping. SEQ_ACK_TIMEOUT_MS is only the fallback
+// if an answer never arrives. Ticked from the supervisor task, so CAN RX,
+// logging and the torque watchdog keep running throughout.
+
+enum DriveSeqState : uint8_t {
+  SEQ_SPLASH,          // SD status on screen
+  SEQ_WAIT_START,      // step 1 prompt: press to start
+  SEQ_WAIT_ONLINE,     // cyclic requests sent, polling status
+  SEQ_DC_BUS,          // step 2
+  SEQ_CLEAR_ERRORS,    // step 3
+  SEQ_CAN_TIMEOUT,     // step 4
+  SEQ_WAIT_HOLD,       // step 5 prompt: hold to enable
+  SEQ_ENABLE_CLEAR,    // step 5: clear errors before enabling
+  SEQ_ENABLE_LOCK,     // step 5: lock frame, wait for ack
+  SEQ_WAIT_ENABLED,    // step 5: enable frame, wait for ENA bit
+  SEQ_RELEASE_PEDAL,   // step 6: zero torque, wait for pedal at rest
+  SEQ_RUNNING,         // step 7: torque control
+};
+
+void driveSeqBegin();       // start the boot sequence (from setup)
+void driveSeqReenable();    // start the re-enable sequence after a 3 s hold
+void driveSeqTick();        // advance; call every supervisor pass
+bool driveSeqActive();      // true while a handshake is in progress
+DriveSeqState driveSeqState();
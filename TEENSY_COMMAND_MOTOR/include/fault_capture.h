@@ -0,0 +1,51 @@
+#pragma once
+#include "config.h"
+#include "logging.h"
+
+// Pre-trigger capture of everything at full rate (CAPTURE_ENABLED in
+// config.h), for the second before a fault that the 20 ms S records and
+// the main log cannot resolve.
+//
+// Every CAN frame on every bus (logged buses or not), every raw APPS
+// sample pair, every IMU sample and every S record goes into a ring of
+// CAPTURE_RING_RECORDS binary log records (logging.h). captureTrigger()
+// adds an F record and arms the capture; CAPTURE_POST_MS later the ring is
+// frozen and captureService() writes the records from CAPTURE_PRE_MS
+// before the trigger onwards to <log>_Fxx.bin, a binary log that
+// tools/log_to_csv.py reads like any other. Records added while the ring
+// is frozen are lost and counted in the file's trailer; triggers during a
+// capture only add their F record. The main log gets an FT record naming
+// the capture file.
+//
+// captureAdd() and the record helpers may be called from any context,
+// including the timer task. With CAPTURE_ENABLED 0 it all compiles to
+// nothing.
+
+enum CaptureCause : uint8_t {
+  CAPTURE_BAMOCAR_ERROR = 1,  // detail = error word
+  CAPTURE_BAMOCAR_OFFLINE,    // detail = ms since the last BAMOCAR frame
+  CAPTURE_PEDAL_FAULT,        // detail = apps1Raw << 16 | apps2Raw
+};
+
+struct CaptureStats {
+  uint8_t  files;    // written for the current log
+  uint32_t missed;   // records added while frozen, all captures
+  uint32_t skipped;  // triggers with no file: capture running, card error, CAPTURE_MAX_FILES
+};
+
+#if CAPTURE_ENABLED
+void captureBegin(const char *logName);  // after logOpenNext(); no capture without a card
+void captureAdd(const LogRecord &rec);
+void captureCan(const CAN_message_t &msg, bool tx, uint8_t bus, uint32_t tUs);  // bus: CanBus
+void capturePedal(const volatile uint16_t *s1, const volatile uint16_t *s2, uint16_t n);
+void captureTrigger(uint8_t cause, uint32_t detail);
+void captureService();  // slack task: freezes the ring after the post window, writes the file
+const CaptureStats &captureStats();
+#else
+static inline void captureBegin(const char *) {}
+static inline void captureAdd(const LogRecord &) {}
+static inline void captureCan(const CAN_message_t &, bool, uint8_t, uint32_t) {}
+static inline void capturePedal(const volatile uint16_t *, const volatile uint16_t *, uint16_t) {}
+static inline void captureTrigger(uint8_t, uint32_t) {}
+static inline void captureService() {}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+// Scoped interrupt lock for data shared between loop() and the scheduler's
+// timer task. Saves and restores PRIMASK so it nests correctly and is safe
+// to use inside an ISR. Keep the guarded region short (a memcpy, a mailbox
+// write), never around SD or I2C traffic.
+class IrqGuard {
+public:
+#if defined(__arm__)
+  IrqGuard() { __asm__ volatile("mrs %0, primask\n\tcpsid i" : "=r"(_primask) :: "memory"); }
+  ~IrqGuard() { __asm__ volatile("msr primask, %0" :: "r"(_primask) : "memory"); }
+#else
+  IrqGuard() : _primask(0) {}
+  ~IrqGuard() {}
+#endif
+  IrqGuard(const IrqGuard &) = delete;
+  IrqGuard &operator=(const IrqGuard &) = delete;
+
+private:
+  uint32_t _primask;
+};
+
+// True when called from an exception/interrupt handler (IPSR != 0).
+inline bool inInterrupt() {
+#if defined(__arm__)
+  uint32_t ipsr;
+  __asm__ volatile("mrs %0, ipsr" : "=r"(ipsr));
+  return ipsr != 0;
+#else
+  return false;
+#endif
+}
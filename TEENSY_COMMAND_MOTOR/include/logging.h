@@ -1,17 +1,100 @@
 #pragma once
 #include "config.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "can_stats.h"
 
 // Schema
 // CAN frame:    C,<ms>,<dir>,<id_hex>,<len>,<b0_hex>,...,<b7_hex>
 // Sensor snap:  S,<ms>,<apps1_raw>,<apps2_raw>,<pedal_fault>,<torque_cmd>,<rpm>,<dcbus_dV>
+// IMU sample:   XR,<ms>,<accel_x>,<accel_y>,<accel_z>,<gyro_x>,<gyro_y>,<gyro_z>   (raw LSB, see LOG_IMU_*)
+// Task stats:   K,<ms>,<task>,<runs>,<overruns>,<max_jitter_us>,<max_run_us>
+// Task jitter:  KH,<ms>,<task>,<h0>,...,<h5>   (counts per schedHistEdges() bucket)
+// Latency:      LT,<ms>,<path>,<count>,<min_us>,<avg_us>,<p99_us>,<max_us>   (path: TracePath, µs to 0.1)
+// BAMOCAR:      B,<ms>,<flags>,<error_hex>,<rpm>,<current>,<torque_act>,<power>,<motor_temp_dC>,<igbt_temp_dC>
+//               (CAN FD telemetry only; flags are TL_FLAG_*, values as in BamocarState)
+// Bus load:     CB,<ms>,<bus>,<load_pct>,<peak_pct>,<rx>,<tx>,<tx_busy>,<tx_dropped>,<tec>,<rec>,<state>,<bus_off>
+//               (pct to 0.1, state is CanErrorState; see can_stats.h)
+// Frame rate:   CI,<ms>,<dir>,<id_hex>,<frames>,<min_gap_us>,<max_gap_us>   (dir as in C records)
+// Fault:        FT,<ms>,<cause>,<detail_hex>,<capture>
+//               (cause is CaptureCause, capture = Fxx file number or 0; see fault_capture.h)
+// APPS sample:  AP,<ms>,<apps1_raw>,<apps2_raw>   (capture files only, every ADC sample pair)
+// Trailer:      # end: <bytes> bytes, <dropped> dropped, closed|recovered
+//               (last line; bytes = file length before it, see logClose())
+// dir is RX/TX on Can1 (inverter bus) and RX2/TX2, RX3/TX3 on the others.
 // id and bytes are uppercase hex without 0x prefix.
 // Unused CAN byte fields are empty (fixed 13-column records).
 // dcbus_dV = dcBusVoltage * 10, integer decivolts.
 // pedal_fault = 1 if APPS plausibility fault active, else 0.
 
-char* generateFilename();
+// ---------- Binary records (LOG_FORMAT_BINARY) ----------
+// Every record is sizeof(LogRecord) bytes, little-endian, written back to
+// back. The first record in a file is always LOG_REC_HEADER.
+#define LOG_REC_HEADER 'H'  // len = LOG_BIN_VERSION, id = sizeof(LogRecord), s16[4..5] = IMU scales
+#define LOG_REC_TX     'T'  // C record, dir TX: len = DLC, id, data[0..7], data[8] = bus (0 = 1)
+#define LOG_REC_RX     'R'  // C record, dir RX: len = DLC, id, data[0..7], data[8] = bus (0 = 1)
+#define LOG_REC_SENSOR 'S'  // S record: len = pedal_fault, s16[0..4]
+#define LOG_REC_IMU    'X'  // XR record: s16[0..5] raw accel xyz, gyro xyz
+#define LOG_REC_TASK   'K'  // K record: len = task, id = overruns (sat), u32 = runs, max_jitter_us, max_run_us
+#define LOG_REC_JITTER 'k'  // KH record: len = task, u16[0..5] = histogram
+#define LOG_REC_LATENCY 'L' // LT record: len = path, id = count (sat), data = min, avg, p99, max as 24-bit 0.1 µs
+#define LOG_REC_BAMOCAR 'B' // B record, CAN FD only: len = flags, id = error word, s16[0..5]
+#define LOG_REC_CANLOAD 'U' // CB record: len = bus | state << 4, id = load ‰, u16[0..3] = peak ‰, rx, tx, tx_busy (sat),
+                            //   data[8..11] = TEC, REC, bus_off, tx_dropped (sat)
+#define LOG_REC_CANID   'I' // CI record: len = bus | 0x40 extended | 0x80 TX, id = frames (sat), u32 = CAN id, min/max gap µs
+#define LOG_REC_FAULT   'F' // FT record: len = cause, id = capture, u32[0] = detail
+#define LOG_REC_APPS    'P' // AP records: len = pairs (1..3), id = sample period µs, s16 = apps1, apps2 pairs;
+                            //   t_us is the first pair's
+#define LOG_REC_END     'E' // trailer: len = 1 if recovered, u32[0] = bytes before it, u32[1] = bytes dropped
+
+#define LOG_BIN_MAGIC   "CANLOG"
+#define LOG_BIN_VERSION 2  // 2: raw IMU samples (XR) replace scaled XL
+
+// IMU samples are the sensor's raw int16 counts. Scales follow the
+// configured ranges and are written to the file header (CSV comment line
+// or binary header record): accel LSB per g, gyro LSB per deg/s x10.
+#define LOG_IMU_ACCEL_LSB_PER_G     (16384 >> MPU_ACCEL_RANGE)
+#define LOG_IMU_GYRO_LSB_PER_DPS_X10 (1310 >> MPU_GYRO_RANGE)
+
+struct LogRecord {
+  uint32_t t_us;   // micros() when logged
+  uint8_t  type;   // LOG_REC_*
+  uint8_t  len;
+  uint16_t id;
+  union {
+    uint8_t data[12];
+    int16_t  s16[6];
+    uint16_t u16[6];
+    uint32_t u32[3];
+  };
+};
+static_assert(sizeof(LogRecord) == 20, "LogRecord layout is part of the file format");
+
+// Writer counters, see logService().
+struct LogStats {
+  uint32_t bytesWritten;
+  uint32_t bytesDropped;  // records refused because every slot was full
+  uint32_t writes;
+  uint32_t worstWriteUs;  // longest single SD write or sync call
+};
+
+// Log files. logOpenNext() first finishes the log a power cut left open,
+// then opens the next index; both open functions write the header.
+bool logOpenNext(char *name);    // name: FILE_NAME_LEN bytes, set to the file opened
+bool logOpen(const char *name);  // truncates an existing file
+void logClose();                 // flush, trailer, release the unused pre-allocation
 void logWriteHeader();
-void logCANFrame(const CAN_message_t &msg, const char *dir);
-void logSensor(int apps1Raw, int apps2Raw, bool fault, int16_t torque, int rpm, int dcbusDV);
-void logIMU(float ax, float ay, float az, float gx, float gy, float gz);
-void logFlush();
\ No newline at end of file
+LogRecord logHeaderRecord();  // LOG_REC_HEADER as written at the start of a binary file
+void logCANFrame(const CAN_message_t &msg, const char *dir, uint8_t bus = 1);  // bus: FlexCAN controller
+LogRecord logCanRecord(const CAN_message_t &msg, bool tx, uint8_t bus);       // as logCANFrame() writes it
+void logFault(uint8_t cause, uint32_t detail, uint8_t capture);
+LogRecord logFaultRecord(uint8_t cause, uint32_t detail, uint8_t capture);
+void logSensor(int16_t apps1Raw, int16_t apps2Raw, bool fault, int16_t torque, int16_t rpm, int dcbusDV);
+void logIMU(uint32_t tUs, const int16_t raw[6]);  // ax, ay, az, gx, gy, gz
+void logSchedStats(uint8_t task, const TaskStats &stats);
+void logTrace(uint8_t path, const TraceSummary &summary);
+void logCanLoad(uint8_t bus, const CanLoadSummary &summary);  // bus: FlexCAN controller
+void logCanId(const CanIdSummary &summary);
+void logService();
+void logFlush();
+const LogStats &logStats();
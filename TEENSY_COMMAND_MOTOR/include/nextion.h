@@ -5,16 +5,41 @@
 #define NEXTION_SERIAL Serial7
 #define NEXTION_BAUD   115200
 
+// Output path: commands queue into a TX ring that nextionService() moves
+// into the Serial7 TX buffer without blocking. Both sizes in bytes;
+// NEXTION_TX_RING must be a power of two.
+#define NEXTION_TX_RING       1024
+#define NEXTION_TX_SERIAL_MEM 256
+#define NEXTION_SHADOW_SLOTS  16   // components tracked by the diff cache
+
+// Drive page refresh period per component (ms). Values are only re-sent
+// when they changed; nextionUpdateDrive() should run at least this often.
+#define NX_SPEED_PERIOD_MS  100
+#define NX_RPM_PERIOD_MS    100
+#define NX_TORQUE_PERIOD_MS 100
+#define NX_DCBUS_PERIOD_MS  500
+#define NX_FAULT_PERIOD_MS  50
+#define NX_STATE_PERIOD_MS  50
+#define NX_TEMP_PERIOD_MS   1000
+
 // ---- Page IDs ----
 #define NX_PAGE_BOOT   0
 #define NX_PAGE_DRIVE  1
+#define NX_PAGE_DEBUG  2
+#define NX_PAGE_CAN    3
+
+// Debug pages: latency (trace.h) on page 2 with t_lat0-3, CAN bus
+// statistics (can_stats.h) on page 3 with t_can1-3 and t_id0-2. Both need
+// `sendme` in each page's Preinitialize Event so page changes made on the
+// display are reported back.
+#define NX_DEBUG_PAGE  0
 
 // ---- Boot page component names (from Nextion Editor) ----
 #define NX_BOOT_STATUS "t_status"   // text: current phase
 #define NX_BOOT_DETAIL "t_detail"   // text: secondary detail
 
 // ---- Drive page component names ----
-#define NX_DRIVE_SPEED  "n_speed"   // number: vehicle speed, integer km/h
+#define NX_DRIVE_SPEED  "n_speed"   // number: estimated vehicle speed (vehicle_state.h), integer km/h
 #define NX_DRIVE_RPM    "n_rpm"     // number: motor RPM
 #define NX_DRIVE_TORQUE "n_torque"  // number: torque command, 0-100%
 #define NX_DRIVE_DCBUS  "n_dcbus"   // number: DC bus voltage, whole volts
@@ -23,9 +48,41 @@
 #define NX_DRIVE_MTEMP  "n_mtemp"   // number: motor temperature, °C
 #define NX_DRIVE_ITEMP  "n_itemp"   // number: inverter temperature, °C
 
+// ---- Debug page component names ----
+#define NX_DEBUG_LAT0   "t_lat0"    // text: "<path> avg/p99/max us"
+#define NX_DEBUG_LAT1   "t_lat1"
+#define NX_DEBUG_LAT2   "t_lat2"
+#define NX_DEBUG_LAT3   "t_lat3"
+
+// ---- CAN page component names ----
+#define NX_CAN_BUS1     "t_can1"    // text: "CAN1 <load>% pk <peak>% T<tec> R<rec> <state>"
+#define NX_CAN_BUS2     "t_can2"
+#define NX_CAN_BUS3     "t_can3"
+#define NX_CAN_ID0      "t_id0"     // text: "<dir> <id> <n>/s gap <min>-<max>us", busiest first
+#define NX_CAN_ID1      "t_id1"
+#define NX_CAN_ID2      "t_id2"
+
+struct NextionStats {
+  uint32_t commands;   // queued to the TX ring
+  uint32_t bytes;      // queued to the TX ring, terminators included
+  uint32_t skipped;    // writes suppressed by the shadow cache
+  uint32_t dropped;    // TX ring full
+  uint32_t errors;     // error return codes (bkcmd=2 sends no others)
+  uint8_t  lastError;  // most recent error code, e.g. 0x1A invalid variable
+};
+
 void nextionBegin();
+void nextionService();  // drain TX ring, parse return codes; call from loop slack
+const NextionStats &nextionStats();
 void nextionPage(uint8_t page);
 void nextionText(const char *component, const char *text);
 void nextionNum(const char *component, int value);
 void nextionBootStatus(const char *phase, const char *detail = "");
-void nextionUpdateDrive();
+void nextionFormatHoldBar(char *buf, uint32_t elapsed, uint32_t total);  // buf ≥13 bytes
+void nextionHoldBar(const char *component, uint32_t elapsed, uint32_t total);
+void nextionUpdateDrive(const char *state = nullptr);  // state overrides t_drive ON/OFF
+uint8_t nextionCurrentPage();  // last page set here or reported by the display
+#if NX_DEBUG_PAGE
+void nextionUpdateDebug();
+void nextionUpdateCan();
+#endif
@@ -1,4 +1,8 @@
 #pragma once
 #include "config.h"
 
+void pedalBegin();             // start APPS acquisition (see APPS_ACQ_MODE)
+bool pedalSample();            // filter the newest samples into apps1Raw/apps2Raw; false if none
+void pedalFilter(const volatile uint16_t *s1, const volatile uint16_t *s2, uint16_t n);  // one block, as pedalSample()
+bool pedalAtRest();
 void updateTorqueFromPedal();
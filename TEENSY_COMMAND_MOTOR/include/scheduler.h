@@ -0,0 +1,41 @@
+#pragma once
+#include "config.h"
+
+// Fixed-rate task scheduler.
+//
+// One timer task runs straight from an IntervalTimer interrupt, so its
+// period is exact no matter what the loop is doing (torque/pedal).
+// Cooperative tasks run from schedRun() in loop(): the highest-priority
+// released task goes first, and period-0 tasks fill the remaining slack.
+// Everything the timer task touches must be safe to call from an ISR.
+
+typedef void (*TaskFn)();
+
+#define SCHED_HIST_BUCKETS 6  // jitter histogram, see schedHistEdges()
+
+struct TaskStats {
+  const char *name;
+  uint32_t periodUs;     // 0 = background (slack) task
+  uint32_t deadlineUs;   // overrun if late + run time exceeds this
+  uint32_t runs;
+  uint32_t overruns;     // missed deadlines plus skipped releases
+  uint32_t maxJitterUs;  // worst release-to-start delay
+  uint32_t maxRunUs;
+  uint16_t hist[SCHED_HIST_BUCKETS];  // release-to-start delay counts
+};
+
+// priority: 0 is highest. Returns the task id, or -1 if the table is full.
+int8_t schedAddTask(const char *name, TaskFn fn, uint32_t periodUs,
+                    uint8_t priority, uint32_t deadlineUs);
+// Only one timer task is supported; it gets task id 0 if added first.
+int8_t schedAddTimerTask(const char *name, TaskFn fn, uint32_t periodUs,
+                         uint32_t deadlineUs);
+
+void schedBegin();  // arms the IntervalTimer and aligns all release times
+void schedRun();    // call repeatedly from loop()
+
+uint8_t schedTaskCount();
+const TaskStats &schedStats(uint8_t id);
+const uint32_t *schedHistEdges();  // upper bound (µs) of each bucket but the last
+void schedResetStats();
+void schedLogStats();  // writes one K and one KH record per task
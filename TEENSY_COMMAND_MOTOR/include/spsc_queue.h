@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring.
+// One side (typically an ISR) only calls push(), the other only pop().
+// N must be a power of two; one slot is kept empty to tell full from empty,
+// so capacity is N - 1.
+template <typename T, uint16_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  bool push(const T &item) {
+    uint16_t head = _head.load(std::memory_order_relaxed);
+    uint16_t next = (head + 1) & (N - 1);
+    if (next == _tail.load(std::memory_order_acquire)) return false;  // full
+    _items[head] = item;
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    uint16_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;  // empty
+    item = _items[tail];
+    _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size() const {
+    return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1);
+  }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  T _items[N];
+  std::atomic<uint16_t> _head{0};
+  std::atomic<uint16_t> _tail{0};
+};
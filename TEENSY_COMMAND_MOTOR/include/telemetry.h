@@ -0,0 +1,19 @@
+#pragma once
+#include "config.h"
+#include "telemetry_link.h"
+
+// Telemetry to the Wi-Fi bridge over TELEMETRY_SERIAL, framed as in
+// telemetry_link.h. Frames queue into a TX ring that telemetryService()
+// moves to the UART without blocking; a frame that does not fit is dropped
+// whole. Call everything from loop context.
+
+struct TelemetryStats {
+  uint32_t frames;   // queued to the TX ring
+  uint32_t dropped;  // TX ring full
+};
+
+void telemetryBegin();
+void telemetryStatus();                                      // one TL_STATUS snapshot
+void telemetryCanFrame(const CAN_message_t &msg, uint32_t rxMs);
+void telemetryService();                                     // drain TX ring; call from loop slack
+const TelemetryStats &telemetryStats();
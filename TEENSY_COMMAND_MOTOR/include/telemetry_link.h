@@ -0,0 +1,370 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Binary UART link from the car (Teensy) to the Wi-Fi bridge (UNO_ESP_WIFI).
+// No Arduino dependencies so the bridge and host tools can share it.
+//
+// Frame, before stuffing:
+//   [type][seq][payload ...][crc16 lo][crc16 hi]
+// COBS-encoded and terminated by one 0x00 byte, so a receiver that starts
+// mid-stream or drops bytes resynchronises on the next zero. The CRC is
+// CRC-16/CCITT-FALSE over type, seq and payload. seq counts every frame
+// the sender queued, so the receiver can count the ones it never saw.
+// Multi-byte fields are little-endian (both ends are).
+
+#define TL_MAX_PAYLOAD 32
+#define TL_MAX_FRAME   (TL_MAX_PAYLOAD + 4)
+#define TL_MAX_ENCODED (TL_MAX_FRAME + 2)  // one COBS overhead byte + delimiter
+
+// ---------- Message types ----------
+enum TlType : uint8_t {
+  TL_STATUS = 'S',  // TlStatus, once per telemetry tick
+  TL_CAN    = 'C',  // TlCanFrame, every BAMOCAR frame the car received
+};
+
+#define TL_FLAG_DRIVE   0x01  // driveEnabled
+#define TL_FLAG_ONLINE  0x02  // bamocarOnline
+#define TL_FLAG_PEDAL   0x04  // pedalFault
+
+struct __attribute__((packed)) TlStatus {
+  uint32_t ms;
+  int16_t  rpm;              // actual motor RPM
+  int16_t  torquePermille;   // torque command, 0.1 % of TORQUE_MAX
+  uint16_t dcBusDeciVolts;
+  int16_t  motorTempDeci;    // 0.1 °C
+  int16_t  igbtTempDeci;     // 0.1 °C
+  uint16_t errorWord;        // BAMOCAR_ERROR_NAMES bits
+  uint16_t apps1Raw;
+  uint16_t apps2Raw;
+  int8_t   step;             // boot sequence step, 7 = ready to drive
+  uint8_t  flags;            // TL_FLAG_*
+};
+static_assert(sizeof(TlStatus) <= TL_MAX_PAYLOAD, "TlStatus too large");
+
+struct __attribute__((packed)) TlCanFrame {
+  uint32_t ms;               // receive time
+  uint16_t id;
+  uint8_t  len;
+  uint8_t  data[8];
+};
+static_assert(sizeof(TlCanFrame) <= TL_MAX_PAYLOAD, "TlCanFrame too large");
+
+// ---------- Dashboard tick (WebSocket) ----------
+// What the bridges send the browser once per UI tick, binary, little-endian:
+//   TlTickHeader
+//   TlStatus        if TL_TICK_HAS_STATUS
+//   TlCanFrame      x frames
+// The dashboard pages parse these by offset; change them together.
+#define TL_TICK_MAGIC      'D'
+#define TL_TICK_VERSION    1
+#define TL_TICK_HAS_STATUS 0x01
+
+struct __attribute__((packed)) TlTickHeader {
+  uint8_t  magic;
+  uint8_t  version;
+  uint8_t  flags;       // TL_TICK_*
+  uint8_t  frames;
+  uint16_t skipped;     // frames that found no free slot this tick
+  uint16_t coalesced;   // frames replaced by a newer one with the same id + register
+  uint32_t linkFrames;  // TlDecoder counters of the bridge's car link
+  uint32_t linkLost;
+  uint32_t linkCrc;
+};
+static_assert(sizeof(TlTickHeader) == 20 && sizeof(TlStatus) == 22 && sizeof(TlCanFrame) == 15,
+              "dashboard pages hard-code these sizes");
+
+// ---------- UDP snapshots ----------
+// The same tick as one multicast datagram, sent every UI tick whether or
+// not anyone listens, so any number of pit laptops costs the AP nothing:
+//   TlUdpHeader
+//   TlTickHeader
+//   TlStatus        newest, every datagram once the car has sent one
+//   TlCanFrame      x frames
+// seq counts every datagram the bridge sent; a receiver that sees a gap
+// sends a resync request {TL_UDP_RESYNC, TL_UDP_VERSION} back to the
+// datagram's source address and port. The next datagram is then a
+// keyframe, carrying the newest frame of every id + register seen
+// (TlLatestFrames) instead of the frames since the last tick. Bridges also
+// send one every TL_UDP_KEYFRAME_MS for receivers that just joined.
+// PRO_M_MOCK_MC/tools/can_gui.py --udp is the reference receiver.
+#define TL_UDP_PORT         5005
+#define TL_UDP_GROUP        239, 255, 70, 83   // IPAddress(TL_UDP_GROUP)
+#define TL_UDP_MAGIC        'U'
+#define TL_UDP_VERSION      1
+#define TL_UDP_KEYFRAME     0x01
+#define TL_UDP_RESYNC       'R'
+#define TL_UDP_KEYFRAME_MS  1000
+#define TL_UDP_KEY_SLOTS    32
+
+struct __attribute__((packed)) TlUdpHeader {
+  uint8_t  magic;
+  uint8_t  version;
+  uint8_t  flags;       // TL_UDP_*
+  uint8_t  reserved;
+  uint32_t seq;
+};
+static_assert(sizeof(TlUdpHeader) == 8, "can_gui.py hard-codes this size");
+
+// Newest frame per id + register byte (data[0]). Keys beyond N are not
+// tracked; the BAMOCAR link uses well under TL_UDP_KEY_SLOTS.
+template <uint8_t N>
+class TlLatestFrames {
+public:
+  void update(const TlCanFrame &f) {
+    for (uint8_t i = 0; i < _count; i++) {
+      TlCanFrame &p = _frames[i];
+      bool sameReg = p.len > 0 ? f.len > 0 && p.data[0] == f.data[0] : f.len == 0;
+      if (p.id == f.id && sameReg) {
+        p = f;
+        return;
+      }
+    }
+    if (_count < N) _frames[_count++] = f;
+  }
+
+  uint8_t           count() const  { return _count; }
+  const TlCanFrame *frames() const { return _frames; }
+
+private:
+  TlCanFrame _frames[N];
+  uint8_t    _count = 0;
+};
+
+// ---------- Bridge tick ----------
+// What a bridge collects between UI ticks, and both messages packed from
+// it: the WebSocket tick and the UDP snapshot. The bridges only feed it
+// and do the I/O, so their wire formats can't drift apart.
+//
+// A frame replaces the pending one with the same id and register byte:
+// the page only needs the newest value of each per tick. Frames beyond
+// MAX are counted as skipped.
+struct TlLinkCounts {
+  uint32_t frames;  // TlTickHeader linkFrames, linkLost, linkCrc
+  uint32_t lost;
+  uint32_t crc;
+};
+
+template <uint8_t MAX>
+class TlTick {
+public:
+  static constexpr size_t TICK_BYTES = sizeof(TlTickHeader) + sizeof(TlStatus) + MAX * sizeof(TlCanFrame);
+  static constexpr size_t UDP_BYTES  = sizeof(TlUdpHeader) + sizeof(TlTickHeader) + sizeof(TlStatus) +
+                                       (MAX > TL_UDP_KEY_SLOTS ? MAX : TL_UDP_KEY_SLOTS) * sizeof(TlCanFrame);
+
+  void status(const TlStatus &s) {
+    _status = s;
+    _statusChanged = _haveStatus = true;
+  }
+
+  void frame(const TlCanFrame &f) {
+    _latest.update(f);
+    for (uint8_t i = 0; i < _count; i++) {
+      TlCanFrame &p = _pending[i];
+      if (p.id == f.id && p.len > 0 && f.len > 0 && p.data[0] == f.data[0]) {
+        p = f;
+        _coalesced++;
+        return;
+      }
+    }
+    if (_count < MAX) _pending[_count++] = f;
+    else _skipped++;
+  }
+
+  // Anything new for the WebSocket since reset().
+  bool pending() const { return _statusChanged || _count > 0 || _skipped > 0; }
+
+  // WebSocket tick into msg (TICK_BYTES): the status if it changed, and
+  // the frames since reset(). Returns the length.
+  size_t pack(uint8_t *msg, const TlLinkCounts &link) const {
+    return packTick(msg, link, _statusChanged, _pending, _count);
+  }
+
+  // UDP snapshot into msg (UDP_BYTES): always the newest status, plus the
+  // frames since reset() or, for a keyframe, the newest frame of every id +
+  // register. Counts seq and keyframe time, so call once per datagram sent.
+  size_t packUdp(uint8_t *msg, const TlLinkCounts &link, uint32_t nowMs) {
+    bool keyframe = _resync || nowMs - _keyframeMs >= TL_UDP_KEYFRAME_MS;
+    TlUdpHeader u;
+    u.magic    = TL_UDP_MAGIC;
+    u.version  = TL_UDP_VERSION;
+    u.flags    = keyframe ? TL_UDP_KEYFRAME : 0;
+    u.reserved = 0;
+    u.seq      = _udpSeq++;
+    memcpy(msg, &u, sizeof(u));
+    size_t n = sizeof(u);
+    if (keyframe) {
+      n += packTick(msg + n, link, _haveStatus, _latest.frames(), _latest.count());
+      _keyframeMs = nowMs;
+      _resync = false;
+    } else {
+      n += packTick(msg + n, link, _haveStatus, _pending, _count);
+    }
+    return n;
+  }
+
+  // A datagram from a receiver. A resync request (one that saw a gap)
+  // makes the next snapshot a keyframe.
+  void request(const uint8_t *p, size_t n) {
+    if (n == 2 && p[0] == TL_UDP_RESYNC && p[1] == TL_UDP_VERSION) _resync = true;
+  }
+
+  // After each UI tick.
+  void reset() {
+    _statusChanged = false;
+    _count = 0;
+    _skipped = 0;
+    _coalesced = 0;
+  }
+
+private:
+  TlStatus   _status = {};
+  bool       _statusChanged = false;
+  bool       _haveStatus = false;
+  TlCanFrame _pending[MAX];
+  uint8_t    _count = 0;
+  uint32_t   _skipped = 0, _coalesced = 0;
+  TlLatestFrames<TL_UDP_KEY_SLOTS> _latest;
+  uint32_t   _udpSeq = 0, _keyframeMs = 0;
+  bool       _resync = false;
+
+  static uint16_t sat16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : (uint16_t)v; }
+
+  size_t packTick(uint8_t *msg, const TlLinkCounts &link, bool withStatus,
+                  const TlCanFrame *frames, uint8_t count) const {
+    TlTickHeader h;
+    h.magic      = TL_TICK_MAGIC;
+    h.version    = TL_TICK_VERSION;
+    h.flags      = withStatus ? TL_TICK_HAS_STATUS : 0;
+    h.frames     = count;
+    h.skipped    = sat16(_skipped);
+    h.coalesced  = sat16(_coalesced);
+    h.linkFrames = link.frames;
+    h.linkLost   = link.lost;
+    h.linkCrc    = link.crc;
+
+    size_t n = 0;
+    memcpy(msg, &h, sizeof(h));
+    n += sizeof(h);
+    if (withStatus) {
+      memcpy(msg + n, &_status, sizeof(_status));
+      n += sizeof(_status);
+    }
+    memcpy(msg + n, frames, count * sizeof(TlCanFrame));
+    n += count * sizeof(TlCanFrame);
+    return n;
+  }
+};
+
+// ---------- CRC ----------
+inline uint16_t tlCrc16(const uint8_t *p, size_t n, uint16_t crc = 0xFFFF) {
+  while (n--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+// ---------- Encoder ----------
+// Writes the stuffed frame plus delimiter to out (≥ TL_MAX_ENCODED bytes)
+// and returns its length, or 0 if the payload is too long.
+inline size_t tlEncode(uint8_t type, uint8_t seq, const void *payload, size_t len, uint8_t *out) {
+  if (len > TL_MAX_PAYLOAD) return 0;
+  uint8_t raw[TL_MAX_FRAME];
+  raw[0] = type;
+  raw[1] = seq;
+  memcpy(raw + 2, payload, len);
+  uint16_t crc = tlCrc16(raw, len + 2);
+  raw[len + 2] = (uint8_t)crc;
+  raw[len + 3] = (uint8_t)(crc >> 8);
+
+  // COBS: each code byte is the distance to the next zero (frames are
+  // shorter than 254 bytes, so one code per zero).
+  size_t n = len + 4;
+  size_t code = 0, o = 1;
+  for (size_t i = 0; i < n; i++) {
+    if (raw[i] == 0) {
+      out[code] = (uint8_t)(o - code);
+      code = o++;
+    } else {
+      out[o++] = raw[i];
+    }
+  }
+  out[code] = (uint8_t)(o - code);
+  out[o++] = 0;
+  return o;
+}
+
+// ---------- Decoder ----------
+// Byte-at-a-time: feed whatever the UART has, act on each completed frame.
+class TlDecoder {
+public:
+  // Returns true when b completed a frame with a valid CRC; type(),
+  // seq() and payload() then describe it until the next call.
+  bool push(uint8_t b) {
+    if (b != 0) {
+      if (_len < sizeof(_buf)) _buf[_len] = b;
+      _len++;
+      return false;
+    }
+    size_t len = _len;
+    _len = 0;
+    if (len == 0) return false;  // back-to-back delimiters
+    if (len > sizeof(_buf)) { _overruns++; return false; }
+    if (!unstuff(len)) { _crcErrors++; return false; }
+    if (_synced && _frame[1] != (uint8_t)(_seq + 1)) _lost += (uint8_t)(_frame[1] - _seq - 1);
+    _synced = true;
+    _seq = _frame[1];
+    _frames++;
+    return true;
+  }
+
+  uint8_t        type() const    { return _frame[0]; }
+  uint8_t        seq() const     { return _frame[1]; }
+  const uint8_t *payload() const { return _frame + 2; }
+  uint8_t        length() const  { return _frameLen; }
+
+  // Copies the payload into a fixed-size message; false if the size differs.
+  template <typename T>
+  bool read(T &out) const {
+    if (_frameLen != sizeof(T)) return false;
+    memcpy(&out, payload(), sizeof(T));
+    return true;
+  }
+
+  uint32_t frames() const    { return _frames; }
+  uint32_t crcErrors() const { return _crcErrors; }  // also bad stuffing
+  uint32_t overruns() const  { return _overruns; }   // longer than TL_MAX_ENCODED
+  uint32_t lost() const      { return _lost; }       // seq gaps
+
+private:
+  uint8_t  _buf[TL_MAX_ENCODED - 1];
+  size_t   _len = 0;
+  uint8_t  _frame[TL_MAX_FRAME];
+  uint8_t  _frameLen = 0;
+  uint8_t  _seq = 0;
+  bool     _synced = false;
+  uint32_t _frames = 0, _crcErrors = 0, _overruns = 0, _lost = 0;
+
+  bool unstuff(size_t len) {
+    size_t o = 0;
+    for (size_t i = 0; i < len;) {
+      uint8_t code = _buf[i++];
+      if (i + code - 1 > len) return false;
+      for (uint8_t k = 1; k < code; k++) {
+        if (o >= sizeof(_frame)) return false;
+        _frame[o++] = _buf[i++];
+      }
+      if (i < len) {
+        if (o >= sizeof(_frame)) return false;
+        _frame[o++] = 0;
+      }
+    }
+    if (o < 4) return false;
+    uint16_t crc = (uint16_t)(_frame[o - 2] | (_frame[o - 1] << 8));
+    if (tlCrc16(_frame, o - 2) != crc) return false;
+    _frameLen = (uint8_t)(o - 4);
+    return true;
+  }
+};
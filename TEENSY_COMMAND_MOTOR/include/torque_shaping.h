@@ -0,0 +1,32 @@
+#pragma once
+#include "config.h"
+
+// Pedal position to torque command, in integer arithmetic only.
+//
+// torqueShape() runs in the torque task (every TORQUE_PERIOD_US): the
+// pedal is mapped through the TORQUE_MAP curve (linear between points),
+// capped at the current limit and slew limited, TORQUE_RISE_MS for a full
+// step up and TORQUE_FALL_MS down. A falling limit cuts the output at once.
+//
+// The limit changes only with BAMOCAR telemetry, so torqueLimitsTick()
+// works it out from the supervisor task: the lowest of
+//   speed        TORQUE_MAX, falling linearly from TORQUE_RPM_DERATE_START
+//                to 0 at RPM_MAX
+//   temperature  the same from each TORQUE_*_TEMP_START_C to _END_C
+//   power        the shaft torque that turns min(TORQUE_POWER_LIMIT_W,
+//                dcBusVoltage * TORQUE_DC_CURRENT_A) at the current speed,
+//                less TORQUE_EFFICIENCY_PERCENT losses
+// All limits are in TORQUE_MAX units.
+
+struct TorqueLimits {
+  int16_t speed;
+  int16_t motorTemp;
+  int16_t igbtTemp;
+  int16_t power;
+  int16_t limit;  // lowest of the above, what torqueShape() caps at
+};
+
+int16_t torqueShape(uint16_t pedalPermille);  // torque task; pedal 0..1000
+void torqueShapeReset();                      // output to 0 at once: faults, drive off
+void torqueLimitsTick();                      // supervisor task
+TorqueLimits torqueLimits();
@@ -0,0 +1,59 @@
+#pragma once
+#include "config.h"
+#include "bamocar_decoder.h"
+
+// Latency tracing on the DWT cycle counter (600 MHz, ~1.7 ns per tick).
+//
+// Paths:
+//   TRACE_PEDAL_TORQUE  pedal sample (torque task picks up the newest APPS
+//                       samples) -> torque computed
+//   TRACE_PEDAL_TX      pedal sample -> torque frame written to CAN_TORQUE_MB
+//   TRACE_RTT + i       REG_TRANSMIT_REQUEST for BAMOCAR_REGISTERS[i] ->
+//                       first 0x181 frame of that register, stamped in the
+//                       RX interrupt. A cyclic frame already in flight can
+//                       answer a one-shot request, so treat min as optimistic.
+//
+// Each path keeps min/max/sum and a log-linear histogram (8 buckets per
+// octave, p99 within ~12%) that traceLogStats() reports and resets. Paths
+// are written from one context each (torque paths in the timer ISR, RTT
+// paths in the loop); the summary copies them with interrupts masked.
+// Set TRACE_ENABLED 0 in config.h to compile every hook out.
+
+enum TracePath : uint8_t {
+  TRACE_PEDAL_TORQUE,
+  TRACE_PEDAL_TX,
+  TRACE_RTT,
+  TRACE_PATH_COUNT = TRACE_RTT + BAMOCAR_REGISTER_COUNT,
+};
+
+// Durations in 0.1 µs units, as logged in the LT record.
+struct TraceSummary {
+  uint32_t count;
+  uint32_t min;
+  uint32_t avg;
+  uint32_t p99;
+  uint32_t max;
+};
+
+#if TRACE_ENABLED
+static inline uint32_t traceNow() { return ARM_DWT_CYCCNT; }
+
+void traceBegin();                              // enable the cycle counter
+void traceRecord(uint8_t path, uint32_t startCycles, uint32_t endCycles);
+void traceWrite();                              // inverter bus accepted a frame
+uint32_t traceLastWrite();                      // cycles of this context's last write
+void traceRequest(uint8_t reg);                 // transmit request queued
+void traceResponse(uint8_t reg, uint32_t rxCycles);
+#else
+static inline uint32_t traceNow() { return 0; }
+static inline void traceBegin() {}
+static inline void traceRecord(uint8_t, uint32_t, uint32_t) {}
+static inline void traceWrite() {}
+static inline uint32_t traceLastWrite() { return 0; }
+static inline void traceRequest(uint8_t) {}
+static inline void traceResponse(uint8_t, uint32_t) {}
+#endif
+
+const char *tracePathName(uint8_t path);
+const TraceSummary &traceLast(uint8_t path);  // from the latest traceLogStats()
+void traceLogStats();  // one LT record per path with samples, then reset
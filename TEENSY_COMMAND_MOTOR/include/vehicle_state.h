@@ -0,0 +1,32 @@
+#pragma once
+#include "config.h"
+
+// Dead-reckoning vehicle state: a complementary filter between the IMU's
+// forward acceleration and the drive wheel speed from the motor RPM.
+//
+// Every IMU sample (vehicleStateImu(), from MpuController::service())
+// integrates the forward acceleration into the speed and pulls the speed
+// towards wheel speed with time constant VSE_TAU_S: the accelerometer
+// carries the fast changes, motor speed the long-term value. While the
+// drive wheels slip by more than VSE_SLIP_LIMIT the pull weakens to
+// VSE_SLIP_TAU_S, so wheel spin under power or lock-up under braking does
+// not drag the estimate with it. At standstill (motor stopped, estimate
+// below VSE_MIN_SPEED_MS) the speed is held at 0 and the accelerometer's
+// offset, mostly mounting tilt, is learnt instead.
+//
+// Fixed state, no allocation, a few dozen FPU operations per sample. Runs
+// in the IMU task; read it from loop context. Without IMU samples for
+// VSE_IMU_TIMEOUT_MS, vehicleState() reports plain wheel speed.
+
+struct VehicleState {
+  float speedMs;     // estimated vehicle speed, m/s
+  float wheelMs;     // drive wheel speed from rpmFeedback, m/s
+  float accelMs2;    // forward acceleration, offset removed, low-passed
+  float yawRateDps;  // deg/s
+  float slip;        // (wheel - vehicle) / vehicle: > 0 spinning, < 0 locking
+  bool  imu;         // false: IMU missing or stale, speed is wheel speed
+};
+
+void vehicleStateImu(uint32_t tUs, const int16_t raw[6]);  // raw MPU6050 accel xyz, gyro xyz
+VehicleState vehicleState();
+float vehicleWheelSpeed(int16_t rpmFeedback);  // m/s, rpmFeedback normalised as in BamocarState
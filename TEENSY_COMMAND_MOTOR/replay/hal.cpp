@@ -0,0 +1,175 @@
+// Virtual-clock implementation of the replay stubs (replay/stubs).
+#include <chrono>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "FlexCAN_T4.h"
+#include "SD.h"
+#include "Wire.h"
+
+#define REPLAY_MAX_TIMERS 4
+#define REPLAY_PIN_COUNT  64
+
+HardwareSerial Serial;
+HardwareSerial Serial2;
+HardwareSerial Serial7(true);
+TwoWire Wire;
+SDClass SD;
+uint32_t ARM_DEMCR = 0;
+uint32_t ARM_DWT_CTRL = 0;
+
+static uint64_t _nowUs = 0;
+static IntervalTimer *_timers[REPLAY_MAX_TIMERS];
+static int _pins[REPLAY_PIN_COUNT];
+static ReplayCanTxHook _canTx = nullptr;
+static ReplayNextionHook _nextionHook = nullptr;
+static const char *_sdPath = nullptr;
+
+// ---------- Clock ----------
+uint64_t replayNowUs() {
+  return _nowUs;
+}
+
+void replayAdvance(uint32_t us) {
+  uint64_t target = _nowUs + us;
+  for (;;) {
+    IntervalTimer *due = nullptr;
+    for (IntervalTimer *t : _timers) {
+      if (t && t->_nextUs <= target && (!due || t->_nextUs < due->_nextUs)) due = t;
+    }
+    if (!due) break;
+    if (due->_nextUs > _nowUs) _nowUs = due->_nextUs;
+    due->_nextUs += due->_periodUs;
+    due->_fn();
+  }
+  _nowUs = target;
+}
+
+uint32_t replayCycles() {
+  using namespace std::chrono;
+  uint64_t ns = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  return (uint32_t)(ns * (F_CPU_ACTUAL / 1000000) / 1000);
+}
+
+bool IntervalTimer::begin(void (*fn)(), uint32_t periodUs) {
+  end();
+  for (IntervalTimer *&slot : _timers) {
+    if (slot) continue;
+    _fn = fn;
+    _periodUs = periodUs;
+    _nextUs = _nowUs + periodUs;
+    slot = this;
+    return true;
+  }
+  return false;
+}
+
+void IntervalTimer::end() {
+  for (IntervalTimer *&slot : _timers) {
+    if (slot == this) slot = nullptr;
+  }
+}
+
+// ---------- Pins ----------
+void replaySetPin(uint8_t pin, int value) {
+  if (pin < REPLAY_PIN_COUNT) _pins[pin] = value;
+}
+
+int replayPin(uint8_t pin) {
+  return pin < REPLAY_PIN_COUNT ? _pins[pin] : 0;
+}
+
+// ---------- CAN ----------
+ReplayCanBus &replayCanBus(uint8_t bus) {
+  static ReplayCanBus buses[3];
+  if (bus < 1 || bus > 3) bus = 1;
+  buses[bus - 1].number = bus;
+  return buses[bus - 1];
+}
+
+int ReplayCanBus::write(const CAN_message_t &msg) {
+  if (!_canTx) return 1;
+  CAN_message_t out = msg;
+  out.bus = number;
+  _canTx(out);
+  return 1;
+}
+
+void replayCanReceive(const CAN_message_t &in) {
+  ReplayCanBus &bus = replayCanBus(in.bus);
+  if (!bus.accepts(in.id)) return;
+  CAN_message_t msg = in;
+  msg.bus = bus.number;
+  if (bus.fifoInterrupt && bus.onReceive) {
+    bus.onReceive(msg);
+    return;
+  }
+  uint16_t next = (bus.head + 1) % 512;
+  if (next == bus.tail) return;  // controller queue full: frame lost
+  bus.queue[bus.head] = msg;
+  bus.head = next;
+}
+
+void replayOnCanTx(ReplayCanTxHook hook) {
+  _canTx = hook;
+}
+
+// ---------- Nextion ----------
+// Commands end with three 0xFF bytes.
+size_t HardwareSerial::write(uint8_t b) {
+  if (!_nextion) return 1;
+  if (b == 0xFF) {
+    if (++_ff == 3) {
+      if (_len > 0 && _nextionHook) _nextionHook(_cmd, _len);
+      _len = 0;
+      _ff = 0;
+    }
+    return 1;
+  }
+  _ff = 0;
+  if (_len < sizeof(_cmd)) _cmd[_len++] = (char)b;
+  return 1;
+}
+
+void replayOnNextion(ReplayNextionHook hook) {
+  _nextionHook = hook;
+}
+
+// ---------- SD ----------
+void replaySetSdPath(const char *path) {
+  _sdPath = path;
+}
+
+bool SDClass::begin(uint8_t) {
+  return _sdPath != nullptr;
+}
+
+// The first name opened is the log and maps to the --sd path; any other
+// (fault captures) is created under its own name next to it.
+FsFile SdFs::open(const char *name, oflag_t oflag) {
+  static std::string logName;
+  FsFile f;
+  if (!_sdPath) return f;
+  if (logName.empty()) logName = name;
+  std::string path = _sdPath;
+  if (logName != name) {
+    size_t slash = path.rfind('/');
+    path = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + name;
+  }
+  f._f = fopen(path.c_str(), (oflag & O_TRUNC) ? "w+b" : "r+b");
+  return f;
+}
+
+uint64_t FsFile::fileSize() const {
+  struct stat st;
+  if (!_f || fstat(fileno(_f), &st) != 0) return 0;
+  return (uint64_t)st.st_size;
+}
+
+bool FsFile::truncate(uint64_t length) {
+  if (!_f) return false;
+  fflush(_f);
+  return ftruncate(fileno(_f), (off_t)length) == 0 && seekSet(length);
+}
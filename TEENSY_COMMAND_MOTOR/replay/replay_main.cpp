@@ -0,0 +1,226 @@
+// Host replay: runs the real firmware (src/*.cpp, setup() + loop()) on a
+// virtual clock and feeds it a recorded log.
+//
+//   RX 0x181 frames  -> delivered through the CAN FIFO interrupt callback
+//   S records        -> APPS1/APPS2 pin values seen by the ADC DMA stubs
+//   TX frames        -> skipped; the firmware sends its own
+//
+// A scripted driver presses the button when the boot sequence asks for it,
+// holds it for the enable and re-enable holds, and never touches it
+// otherwise. Every change of step, drive/online/fault flags and Nextion
+// status text is printed with the log line that preceded it.
+//
+// Build and run (from TEENSY_COMMAND_MOTOR):
+//   pio run -e native
+//   .pio/build/native/program ../CANBUS_LOGS/17-10-2025/CAN_traffic_logs_0060.csv
+//   .pio/build/native/program CAN_log_0001.csv --realtime --sd replay_out.csv
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "config.h"
+#include "drive_sequence.h"
+#include "nextion.h"
+#include "trace.h"
+#include "log_parse.h"
+
+void setup();
+void loop();
+
+#define REPLAY_STEP_US   100    // virtual time per loop() call
+#define REPLAY_TAIL_MS   2000   // keep running after the last record
+#define REPLAY_PRESS_MS  100    // scripted short press
+
+// ---------- Options ----------
+static bool     _realtime = false;
+static bool     _autoDriver = true;
+static bool     _showTx = false;
+static uint32_t _stepUs = REPLAY_STEP_US;
+
+// ---------- Counters ----------
+static uint64_t _linesIn = 0;
+static uint64_t _framesIn = 0;
+static uint64_t _framesTx = 0;
+static uint64_t _sensorIn = 0;
+static uint64_t _lastLine = 0;  // log line of the last injected record
+static uint32_t _txByReg[256];
+
+static void onCanTx(const CAN_message_t &msg) {
+  if (msg.bus != 1) return;  // only the inverter bus is modelled
+  _framesTx++;
+  if (msg.len > 0) _txByReg[msg.buf[0]]++;
+  if (!_showTx) return;
+  printf("%10.3f TX %03X", replayNowUs() / 1000.0, (unsigned)msg.id);
+  for (uint8_t i = 0; i < msg.len; i++) printf(" %02X", msg.buf[i]);
+  printf("\n");
+}
+
+// Only boot-page status text is reported; drive-page values change constantly.
+static void onNextion(const char *cmd, size_t len) {
+  const char *prefix = NX_BOOT_STATUS ".txt=";
+  size_t n = strlen(prefix);
+  if (len > n && memcmp(cmd, prefix, n) == 0)
+    printf("%10.3f nextion %.*s   (after line %llu)\n", replayNowUs() / 1000.0,
+           (int)(len - n), cmd + n, (unsigned long long)_lastLine);
+}
+
+// ---------- Observed state ----------
+struct Observed {
+  int8_t   step;
+  bool     driveEnabled;
+  bool     bamocarOnline;
+  bool     pedalFault;
+  uint32_t errorWord;
+  uint8_t  seq;
+
+  bool operator!=(const Observed &o) const { return memcmp(this, &o, sizeof(*this)) != 0; }
+};
+
+static Observed observe() {
+  Observed o;
+  memset(&o, 0, sizeof(o));
+  o.step = currentStep;
+  o.driveEnabled = driveEnabled;
+  o.bamocarOnline = bamocarOnline;
+  o.pedalFault = pedalFault;
+  o.errorWord = bamocar.errorWord;
+  o.seq = driveSeqState();
+  return o;
+}
+
+static uint64_t _transitions = 0;
+
+static void report(const Observed &was, const Observed &now) {
+  double ms = replayNowUs() / 1000.0;
+  auto flag = [&](const char *name, bool a, bool b) {
+    if (a != b) printf("%10.3f %-14s %d -> %d   (after line %llu)\n", ms, name, a, b, (unsigned long long)_lastLine);
+  };
+  if (was.step != now.step)
+    printf("%10.3f %-14s %d -> %d   (after line %llu)\n", ms, "step", was.step, now.step, (unsigned long long)_lastLine);
+  if (was.seq != now.seq)
+    printf("%10.3f %-14s %d -> %d   (after line %llu)\n", ms, "sequence", was.seq, now.seq, (unsigned long long)_lastLine);
+  if (was.errorWord != now.errorWord)
+    printf("%10.3f %-14s 0x%04X -> 0x%04X   (after line %llu)\n", ms, "error_word", was.errorWord, now.errorWord, (unsigned long long)_lastLine);
+  flag("drive_enabled", was.driveEnabled, now.driveEnabled);
+  flag("bamocar_online", was.bamocarOnline, now.bamocarOnline);
+  flag("pedal_fault", was.pedalFault, now.pedalFault);
+  _transitions++;
+}
+
+// ---------- Scripted driver ----------
+static void drive() {
+  static uint64_t pressUntilUs = 0;
+  uint64_t now = replayNowUs();
+  DriveSeqState s = driveSeqState();
+  bool hold = s == SEQ_WAIT_HOLD ||
+              (currentStep == 7 && !driveEnabled && !driveSeqActive());  // re-enable
+  if (s == SEQ_WAIT_START && pressUntilUs == 0) pressUntilUs = now + REPLAY_PRESS_MS * 1000;
+  if (s != SEQ_WAIT_START) pressUntilUs = 0;
+  replaySetPin(BUTTON_PIN, hold || now < pressUntilUs);
+}
+
+// ---------- Stepping ----------
+static std::chrono::steady_clock::time_point _wallStart;
+
+static void runUntil(uint64_t targetUs) {
+  static Observed last = observe();
+  while (replayNowUs() < targetUs) {
+    loop();
+    Observed now = observe();
+    if (now != last) {
+      report(last, now);
+      last = now;
+    }
+    if (_autoDriver) drive();
+    replayAdvance(_stepUs);
+    if (_realtime) std::this_thread::sleep_until(_wallStart + std::chrono::microseconds(replayNowUs()));
+  }
+}
+
+static void inject(const LogLine &line) {
+  if (line.kind == LOG_FRAME) {
+    const LogFrame &fr = line.frame;
+    if (!fr.rx) return;
+    CAN_message_t msg;
+    msg.id = fr.id;
+    msg.len = fr.len;
+    msg.bus = fr.bus;
+    memcpy(msg.buf, fr.buf, fr.len);
+    replayCanReceive(msg);
+    _framesIn++;
+  } else if (line.kind == LOG_SENSOR) {
+    replaySetPin(APPS1_PIN, line.sensor.apps1Raw);
+    replaySetPin(APPS2_PIN, line.sensor.apps2Raw);
+    _sensorIn++;
+  }
+}
+
+static uint32_t recordMs(const LogLine &line) {
+  return line.kind == LOG_FRAME ? line.frame.ms : line.sensor.ms;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: replay <log.csv> [--realtime] [--no-driver] [--tx] [--step-us N] [--sd out]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "--realtime")                    _realtime = true;
+    else if (a == "--no-driver")              _autoDriver = false;
+    else if (a == "--tx")                     _showTx = true;
+    else if (a == "--step-us" && i + 1 < argc) _stepUs = (uint32_t)atoi(argv[++i]);
+    else if (a == "--sd" && i + 1 < argc)     replaySetSdPath(argv[++i]);
+    else if (a[0] == '-' || path)             usage();
+    else                                      path = argv[i];
+  }
+  if (!path || _stepUs == 0) usage();
+
+  LogReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "replay: cannot read %s\n", path);
+    return 1;
+  }
+
+  // Pedal at rest until the log says otherwise (capture logs have no S records).
+  replaySetPin(APPS1_PIN, APPS1_REST);
+  replaySetPin(APPS2_PIN, APPS2_REST);
+  replayOnCanTx(onCanTx);
+  replayOnNextion(onNextion);
+
+  _wallStart = std::chrono::steady_clock::now();
+  setup();
+
+  LogLine line;
+  while (reader.next(line)) {
+    if (line.kind != LOG_FRAME && line.kind != LOG_SENSOR) continue;
+    runUntil((uint64_t)recordMs(line) * 1000);
+    inject(line);
+    _linesIn++;
+    _lastLine = reader.lines();
+  }
+  runUntil(replayNowUs() + REPLAY_TAIL_MS * 1000);
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _wallStart).count();
+  double simMs = replayNowUs() / 1000.0;
+  printf("\n%llu records (%llu RX frames, %llu S samples), %llu frames sent, %llu transitions\n",
+         (unsigned long long)_linesIn, (unsigned long long)_framesIn, (unsigned long long)_sensorIn,
+         (unsigned long long)_framesTx, (unsigned long long)_transitions);
+  printf("sent: torque %u, transmit request %u, drive %u, clear errors %u, can timeout %u\n",
+         _txByReg[REG_TORQUE_COMMAND], _txByReg[REG_TRANSMIT_REQUEST], _txByReg[REG_DRIVE_COMMAND],
+         _txByReg[REG_CLEAR_ERRORS], _txByReg[REG_CAN_TIMEOUT]);
+  printf("%.0f ms simulated in %.0f ms wall (%.0fx)\n", simMs, wallMs, wallMs > 0 ? simMs / wallMs : 0.0);
+
+  // Host cost of the control path, from the last stats period.
+  for (uint8_t p : { (uint8_t)TRACE_PEDAL_TORQUE, (uint8_t)TRACE_PEDAL_TX }) {
+    const TraceSummary &s = traceLast(p);
+    if (s.count)
+      printf("%-14s n=%u avg %.1f us, p99 %.1f us, max %.1f us\n", tracePathName(p), s.count,
+             s.avg / 10.0, s.p99 / 10.0, s.max / 10.0);
+  }
+  return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "Arduino.h"
+
+enum class ADC_CONVERSION_SPEED { VERY_LOW_SPEED, LOW_SPEED, MED_SPEED, HIGH_SPEED, VERY_HIGH_SPEED };
+enum class ADC_SAMPLING_SPEED { VERY_LOW_SPEED, LOW_SPEED, MED_SPEED, HIGH_SPEED, VERY_HIGH_SPEED };
+#define ADC_0 0
+#define ADC_1 1
+
+// Remembers the pin and timer rate; conversions read replayPin().
+class ADC_Module {
+public:
+  void setAveraging(uint8_t) {}
+  void setResolution(uint8_t) {}
+  void setConversionSpeed(ADC_CONVERSION_SPEED) {}
+  void setSamplingSpeed(ADC_SAMPLING_SPEED) {}
+  bool startSingleRead(uint8_t pin) { _pin = pin; return true; }
+  void startTimer(uint32_t hz) { _hz = hz; }
+  void stopTimer() { _hz = 0; }
+
+  uint8_t  _pin = 0;
+  uint32_t _hz = 0;
+};
+
+class ADC {
+public:
+  ADC() : adc0(&_m[0]), adc1(&_m[1]) {}
+  ADC_Module *adc0;
+  ADC_Module *adc1;
+private:
+  ADC_Module _m[2];
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+typedef enum { MPU6050_RANGE_2_G, MPU6050_RANGE_4_G, MPU6050_RANGE_8_G, MPU6050_RANGE_16_G } mpu6050_accel_range_t;
+typedef enum { MPU6050_RANGE_250_DEG, MPU6050_RANGE_500_DEG, MPU6050_RANGE_1000_DEG, MPU6050_RANGE_2000_DEG } mpu6050_gyro_range_t;
+typedef enum { MPU6050_BAND_260_HZ, MPU6050_BAND_184_HZ, MPU6050_BAND_94_HZ, MPU6050_BAND_44_HZ,
+               MPU6050_BAND_21_HZ, MPU6050_BAND_10_HZ, MPU6050_BAND_5_HZ } mpu6050_bandwidth_t;
+
+// Not present on the replay bench: begin() always fails.
+class Adafruit_MPU6050 {
+public:
+  bool begin(uint8_t = 0x68, TwoWire * = &Wire, int32_t = 0) { return false; }
+  void setAccelerometerRange(mpu6050_accel_range_t) {}
+  void setGyroRange(mpu6050_gyro_range_t) {}
+  void setFilterBandwidth(mpu6050_bandwidth_t) {}
+};
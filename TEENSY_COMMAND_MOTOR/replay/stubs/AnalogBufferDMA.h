@@ -0,0 +1,38 @@
+#pragma once
+#include "ADC.h"
+
+// A buffer "completes" every block of the module's timer rate; the block
+// holds the pin's current replay value.
+class AnalogBufferDMA {
+public:
+  AnalogBufferDMA(volatile uint16_t *a, uint16_t na, volatile uint16_t *b = nullptr, uint16_t nb = 0)
+    : _buf{ a, b }, _n{ na, nb } {}
+  void init(ADC *adc, int8_t module = -1) { _m = module == ADC_1 ? adc->adc1 : adc->adc0; }
+
+  bool interrupted() {
+    if (_ready) return true;
+    if (!_m || _m->_hz == 0) return false;
+    uint64_t blockUs = (uint64_t)_n[_cur] * 1000000 / _m->_hz;
+    if (replayNowUs() - _lastUs < blockUs) return false;
+    fill();
+    _ready = true;
+    return true;
+  }
+  void clearInterrupt() { _ready = false; _lastUs = replayNowUs(); }
+  volatile uint16_t *bufferLastISRFilled() { return _buf[_cur]; }
+  uint16_t bufferCountLastISRFilled() { return _n[_cur]; }
+
+private:
+  volatile uint16_t *_buf[2];
+  uint16_t _n[2];
+  uint8_t  _cur = 0;
+  ADC_Module *_m = nullptr;
+  uint64_t _lastUs = 0;
+  bool     _ready = false;
+
+  void fill() {
+    if (_buf[1]) _cur ^= 1;
+    uint16_t v = (uint16_t)replayPin(_m->_pin);
+    for (uint16_t i = 0; i < _n[_cur]; i++) _buf[_cur][i] = v;
+  }
+};
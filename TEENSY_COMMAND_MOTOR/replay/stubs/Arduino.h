@@ -0,0 +1,94 @@
+#pragma once
+// Minimal Teensy core for the replay build, see replay_hal.h.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "replay_hal.h"
+
+#define HIGH 1
+#define LOW  0
+#define INPUT          0
+#define OUTPUT         1
+#define INPUT_PULLUP   2
+#define INPUT_PULLDOWN 3
+#define A0 14
+#define A1 15
+#define BUILTIN_SDCARD 254
+
+#define DMAMEM
+#define EXTMEM
+#define FASTRUN
+#define FLASHMEM
+#define PROGMEM
+
+typedef uint8_t byte;
+
+inline uint32_t millis() { return (uint32_t)(replayNowUs() / 1000); }
+inline uint32_t micros() { return (uint32_t)replayNowUs(); }
+inline void delay(uint32_t ms) { replayAdvance(ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { replayAdvance(us); }
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int  digitalRead(uint8_t pin) { return replayPin(pin) ? HIGH : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t v) { replaySetPin(pin, v); }
+inline int  analogRead(uint8_t pin) { return replayPin(pin); }
+inline void analogReadResolution(int) {}
+
+// Timer callbacks run between loop() iterations, so masking is a no-op.
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+
+#define ARM_DWT_CYCCNT replayCycles()
+extern uint32_t ARM_DEMCR;
+extern uint32_t ARM_DWT_CTRL;
+#define ARM_DEMCR_TRCENA       (1 << 24)
+#define ARM_DWT_CTRL_CYCCNTENA 1
+#define F_CPU_ACTUAL 600000000u
+
+inline void arm_dcache_delete(void *, uint32_t) {}
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) write(b[i]);
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  virtual int availableForWrite() { return 4096; }
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+};
+
+// Serial7 feeds the Nextion hook; every port accepts and drops the rest
+// (Serial2 is the telemetry link).
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(bool nextion = false) : _nextion(nextion) {}
+  void begin(uint32_t) {}
+  size_t write(uint8_t b) override;
+  using Print::write;
+  void addMemoryForWrite(void *, size_t) {}
+  void addMemoryForRead(void *, size_t) {}
+  operator bool() { return true; }
+private:
+  bool   _nextion;
+  char   _cmd[256];
+  size_t _len = 0;
+  int    _ff = 0;
+};
+
+extern HardwareSerial Serial, Serial2, Serial7;
+
+#include "IntervalTimer.h"
@@ -0,0 +1,21 @@
+#pragma once
+#include "Arduino.h"
+
+// Teensy 4.1 emulated EEPROM (4284 bytes), erased (0xFF) at every start.
+class EEPROMClass {
+public:
+  EEPROMClass() { memset(_data, 0xFF, sizeof(_data)); }
+  template <typename T> T &get(int idx, T &t) {
+    memcpy(&t, _data + idx, sizeof(T));
+    return t;
+  }
+  template <typename T> const T &put(int idx, const T &t) {
+    memcpy(_data + idx, &t, sizeof(T));
+    return t;
+  }
+
+private:
+  uint8_t _data[4284];
+};
+
+inline EEPROMClass EEPROM;
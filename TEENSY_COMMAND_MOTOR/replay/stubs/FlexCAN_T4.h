@@ -0,0 +1,125 @@
+#pragma once
+#include "Arduino.h"
+
+typedef struct CAN_message_t {
+  uint32_t id = 0;
+  uint16_t timestamp = 0;
+  uint8_t  idhit = 0;
+  struct { bool extended = 0; bool remote = 0; bool overrun = 0; bool reserved = 0; } flags;
+  uint8_t  len = 8;
+  uint8_t  buf[8] = { 0 };
+  int8_t   mb = 0;
+  uint8_t  bus = 0;
+  bool     seq = 0;
+} CAN_message_t;
+
+typedef struct CANFD_message_t {
+  uint32_t id = 0;
+  uint16_t timestamp = 0;
+  uint8_t  idhit = 0;
+  bool     brs = 1;
+  bool     esi = 0;
+  bool     edl = 1;
+  struct { bool extended = 0; bool overrun = 0; } flags;
+  uint8_t  len = 64;
+  uint8_t  buf[64] = { 0 };
+  int8_t   mb = 0;
+  uint8_t  bus = 0;
+  bool     seq = 0;
+} CANFD_message_t;
+
+typedef struct CANFD_timings_t {
+  double   baudrate = 1000000;
+  double   baudrateFD = 2000000;
+  double   propdelay = 190;
+  double   bus_length = 1;
+  double   sample = 75;
+  uint32_t clock = 24;
+} CANFD_timings_t;
+
+enum CAN_DEV_TABLE { CAN1, CAN2, CAN3 };
+// Error registers (imxrt_flexcan.h addresses them from the controller's
+// base). Replay never sees a bus error: both stay zero, error active.
+inline volatile uint32_t replayFlexcanEcr[3] = {};
+inline volatile uint32_t replayFlexcanEsr1[3] = {};
+#define FLEXCANb_ECR(b)  replayFlexcanEcr[b]
+#define FLEXCANb_ESR1(b) replayFlexcanEsr1[b]
+enum CAN_FLTEN { ACCEPT_ALL, REJECT_ALL };
+enum FLEXCAN_IDE { NONE, EXT, RTR, STD, INACTIVE };
+enum FLEXCAN_MAILBOX { MB0, MB1, MB2, MB3, MB4, MB5, MB6, MB7, MB8, MB9, MB10, MB11, MB12, MB13, MB14, MB15, FIFO = 99 };
+enum FLEXCAN_RXTX { TX, RX, LISTEN_ONLY };
+enum FLEXCAN_RXQUEUE_TABLE { RX_SIZE_2 = 2, RX_SIZE_16 = 16, RX_SIZE_32 = 32, RX_SIZE_64 = 64, RX_SIZE_128 = 128, RX_SIZE_256 = 256, RX_SIZE_512 = 512 };
+enum FLEXCAN_TXQUEUE_TABLE { TX_SIZE_2 = 2, TX_SIZE_16 = 16, TX_SIZE_32 = 32, TX_SIZE_64 = 64, TX_SIZE_128 = 128, TX_SIZE_256 = 256 };
+typedef void (*_MB_ptr)(const CAN_message_t &msg);
+
+// One bus model per controller. TX completes instantly, so every mailbox
+// is always free.
+struct ReplayCanBus {
+  uint8_t  number = 1;             // msg.bus of received frames
+  _MB_ptr  onReceive = nullptr;
+  bool     fifoInterrupt = false;
+  bool     rejectAll = false;
+  uint32_t filterLo[8], filterHi[8];
+  uint8_t  filters = 0;
+  CAN_message_t queue[512];
+  uint16_t head = 0, tail = 0;
+
+  bool accepts(uint32_t id) const {
+    if (!rejectAll) return true;
+    for (uint8_t i = 0; i < filters; i++) {
+      if (id >= filterLo[i] && id <= filterHi[i]) return true;
+    }
+    return false;
+  }
+  void filter(uint8_t i, uint32_t lo, uint32_t hi) {
+    if (i >= 8) return;
+    filterLo[i] = lo;
+    filterHi[i] = hi;
+    if (i >= filters) filters = i + 1;
+  }
+  int  write(const CAN_message_t &msg);
+  int  read(CAN_message_t &msg) {
+    if (head == tail) return 0;
+    msg = queue[tail];
+    tail = (tail + 1) % 512;
+    return 1;
+  }
+};
+ReplayCanBus &replayCanBus(uint8_t bus = 1);  // FlexCAN controller, 1..3
+
+template <CAN_DEV_TABLE _bus, FLEXCAN_RXQUEUE_TABLE _rxSize = RX_SIZE_16, FLEXCAN_TXQUEUE_TABLE _txSize = TX_SIZE_16>
+class FlexCAN_T4 {
+public:
+  void begin() {}
+  void setBaudRate(uint32_t, FLEXCAN_RXTX = TX) {}
+  int  read(CAN_message_t &msg) { return bus().read(msg); }
+  int  write(const CAN_message_t &msg) { return bus().write(msg); }
+  int  write(FLEXCAN_MAILBOX, const CAN_message_t &msg) { return bus().write(msg); }
+  void setMB(const FLEXCAN_MAILBOX, const FLEXCAN_RXTX, const FLEXCAN_IDE = STD) {}
+  void enableFIFO(bool = 1) {}
+  void enableFIFOInterrupt(bool on = 1) { bus().fifoInterrupt = on; }
+  void onReceive(const _MB_ptr fn) { bus().onReceive = fn; }
+  void setFIFOFilter(const CAN_FLTEN f) { bus().rejectAll = (f == REJECT_ALL); }
+  bool setFIFOFilter(uint8_t i, uint32_t id, const FLEXCAN_IDE, const FLEXCAN_IDE = NONE) {
+    bus().filter(i, id, id);
+    return 1;
+  }
+  bool setFIFOFilterRange(uint8_t i, uint32_t lo, uint32_t hi, const FLEXCAN_IDE, const FLEXCAN_IDE = NONE) {
+    bus().filter(i, lo, hi);
+    return 1;
+  }
+
+private:
+  static ReplayCanBus &bus() { return replayCanBus(_bus + 1); }
+};
+
+// CAN FD (Can3 with CAN_FD_TELEMETRY): transmit only, frames are discarded.
+template <CAN_DEV_TABLE _bus, FLEXCAN_RXQUEUE_TABLE _rxSize = RX_SIZE_16, FLEXCAN_TXQUEUE_TABLE _txSize = TX_SIZE_16>
+class FlexCAN_T4FD {
+public:
+  void begin() {}
+  bool setBaudRate(CANFD_timings_t, uint8_t = 1, uint8_t = 1) { return 1; }
+  void setRegions(uint8_t) {}
+  int  read(CANFD_message_t &) { return 0; }
+  int  write(const CANFD_message_t &) { return 1; }
+};
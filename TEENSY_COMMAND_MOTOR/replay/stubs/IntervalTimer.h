@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+// Fired by replayAdvance() whenever the virtual clock crosses a period.
+class IntervalTimer {
+public:
+  IntervalTimer() {}
+  ~IntervalTimer() { end(); }
+  bool begin(void (*fn)(), uint32_t periodUs);
+  void end();
+  void priority(uint8_t) {}
+  void update(uint32_t periodUs) { _periodUs = periodUs; }
+
+  void (*_fn)() = nullptr;
+  uint32_t _periodUs = 0;
+  uint64_t _nextUs = 0;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "Arduino.h"
+#include <fcntl.h>
+
+typedef int oflag_t;
+
+// SdFat file, backed by the host file set with replaySetSdPath() for the
+// log and by a file of the same name next to it otherwise. The card itself is not modelled: files are never contiguous,
+// so the logger falls back to a growing file.
+class FsFile {
+public:
+  operator bool() const { return _f != nullptr; }
+  bool   isOpen() const { return _f != nullptr; }
+  size_t write(const void *b, size_t n) { return _f ? fwrite(b, 1, n, _f) : 0; }
+  int    read(void *b, size_t n) { return _f ? (int)fread(b, 1, n, _f) : -1; }
+  bool   seekSet(uint64_t pos) { return _f && fseek(_f, (long)pos, SEEK_SET) == 0; }
+  uint64_t curPosition() const { return _f ? (uint64_t)ftell(_f) : 0; }
+  uint64_t fileSize() const;
+  bool   truncate(uint64_t length);
+  bool   preAllocate(uint64_t) { return _f != nullptr; }
+  bool   contiguousRange(uint32_t *, uint32_t *) { return false; }
+  bool   sync() { return _f && fflush(_f) == 0; }
+  void   flush() { sync(); }
+  bool   close() { if (_f) fclose(_f); _f = nullptr; return true; }
+
+private:
+  friend class SdFs;
+  FILE *_f = nullptr;
+};
+
+class SdCard {
+public:
+  bool erase(uint32_t, uint32_t) { return false; }
+};
+
+class SdFs {
+public:
+  FsFile  open(const char *path, oflag_t oflag = O_RDONLY);
+  SdCard *card() { return &_card; }
+
+private:
+  SdCard _card;
+};
+
+class SDClass {
+public:
+  bool begin(uint8_t);
+  bool exists(const char *) { return false; }
+  bool remove(const char *) { return false; }
+  SdFs sdfs;
+};
+
+extern SDClass SD;
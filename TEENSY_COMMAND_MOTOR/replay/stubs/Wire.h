@@ -0,0 +1,16 @@
+#pragma once
+#include "Arduino.h"
+
+// No I2C devices: every transfer NAKs.
+class TwoWire : public Stream {
+public:
+  void begin() {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }
+  uint8_t requestFrom(uint8_t, uint8_t, bool = true) { return 0; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+};
+
+extern TwoWire Wire;
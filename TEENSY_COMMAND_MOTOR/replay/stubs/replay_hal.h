@@ -0,0 +1,37 @@
+#pragma once
+// Host-side stand-ins for the Teensy core and libraries used by the
+// firmware, backed by a virtual clock the replay harness advances.
+// Only what TEENSY_COMMAND_MOTOR/src calls is provided.
+#include <stdint.h>
+#include <stddef.h>
+
+struct CAN_message_t;
+
+// ---------- Clock ----------
+uint64_t replayNowUs();
+// Moves the clock forward, firing every IntervalTimer that comes due on
+// the way (each firing is one "ISR", run to completion).
+void replayAdvance(uint32_t us);
+// Host-time cycle counter scaled to the Teensy's 600 MHz, so DWT traces
+// report how long the firmware code took on this machine.
+uint32_t replayCycles();
+
+// ---------- Pins ----------
+void replaySetPin(uint8_t pin, int value);  // digitalRead / analogRead / ADC DMA value
+int  replayPin(uint8_t pin);
+
+// ---------- CAN ----------
+// Delivers a frame as the controller would: through the FIFO interrupt
+// callback when the firmware registered one, otherwise into the read() queue.
+void replayCanReceive(const CAN_message_t &msg);  // on controller msg.bus (0 = Can1)
+typedef void (*ReplayCanTxHook)(const CAN_message_t &msg);
+void replayOnCanTx(ReplayCanTxHook hook);  // every frame the firmware writes, msg.bus set
+
+// ---------- Nextion (Serial7) ----------
+// Called with each complete command (terminator stripped).
+typedef void (*ReplayNextionHook)(const char *cmd, size_t len);
+void replayOnNextion(ReplayNextionHook hook);
+
+// ---------- SD ----------
+// SD.begin() fails unless a host path was set; the log file is written there.
+void replaySetSdPath(const char *path);
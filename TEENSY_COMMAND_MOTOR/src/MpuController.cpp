@@ -1,6 +1,39 @@
 #include "MpuController.h"
+#include "vehicle_state.h"
 
-MpuController::MpuController(Adafruit_MPU6050 mpu) : mpu(mpu) {}
+#define MPU_ADDR          0x68
+#define MPU_SMPLRT_DIV    0x19
+#define MPU_FIFO_EN       0x23
+#define MPU_INT_STATUS    0x3A
+#define MPU_USER_CTRL     0x6A
+#define MPU_FIFO_COUNTH   0x72
+#define MPU_FIFO_R_W      0x74
+
+#define MPU_FIFO_ACCEL_GYRO 0x78  // XG, YG, ZG, ACCEL
+#define MPU_USER_FIFO_EN    0x40
+#define MPU_USER_FIFO_RESET 0x04
+#define MPU_INT_FIFO_OFLOW  0x10
+
+#define MPU_FIFO_SAMPLE 12  // accel xyz, gyro xyz, int16 big-endian
+#define MPU_FIFO_CHUNK  24  // two samples per Wire transfer (32-byte buffer)
+
+static void writeReg(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(MPU_ADDR);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+static uint8_t readRegs(uint8_t reg, uint8_t *buf, uint8_t n) {
+  Wire.beginTransmission(MPU_ADDR);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) return 0;
+  uint8_t got = Wire.requestFrom((uint8_t)MPU_ADDR, n);
+  for (uint8_t i = 0; i < got; i++) buf[i] = Wire.read();
+  return got;
+}
+
+MpuController::MpuController(Adafruit_MPU6050 &mpu) : mpu(mpu) {}
 
 bool MpuController::begin() {
   bool mpu_found = false;
@@ -14,16 +47,56 @@ bool MpuController::begin() {
     nextionText(NX_BOOT_DETAIL, "MPU not found after 3 tries, continuing without");
     return false;
   }
-  
+
   mpu.setAccelerometerRange(MPU_ACCEL_RANGE);
   mpu.setGyroRange(MPU_GYRO_RANGE);
   mpu.setFilterBandwidth(MPU_FILTER_BW);
+
+  // Fast mode: a two-sample burst takes ~0.7 ms instead of ~2.5 ms.
+  Wire.setClock(400000);
+  // Gyro output rate is 1 kHz with the DLPF enabled.
+  writeReg(MPU_SMPLRT_DIV, 1000 / IMU_ODR_HZ - 1);
+  writeReg(MPU_FIFO_EN, MPU_FIFO_ACCEL_GYRO);
+  resetFifo();
+  ready = true;
+  return true;
+}
+
+void MpuController::resetFifo() {
+  writeReg(MPU_USER_CTRL, MPU_USER_FIFO_RESET);
+  writeReg(MPU_USER_CTRL, MPU_USER_FIFO_EN);
 }
 
-void MpuController::logTelemetry() {
-  sensors_event_t a, g, temp;
-  this->mpu.getEvent(&a, &g, &temp);
+// Drains up to IMU_MAX_SAMPLES_PER_RUN samples. The newest sample in the
+// FIFO was taken roughly now; older ones are one IMU period apart before it.
+void MpuController::service(bool log) {
+  if (!ready) return;
 
-  logIMU(a.acceleration.x, a.acceleration.y, a.acceleration.z,
-         g.gyro.x, g.gyro.y, g.gyro.z);
+  uint8_t buf[MPU_FIFO_CHUNK];
+  if (readRegs(MPU_INT_STATUS, buf, 1) != 1) return;
+  if (buf[0] & MPU_INT_FIFO_OFLOW) {
+    // Sample order is lost once the FIFO wraps; start clean.
+    overflows++;
+    resetFifo();
+    return;
+  }
+  if (readRegs(MPU_FIFO_COUNTH, buf, 2) != 2) return;
+  uint16_t count = ((uint16_t)buf[0] << 8 | buf[1]) / MPU_FIFO_SAMPLE;
+  if (count == 0) return;
+
+  uint32_t now = micros();
+  uint16_t n = count < IMU_MAX_SAMPLES_PER_RUN ? count : IMU_MAX_SAMPLES_PER_RUN;
+  for (uint16_t k = 0; k < n; ) {
+    uint8_t batch = (n - k) >= 2 ? 2 : 1;
+    uint8_t len = batch * MPU_FIFO_SAMPLE;
+    if (readRegs(MPU_FIFO_R_W, buf, len) != len) return;
+    for (uint8_t s = 0; s < batch; s++, k++) {
+      const uint8_t *p = buf + s * MPU_FIFO_SAMPLE;
+      int16_t raw[6];
+      for (uint8_t i = 0; i < 6; i++) raw[i] = (int16_t)(p[2 * i] << 8 | p[2 * i + 1]);
+      uint32_t tUs = now - (uint32_t)(count - 1 - k) * IMU_PERIOD_US;
+      vehicleStateImu(tUs, raw);
+      if (log) logIMU(tUs, raw);
+    }
+  }
 }
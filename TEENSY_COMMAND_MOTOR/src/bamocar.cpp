@@ -1,162 +1,95 @@
 #include "bamocar.h"
 #include "bamocar_registers.h"
-#include "logging.h"
-#include "temp_converters.h"
-
-void sendCAN(const CAN_message_t &msg) {
-  Can1.write(msg);
-  logCANFrame(msg, "TX");
-}
-
-void requestStatusCyclic(uint8_t interval_ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_STATUS;
-  msg.buf[2] = interval_ms;
-  sendCAN(msg);
-}
-
-void requestErrorsCyclic(uint8_t interval_ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_ERROR_WORD;
-  msg.buf[2] = interval_ms;
-  sendCAN(msg);
-}
-
-void requestStatusOnce() {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_STATUS;
-  msg.buf[2] = 0x00;
-  sendCAN(msg);
-}
-
-void requestSpeedCyclic(uint8_t interval_ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_SPEED_ACTUAL;
-  msg.buf[2] = interval_ms;
-  sendCAN(msg);
-}
-
-void requestCurrentCyclic(uint8_t interval_ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_CURRENT_ACTUAL;
-  msg.buf[2] = interval_ms;
-  sendCAN(msg);
+#include "irq_guard.h"
+#include "trace.h"
+#include "telemetry.h"
+
+// ---------- TX ----------
+// One preallocated frame per calling context, so the torque timer task never
+// patches a frame the loop is halfway through filling. Only the three
+// payload bytes change per send.
+enum { TX_LOOP, TX_ISR, TX_CONTEXTS };
+static CAN_message_t txMailbox[TX_CONTEXTS];
+
+// Called from both loop() and the scheduler's torque timer task. Returns
+// false when the inverter bus cannot take the frame (counted in
+// canBusStats(CAN_BUS_INVERTER).txDropped).
+bool sendCAN(const CAN_message_t &msg) {
+  if (!canWrite(CAN_BUS_INVERTER, msg)) return false;
+  traceWrite();
+  if (msg.id == BAMOCAR_RX_ID && msg.buf[0] == REG_TRANSMIT_REQUEST) traceRequest(msg.buf[1]);
+  return true;
 }
 
-void requestTempsCyclic(uint8_t interval_ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_TEMP_MOTOR;  // motor temp
-  msg.buf[2] = interval_ms;
-  sendCAN(msg);
-  msg.buf[1] = REG_TEMP_INVERTER;  // inverter (IGBT) temp
-  sendCAN(msg);
+static const CAN_message_t &frameFor(const bcmd::Frame &f) {
+  CAN_message_t &mb = txMailbox[inInterrupt() ? TX_ISR : TX_LOOP];
+  mb.id = BAMOCAR_RX_ID;
+  mb.len = 3;
+  mb.buf[0] = f.reg;
+  mb.buf[1] = f.lo;
+  mb.buf[2] = f.hi;
+  return mb;
 }
 
-void requestDCBusOnce() {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TRANSMIT_REQUEST;
-  msg.buf[1] = REG_DC_BUS_VOLTAGE;
-  msg.buf[2] = 0x00;
-  sendCAN(msg);
+// Torque frames take the inverter bus's reserved mailbox instead.
+static bool sendTorqueFrame(const bcmd::Frame &f) {
+  if (!canWriteTorque(frameFor(f))) return false;
+  traceWrite();
+  return true;
 }
 
-void clearErrors() {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_CLEAR_ERRORS;
-  msg.buf[1] = 0x00;
-  msg.buf[2] = 0x00;
-  sendCAN(msg);
-}
+namespace bcmd {
 
-void configureCanTimeout(uint16_t ms) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_CAN_TIMEOUT;
-  msg.buf[1] = ms & 0xFF;
-  msg.buf[2] = (ms >> 8) & 0xFF;
-  sendCAN(msg);
+bool send(const Frame &f) {
+  return sendCAN(frameFor(f));
 }
 
-void enableDrive() {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_DRIVE_COMMAND;
-  msg.buf[1] = 0x04;
-  msg.buf[2] = 0x00;
-  sendCAN(msg);
-  delay(100);
-  msg.buf[1] = 0x00;
-  sendCAN(msg);
+// Stops at the first frame the TX queue refuses; the rest are not sent.
+uint8_t sendBatch(const Frame *frames, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (!send(frames[i])) return i;
+  }
+  return count;
 }
 
-void disableDrive() {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_DRIVE_COMMAND;
-  msg.buf[1] = 0x04;
-  msg.buf[2] = 0x00;
-  sendCAN(msg);
+}  // namespace bcmd
+
+using bcmd::send;
+using bcmd::cmd;
+using bcmd::request;
+
+bool requestStatusCyclic(uint8_t interval_ms)  { return send(request(REG_STATUS, interval_ms)); }
+bool requestErrorsCyclic(uint8_t interval_ms)  { return send(request(REG_ERROR_WORD, interval_ms)); }
+bool requestStatusOnce()                       { return send(request(REG_STATUS)); }
+bool requestSpeedCyclic(uint8_t interval_ms)   { return send(request(REG_SPEED_ACTUAL, interval_ms)); }
+bool requestCurrentCyclic(uint8_t interval_ms) { return send(request(REG_CURRENT_ACTUAL, interval_ms)); }
+bool requestDCBusOnce()                        { return send(request(REG_DC_BUS_VOLTAGE)); }
+
+// Motor and inverter (IGBT) temperature.
+bool requestTempsCyclic(uint8_t interval_ms) {
+  const bcmd::Frame frames[] = {
+    request(REG_TEMP_MOTOR, interval_ms),
+    request(REG_TEMP_INVERTER, interval_ms),
+  };
+  return bcmd::sendBatch(frames, 2) == 2;
 }
 
-void sendTorqueCommand(int16_t torqueValue) {
-  CAN_message_t msg = {0};
-  msg.id = BAMOCAR_RX_ID;
-  msg.len = 3;
-  msg.buf[0] = REG_TORQUE_COMMAND;
-  msg.buf[1] = torqueValue & 0xFF;
-  msg.buf[2] = (torqueValue >> 8) & 0xFF;
-  sendCAN(msg);
+// Generic cyclic request for any register in BAMOCAR_REGISTERS.
+bool requestRegisterCyclic(uint8_t reg, uint8_t interval_ms) {
+  return send(request(reg, interval_ms));
 }
 
-// ---------- Error word lookup (RegID 0x8F, BAMOCAR-PG-D3 Manual) ----------
-static const char *const ERROR_NAMES[16] = {
-  "BADPARAS",     // bit 0  - Parameter damaged
-  "POWERFAULT",   // bit 1  - Hardware error
-  "RFE",          // bit 2  - Safety circuit faulty
-  "BUS TIMEOUT",  // bit 3  - CAN timeout exceeded
-  "FEEDBACK",     // bit 4  - Bad/wrong encoder signal
-  "POWERVOLTAGE", // bit 5  - Power voltage missing
-  "MOTORTEMP",    // bit 6  - Engine temperature too high
-  "DEVICETEMP",   // bit 7  - Unit temperature too high
-  "OVERVOLTAGE",  // bit 8  - Overvoltage
-  "I_PEAK",       // bit 9  - Overcurrent
-  "RACEAWAY",     // bit 10 - Spinning
-  "USER",         // bit 11 - User error selection
-  "",             // bit 12 - (unmapped)
-  "",             // bit 13 - (unmapped)
-  "HW_ERR",       // bit 14 - Current measurement error
-  "BALLAST"       // bit 15 - Ballast circuit overloaded
-};
+bool clearErrors()                     { return send(cmd<REG_CLEAR_ERRORS>()); }
+bool configureCanTimeout(uint16_t ms)  { return send(cmd<REG_CAN_TIMEOUT>(ms)); }
+bool enableDrive()                     { return send(cmd<REG_DRIVE_COMMAND>(bcmd::DRIVE_ENABLE)); }
+bool disableDrive()                    { return send(cmd<REG_DRIVE_COMMAND>(bcmd::DRIVE_LOCK)); }
+bool sendTorqueCommand(int16_t torque) { return sendTorqueFrame(cmd<REG_TORQUE_COMMAND>(torque)); }
 
+// ---------- Error word lookup ----------
 void bamocarErrorDescription(uint32_t errorWord, char *buf, size_t len) {
   for (int bit = 0; bit < 16; bit++) {
     if (errorWord & (1u << bit)) {
-      const char *name = (ERROR_NAMES[bit][0]) ? ERROR_NAMES[bit] : "UNKNOWN";
+      const char *name = (BAMOCAR_ERROR_NAMES[bit][0]) ? BAMOCAR_ERROR_NAMES[bit] : "UNKNOWN";
       strncpy(buf, name, len - 1);
       buf[len - 1] = '\0';
       return;
@@ -167,45 +100,31 @@ void bamocarErrorDescription(uint32_t errorWord, char *buf, size_t len) {
 }
 
 // ---------- CAN RX ----------
-void readCanMessages() {
-  CAN_message_t msg;
-  while (Can1.read(msg)) {
-    logCANFrame(msg, "RX");
-
-    if (msg.id == BAMOCAR_TX_ID && msg.len >= 3) {
-      lastBAMOCARRx = millis();
-      uint8_t reg = msg.buf[0];
-
-      if (reg == REG_STATUS) { // STATUS register
-        bamocarOnline = true;
-        statusWord = (int16_t)(msg.buf[1] | (msg.buf[2] << 8));
-      }
-
-      else if (reg == REG_SPEED_ACTUAL) { // RPM feedback (signed, normalised to NMAX)
-        rpmFeedback = (int16_t)(msg.buf[1] | (msg.buf[2] << 8));
-      }
-
-      else if (reg == REG_CURRENT_ACTUAL) { // I_ACT actual current (signed, normalised to IMAX)
-        actualCurrent = (int16_t)(msg.buf[1] | (msg.buf[2] << 8));
-      }
-
-      else if (reg == 0x49) { // motor temperature (°C)
-        uint16_t raw = msg.buf[1] | (msg.buf[2] << 8);
-        motorTemp = motorADCToTemp(raw);
-      }
-
-      else if (reg == 0x4A) { // inverter (IGBT) temperature (°C)
-        uint16_t raw = msg.buf[1] | (msg.buf[2] << 8);
-        inverterTemp = igbtADCToTemp(raw);
-      }
-
-      else if (reg == REG_DC_BUS_VOLTAGE) { // DC bus voltage (UDC = raw / 31.5848, per BAMOCAR FAQ)
-        dcBusVoltage = (msg.buf[1] | (msg.buf[2] << 8)) / 31.5848f;
-      }
-
-      else if (reg == REG_ERROR_WORD) { // Error register
-        bamocarErrorWord = msg.buf[1] | (msg.buf[2] << 8);
-      }
-    }
-  }
+// Per-register receive counters, one per BAMOCAR_REGISTERS row. The enable
+// sequence snapshots these to tell a fresh reply from a stale value.
+static uint16_t rxCount[BAMOCAR_REGISTER_COUNT];
+
+uint16_t bamocarRxCount(uint8_t reg) {
+  const BamocarRegister *r = bamocarRegister(reg);
+  return r ? rxCount[r - BAMOCAR_REGISTERS] : 0;
+}
+
+// Decodes one BAMOCAR frame (logged by can_bus). rxMs/rxCycles are the
+// time the frame arrived, which in interrupt mode can be well before
+// canBusService() runs.
+static void onBamocarFrame(const CanRxFrame &f) {
+  const CAN_message_t &msg = f.msg;
+  if (msg.len < 3) return;
+  lastBAMOCARRx = f.rxMs;
+  telemetryCanFrame(msg, f.rxMs);
+  // Register table lookup, see BAMOCAR_REGISTERS in bamocar_decoder.h.
+  const BamocarRegister *r = bamocarDecode(msg.buf, msg.len, bamocar);
+  if (!r) return;
+  rxCount[r - BAMOCAR_REGISTERS]++;
+  traceResponse(r->reg, f.rxCycles);
+  if (r->reg == REG_STATUS) bamocarOnline = true;
+}
+
+void bamocarBegin() {
+  canRoute(CAN_BUS_INVERTER, BAMOCAR_TX_ID, BAMOCAR_TX_ID, onBamocarFrame);
 }
@@ -0,0 +1,167 @@
+#include "bamocar_rates.h"
+#include "bamocar.h"
+#include "bamocar_registers.h"
+
+// ---------- Streams ----------
+// priority: 0 is trimmed last. hotMs: interval at the derate point for
+// temperature streams, which otherwise use idleMs in both states. DC bus
+// voltage is not here: dcBusTask polls it.
+struct RateStream {
+  uint8_t reg;
+  uint8_t priority;
+  uint8_t idleMs;
+  uint8_t driveMs;
+  uint8_t hotMs;
+};
+
+static const RateStream STREAMS[] = {
+  // reg                 prio idle drive hot
+  { REG_STATUS,          0,   100,  50,   0 },
+  { REG_ERROR_WORD,      0,   100,  50,   0 },
+  { REG_SPEED_ACTUAL,    1,   100,  10,   0 },
+  { REG_CURRENT_ACTUAL,  1,   100,  10,   0 },
+  { REG_TORQUE_ACTUAL,   2,   100,  20,   0 },
+  { REG_POWER,           3,   200,  50,   0 },
+  { REG_TEMP_MOTOR,      4,   250,  250,  50 },
+  { REG_TEMP_INVERTER,   4,   250,  250,  50 },
+};
+static const uint8_t STREAM_COUNT = sizeof(STREAMS) / sizeof(STREAMS[0]);
+
+struct RateState {
+  uint8_t  target;     // this tick's interval
+  uint8_t  sent;       // last accepted request, 0 = none
+  bool     pending;    // request still to be sent
+  uint32_t changedMs;  // when sent last changed
+  uint16_t rxSeen;     // bamocarRxCount() at the start of the window
+  uint16_t received;
+  uint16_t reissues;
+};
+
+static RateState _state[STREAM_COUNT];
+static bool     _active = false;
+static uint32_t _lastTickMs = 0;
+static uint32_t _windowMs = 0;
+static uint8_t  _loadPercent = 0;
+
+// ---------- Targets ----------
+// Linear from idleMs at TEMP_DERATE_WINDOW_C below derate to hotMs at it.
+static uint8_t tempInterval(const RateStream &s) {
+  float t = s.reg == REG_TEMP_MOTOR ? bamocar.motorTemp : bamocar.inverterTemp;
+  float derate = s.reg == REG_TEMP_MOTOR ? MOTOR_TEMP_DERATE_C : IGBT_TEMP_DERATE_C;
+  float f = (t - (derate - TEMP_DERATE_WINDOW_C)) / TEMP_DERATE_WINDOW_C;
+  if (f <= 0.0f) return s.idleMs;
+  if (f >= 1.0f) return s.hotMs;
+  return (uint8_t)(s.idleMs - f * (s.idleMs - s.hotMs));
+}
+
+static uint32_t loadBits(const uint8_t *interval) {
+  uint32_t bits = canFrameBits(3) * (1000000 / TORQUE_PERIOD_US);
+  for (uint8_t i = 0; i < STREAM_COUNT; i++) {
+    const BamocarRegister *r = bamocarRegister(STREAMS[i].reg);
+    bits += canFrameBits(1 + (r ? r->width : 2)) * 1000 / interval[i];
+  }
+  return bits;
+}
+
+// Doubles the least important interval still below the cap until the
+// plan fits RATE_BUDGET_PERCENT.
+static void assignTargets() {
+  uint8_t interval[STREAM_COUNT];
+  for (uint8_t i = 0; i < STREAM_COUNT; i++) {
+    const RateStream &s = STREAMS[i];
+    interval[i] = s.hotMs ? tempInterval(s) : (driveEnabled ? s.driveMs : s.idleMs);
+  }
+
+  const uint32_t budget = (uint32_t)CAN_INVERTER_BAUD / 100 * RATE_BUDGET_PERCENT;
+  uint32_t bits = loadBits(interval);
+  while (bits > budget) {
+    int victim = -1;
+    for (uint8_t i = 0; i < STREAM_COUNT; i++) {
+      if (interval[i] >= BAMOCAR_CYCLIC_MAX_MS) continue;
+      if (victim < 0 || STREAMS[i].priority >= STREAMS[victim].priority) victim = i;
+    }
+    if (victim < 0) break;  // everything at the slowest interval
+    uint16_t slower = interval[victim] * 2;
+    interval[victim] = slower > BAMOCAR_CYCLIC_MAX_MS ? BAMOCAR_CYCLIC_MAX_MS : (uint8_t)slower;
+    bits = loadBits(interval);
+  }
+  _loadPercent = (uint8_t)(bits * 100 / CAN_INVERTER_BAUD);
+
+  for (uint8_t i = 0; i < STREAM_COUNT; i++) _state[i].target = interval[i];
+}
+
+// ---------- Arrival check ----------
+static void checkArrivals() {
+  for (uint8_t i = 0; i < STREAM_COUNT; i++) {
+    RateState &st = _state[i];
+    uint16_t count = bamocarRxCount(STREAMS[i].reg);
+    st.received = count - st.rxSeen;
+    st.rxSeen = count;
+    // Only judge streams whose interval held for the whole window.
+    if (st.sent == 0 || st.pending || (int32_t)(st.changedMs - _windowMs) > 0) continue;
+    if (st.received < RATE_CHECK_MS / st.sent / 2) {
+      st.pending = true;
+      st.reissues++;
+    }
+  }
+}
+
+// ---------- API ----------
+void bamocarRatesStart() {
+  for (RateState &st : _state) {
+    st.sent = 0;
+    st.pending = true;
+  }
+  _active = true;
+  _lastTickMs = millis() - RATE_TICK_MS;  // first tick now
+  _windowMs = millis();
+}
+
+void bamocarRatesTick() {
+  if (!_active) return;
+  uint32_t now = millis();
+  if (now - _lastTickMs < RATE_TICK_MS) return;
+  _lastTickMs = now;
+
+  assignTargets();
+  if (now - _windowMs >= RATE_CHECK_MS) {
+    checkArrivals();
+    _windowMs = now;
+  }
+
+  for (uint8_t i = 0; i < STREAM_COUNT; i++) {
+    RateState &st = _state[i];
+    uint8_t want = st.sent;
+    if (st.sent == 0 || st.target < st.sent) want = st.target;
+    else if (st.target > st.sent && now - st.changedMs >= RATE_SLOWDOWN_HOLD_MS) want = st.target;
+    if (want == st.sent && !st.pending) continue;
+    // A refused request stays pending for the next tick.
+    if (!bcmd::send(bcmd::request(STREAMS[i].reg, want))) {
+      st.pending = true;
+      continue;
+    }
+    if (want != st.sent) st.changedMs = now;
+    st.sent = want;
+    st.pending = false;
+  }
+}
+
+uint8_t bamocarRateCount() {
+  return STREAM_COUNT;
+}
+
+BamocarRateInfo bamocarRateInfo(uint8_t i) {
+  BamocarRateInfo info = {};
+  if (i >= STREAM_COUNT) return info;
+  const RateState &st = _state[i];
+  info.reg        = STREAMS[i].reg;
+  info.intervalMs = st.sent;
+  info.received   = st.received;
+  info.expected   = st.sent ? RATE_CHECK_MS / st.sent : 0;
+  info.reissues   = st.reissues;
+  return info;
+}
+
+uint8_t bamocarRateLoadPercent() {
+  return _loadPercent;
+}
@@ -0,0 +1,228 @@
+#include "can_bus.h"
+#include "can_stats.h"
+#include "fault_capture.h"
+#include "logging.h"
+#include "spsc_queue.h"
+#include "irq_guard.h"
+#include "trace.h"
+
+static CanBusStats stats[CAN_BUS_COUNT];
+
+static bool busLogged(uint8_t bus)   { return CAN_LOG_BUSES & (1u << bus); }
+static bool busFiltered(uint8_t bus) { return CAN_FILTER_BUSES & (1u << bus); }
+
+uint8_t canBusNumber(uint8_t bus) {
+  return bus + 1;  // CAN_BUS_INVERTER is Can1, and so on
+}
+
+CanBusStats canBusStats(uint8_t bus) {
+  IrqGuard lock;
+  return stats[bus];
+}
+
+// ---------- Routes ----------
+struct CanRoute {
+  uint16_t first;
+  uint16_t last;
+  CanRxHandler handler;
+};
+
+static CanRoute routes[CAN_BUS_COUNT][CAN_MAX_ROUTES];
+static uint8_t routeCount[CAN_BUS_COUNT];
+
+bool canRoute(uint8_t bus, uint16_t first, uint16_t last, CanRxHandler handler) {
+  if (bus >= CAN_BUS_COUNT || routeCount[bus] >= CAN_MAX_ROUTES) return false;
+  routes[bus][routeCount[bus]++] = { first, last, handler };
+  return true;
+}
+
+// Logs and captures the frame (fault_capture.h), then hands it to the
+// first route that covers its ID.
+static void dispatch(const CanRxFrame &f) {
+  CanBusStats &s = stats[f.bus];
+  s.rxFrames++;
+  canStatsRx(f);
+  captureCan(f.msg, false, f.bus, f.rxUs);
+  if (busLogged(f.bus)) logCANFrame(f.msg, "RX", canBusNumber(f.bus));
+  if (!f.msg.flags.extended) {
+    for (uint8_t i = 0; i < routeCount[f.bus]; i++) {
+      const CanRoute &r = routes[f.bus][i];
+      if (f.msg.id >= r.first && f.msg.id <= r.last) {
+        r.handler(f);
+        return;
+      }
+    }
+  }
+  s.unrouted++;
+}
+
+// ---------- RX ----------
+#if CAN_RX_MODE == CAN_RX_INTERRUPT
+static SpscQueue<CanRxFrame, CAN_RX_QUEUE_LEN> rxQueue[CAN_BUS_COUNT];
+
+// FIFO interrupt, one instance per bus: copy out and return. Logging and
+// routing happen in canBusService() on the main thread.
+template <uint8_t B>
+static void onCanRx(const CAN_message_t &msg) {
+  CanRxFrame f;
+  f.msg  = msg;
+  f.rxUs = micros();
+  f.rxMs = millis();
+  f.rxCycles = traceNow();
+  f.bus  = B;
+  if (!rxQueue[B].push(f) || msg.flags.overrun) stats[B].rxDropped++;
+}
+#else
+static int readBus(uint8_t bus, CAN_message_t &msg) {
+  switch (bus) {
+    case CAN_BUS_INVERTER: return Can1.read(msg);
+    case CAN_BUS_ACCU:     return Can2.read(msg);
+#if !CAN_FD_TELEMETRY
+    case CAN_BUS_DASH:     return Can3.read(msg);
+#endif
+    default:               return 0;
+  }
+}
+#endif
+
+// ---------- TX ----------
+// Inverter bus: frames that found CAN_TX_MB_FIRST..LAST all busy wait here
+// until canBusService() or the next canWrite() moves them on. Only touched
+// with interrupts masked. CAN_TORQUE_MB is never used for these.
+static CAN_message_t txQueue[CAN_TX_QUEUE_LEN];
+static uint16_t txHead = 0, txTail = 0;
+static_assert((CAN_TX_QUEUE_LEN & (CAN_TX_QUEUE_LEN - 1)) == 0, "CAN_TX_QUEUE_LEN must be a power of two");
+
+static bool fillMailbox(const CAN_message_t &msg) {
+  for (int mb = CAN_TX_MB_FIRST; mb <= CAN_TX_MB_LAST; mb++) {
+    if (Can1.write((FLEXCAN_MAILBOX)mb, msg)) return true;
+  }
+  return false;
+}
+
+static void flushTxQueue() {
+  while (txTail != txHead && fillMailbox(txQueue[txTail])) {
+    txTail = (txTail + 1) & (CAN_TX_QUEUE_LEN - 1);
+  }
+}
+
+static bool queueTx(const CAN_message_t &msg) {
+  uint16_t next = (txHead + 1) & (CAN_TX_QUEUE_LEN - 1);
+  if (next == txTail) return false;
+  txQueue[txHead] = msg;
+  txHead = next;
+  return true;
+}
+
+// The other buses use FlexCAN_T4's own TX queue (TX_SIZE_16).
+static int writeBus(uint8_t bus, const CAN_message_t &msg) {
+  switch (bus) {
+    case CAN_BUS_INVERTER:
+      flushTxQueue();
+      if (txHead == txTail && fillMailbox(msg)) return 1;
+      canStatsTxBusy(bus);
+      return queueTx(msg);
+    case CAN_BUS_ACCU: return Can2.write(msg);
+#if !CAN_FD_TELEMETRY
+    case CAN_BUS_DASH: return Can3.write(msg);
+#endif
+    default:           return 0;
+  }
+}
+
+bool canWrite(uint8_t bus, const CAN_message_t &msg) {
+  if (bus >= CAN_BUS_COUNT) return false;
+  bool ok;
+  {
+    IrqGuard lock;
+    ok = writeBus(bus, msg);
+    if (ok) stats[bus].txFrames++;
+    else    stats[bus].txDropped++;
+    canStatsTx(bus, msg, ok);
+  }
+  if (ok) captureCan(msg, true, bus, micros());
+  if (ok && busLogged(bus)) logCANFrame(msg, "TX", canBusNumber(bus));
+  return ok;
+}
+
+// Sent every TORQUE_PERIOD_US and on the wire for well under that, so the
+// mailbox is only busy if the previous torque frame could not get out
+// (bus off, no ACK); the new value is then refused rather than queued.
+bool canWriteTorque(const CAN_message_t &msg) {
+  bool ok;
+  {
+    IrqGuard lock;
+    ok = Can1.write(CAN_TORQUE_MB, msg);
+    if (ok) stats[CAN_BUS_INVERTER].txFrames++;
+    else    stats[CAN_BUS_INVERTER].txDropped++;
+    canStatsTx(CAN_BUS_INVERTER, msg, ok);
+  }
+  if (ok) captureCan(msg, true, CAN_BUS_INVERTER, micros());
+  if (ok && busLogged(CAN_BUS_INVERTER)) logCANFrame(msg, "TX", canBusNumber(CAN_BUS_INVERTER));
+  return ok;
+}
+
+// ---------- Setup ----------
+template <typename Can>
+static void beginBus(Can &can, uint8_t bus, uint32_t baud, _MB_ptr onRx) {
+  can.begin();
+  can.setBaudRate(baud);
+#if CAN_RX_MODE == CAN_RX_INTERRUPT
+  can.enableFIFO();
+  can.enableFIFOInterrupt();
+  if (busFiltered(bus) && routeCount[bus] <= CAN_FIFO_FILTERS) {
+    can.setFIFOFilter(REJECT_ALL);
+    for (uint8_t i = 0; i < routeCount[bus]; i++) {
+      const CanRoute &r = routes[bus][i];
+      if (r.first == r.last) can.setFIFOFilter(i, r.first, STD);
+      else                   can.setFIFOFilterRange(i, r.first, r.last, STD);
+    }
+  } else {
+    can.setFIFOFilter(ACCEPT_ALL);
+  }
+  can.onReceive(onRx);
+#else
+  (void)bus;
+  (void)onRx;
+#endif
+}
+
+void canBusBegin() {
+#if CAN_RX_MODE == CAN_RX_INTERRUPT
+  beginBus(Can1, CAN_BUS_INVERTER, CAN_INVERTER_BAUD, onCanRx<CAN_BUS_INVERTER>);
+  beginBus(Can2, CAN_BUS_ACCU,     CAN_ACCU_BAUD,     onCanRx<CAN_BUS_ACCU>);
+#if !CAN_FD_TELEMETRY
+  beginBus(Can3, CAN_BUS_DASH,     CAN_DASH_BAUD,     onCanRx<CAN_BUS_DASH>);
+#endif
+#else
+  beginBus(Can1, CAN_BUS_INVERTER, CAN_INVERTER_BAUD, nullptr);
+  beginBus(Can2, CAN_BUS_ACCU,     CAN_ACCU_BAUD,     nullptr);
+#if !CAN_FD_TELEMETRY
+  beginBus(Can3, CAN_BUS_DASH,     CAN_DASH_BAUD,     nullptr);
+#endif
+#endif
+  // Inverter TX mailboxes are written individually, see canWrite().
+  Can1.setMB(CAN_TORQUE_MB, TX);
+  for (int mb = CAN_TX_MB_FIRST; mb <= CAN_TX_MB_LAST; mb++) Can1.setMB((FLEXCAN_MAILBOX)mb, TX);
+}
+
+void canBusService() {
+  canStatsPoll();
+  for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+#if CAN_RX_MODE == CAN_RX_INTERRUPT
+    CanRxFrame f;
+    while (rxQueue[bus].pop(f)) dispatch(f);
+#else
+    CanRxFrame f;
+    f.bus = bus;
+    while (readBus(bus, f.msg)) {
+      f.rxUs = micros();
+      f.rxMs = millis();
+      f.rxCycles = traceNow();
+      dispatch(f);
+    }
+#endif
+  }
+  IrqGuard lock;
+  flushTxQueue();
+}
@@ -0,0 +1,284 @@
+#include "can_stats.h"
+#include "logging.h"
+#include "irq_guard.h"
+
+// ESR1 fields (i.MX RT1060 reference manual, FlexCAN chapter).
+#define ESR1_BOFFINT      (1u << 2)   // latched on entering bus off, write 1 to clear
+#define ESR1_FLTCONF(esr) (((esr) >> 4) & 0x3)
+
+static const uint32_t BUS_BAUD[CAN_BUS_COUNT] = {
+  CAN_INVERTER_BAUD,
+  CAN_ACCU_BAUD,
+#if !CAN_FD_TELEMETRY
+  CAN_DASH_BAUD,
+#endif
+};
+static const CAN_DEV_TABLE BUS_DEV[CAN_BUS_COUNT] = {
+  CAN1,
+  CAN2,
+#if !CAN_FD_TELEMETRY
+  CAN3,
+#endif
+};
+
+// ---------- Stuffed length ----------
+// SOF through CRC is stuffed: after five equal bits the transmitter inserts
+// their complement, which starts the next run. CRC delimiter, ACK slot and
+// delimiter, EOF and intermission (13 bits) are not.
+namespace {
+struct BitStream {
+  uint16_t bits = 0;
+  uint16_t crc = 0;
+  uint8_t  last = 2;  // no previous bit
+  uint8_t  run = 0;
+
+  void put(uint32_t value, uint8_t n, bool crcCovered = true) {
+    while (n--) {
+      uint8_t b = (value >> n) & 1;
+      if (crcCovered) {
+        bool x = b ^ ((crc >> 14) & 1);
+        crc = (crc << 1) & 0x7FFF;
+        if (x) crc ^= 0x4599;  // CRC-15/CAN
+      }
+      bits++;
+      if (b == last) {
+        run++;
+      } else {
+        last = b;
+        run = 1;
+      }
+      if (run == 5) {
+        bits++;
+        last = !b;
+        run = 1;
+      }
+    }
+  }
+};
+}
+
+uint16_t canStuffedBits(const CAN_message_t &msg) {
+  BitStream s;
+  uint8_t dlc = msg.len > 8 ? 8 : msg.len;
+  bool remote = msg.flags.remote;
+  s.put(0, 1);  // SOF
+  if (msg.flags.extended) {
+    s.put(msg.id >> 18, 11);
+    s.put(0x3, 2);  // SRR, IDE
+    s.put(msg.id & 0x3FFFF, 18);
+    s.put(remote, 1);
+    s.put(0, 2);  // r1, r0
+  } else {
+    s.put(msg.id, 11);
+    s.put(remote, 1);
+    s.put(0, 2);  // IDE, r0
+  }
+  s.put(dlc, 4);
+  if (!remote) {
+    for (uint8_t i = 0; i < dlc; i++) s.put(msg.buf[i], 8);
+  }
+  s.put(s.crc, 15, false);
+  return s.bits + 13;
+}
+
+// ---------- Counters ----------
+struct BusCounter {
+  uint32_t bits;
+  uint32_t slice;      // millis() / CAN_STATS_PEAK_MS of sliceBits
+  uint32_t sliceBits;
+  uint32_t peakBits;
+  uint32_t rxFrames;
+  uint32_t txFrames;
+  uint32_t txBusy;
+  uint32_t txDropped;
+};
+
+struct IdCounter {
+  CanIdSummary s;
+  uint32_t lastUs;
+  bool     timed;  // lastUs holds a frame, possibly from an earlier window
+};
+
+struct ErrorCounter {
+  uint8_t  tec;
+  uint8_t  rec;
+  uint8_t  state;
+  uint32_t busOffEvents;
+};
+
+static BusCounter   _bus[CAN_BUS_COUNT];
+static IdCounter    _ids[CAN_STATS_IDS];
+static uint8_t      _idCount = 0;
+static ErrorCounter _errors[CAN_BUS_COUNT];
+static uint32_t     _windowMs = 0;
+
+static CanLoadSummary _last[CAN_BUS_COUNT];
+static CanIdSummary   _lastIds[CAN_STATS_IDS];
+static uint8_t        _lastIdCount = 0;
+
+// Caller holds the IrqGuard.
+static void addBits(BusCounter &b, uint32_t bits, uint32_t ms) {
+  uint32_t slice = ms / CAN_STATS_PEAK_MS;
+  if ((int32_t)(slice - b.slice) > 0) {
+    if (b.sliceBits > b.peakBits) b.peakBits = b.sliceBits;
+    b.slice = slice;
+    b.sliceBits = 0;
+  }
+  b.sliceBits += bits;  // a frame dispatched late still counts, in the current slice
+  b.bits += bits;
+}
+
+static void countId(uint8_t bus, const CAN_message_t &msg, bool tx, uint32_t us) {
+  const uint8_t number = canBusNumber(bus);
+  IdCounter *c = nullptr;
+  for (uint8_t i = 0; i < _idCount; i++) {
+    const CanIdSummary &s = _ids[i].s;
+    if (s.id == msg.id && s.bus == number && s.tx == tx && s.extended == msg.flags.extended) {
+      c = &_ids[i];
+      break;
+    }
+  }
+  if (!c) {
+    if (_idCount >= CAN_STATS_IDS) return;  // still counted in the bus load
+    c = &_ids[_idCount++];
+    memset(c, 0, sizeof(*c));
+    c->s.id       = msg.id;
+    c->s.bus      = number;
+    c->s.tx       = tx;
+    c->s.extended = msg.flags.extended;
+  }
+  if (c->timed) {
+    uint32_t gap = us - c->lastUs;
+    if (c->s.minGapUs == 0 || gap < c->s.minGapUs) c->s.minGapUs = gap;
+    if (gap > c->s.maxGapUs) c->s.maxGapUs = gap;
+  }
+  c->lastUs = us;
+  c->timed = true;
+  c->s.frames++;
+}
+
+void canStatsRx(const CanRxFrame &f) {
+  uint16_t bits = canStuffedBits(f.msg);
+  IrqGuard lock;
+  BusCounter &b = _bus[f.bus];
+  b.rxFrames++;
+  addBits(b, bits, f.rxMs);
+  countId(f.bus, f.msg, false, f.rxUs);
+}
+
+void canStatsTx(uint8_t bus, const CAN_message_t &msg, bool ok) {
+  if (bus >= CAN_BUS_COUNT) return;
+  IrqGuard lock;
+  BusCounter &b = _bus[bus];
+  if (!ok) {
+    b.txDropped++;
+    return;
+  }
+  b.txFrames++;
+  addBits(b, canStuffedBits(msg), millis());
+  countId(bus, msg, true, micros());
+}
+
+void canStatsTxBusy(uint8_t bus) {
+  IrqGuard lock;
+  _bus[bus].txBusy++;
+}
+
+// ECR holds TEC in bits 0-7 and REC in 8-15. A bus-off that recovers
+// between two polls still leaves BOFFINT set.
+void canStatsPoll() {
+  for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+    uint32_t ecr = FLEXCANb_ECR(BUS_DEV[bus]);
+    uint32_t esr = FLEXCANb_ESR1(BUS_DEV[bus]);
+    ErrorCounter &e = _errors[bus];
+    uint8_t tec = ecr & 0xFF;
+    uint8_t rec = (ecr >> 8) & 0xFF;
+    uint8_t fault = ESR1_FLTCONF(esr);
+    uint8_t state = fault == 0 ? CAN_ERROR_ACTIVE : fault == 1 ? CAN_ERROR_PASSIVE : CAN_BUS_OFF;
+    if (esr & ESR1_BOFFINT) {
+      FLEXCANb_ESR1(BUS_DEV[bus]) = ESR1_BOFFINT;
+      e.busOffEvents++;
+      state = CAN_BUS_OFF;
+    }
+    if (tec > e.tec) e.tec = tec;
+    if (rec > e.rec) e.rec = rec;
+    if (state > e.state) e.state = state;
+  }
+}
+
+// ---------- Reporting ----------
+static uint16_t permille(uint32_t bits, uint32_t baud, uint32_t ms) {
+  if (ms == 0) return 0;
+  uint64_t p = (uint64_t)bits * 1000000 / ((uint64_t)baud * ms);
+  return p > 1000 ? 1000 : (uint16_t)p;
+}
+
+void canStatsLog() {
+  static IdCounter ids[CAN_STATS_IDS];  // too large for the stack of a cooperative task
+  BusCounter bus[CAN_BUS_COUNT];
+  uint8_t idCount;
+  {
+    IrqGuard lock;
+    memcpy(bus, _bus, sizeof(bus));
+    for (BusCounter &b : _bus) {
+      b.bits = b.sliceBits = b.peakBits = 0;
+      b.rxFrames = b.txFrames = b.txBusy = b.txDropped = 0;
+    }
+    idCount = _idCount;
+    memcpy(ids, _ids, idCount * sizeof(IdCounter));
+    for (uint8_t i = 0; i < idCount; i++) {
+      _ids[i].s.frames = _ids[i].s.minGapUs = _ids[i].s.maxGapUs = 0;
+    }
+  }
+  uint32_t now = millis();
+  uint32_t elapsed = now - _windowMs;
+  _windowMs = now;
+
+  for (uint8_t i = 0; i < CAN_BUS_COUNT; i++) {
+    const BusCounter &b = bus[i];
+    ErrorCounter &e = _errors[i];
+    CanLoadSummary &s = _last[i];
+    s.loadPermille = permille(b.bits, BUS_BAUD[i], elapsed);
+    s.peakPermille = permille(b.peakBits > b.sliceBits ? b.peakBits : b.sliceBits,
+                              BUS_BAUD[i], CAN_STATS_PEAK_MS);
+    s.rxFrames     = b.rxFrames;
+    s.txFrames     = b.txFrames;
+    s.txBusy       = b.txBusy;
+    s.txDropped    = b.txDropped;
+    s.tec          = e.tec;
+    s.rec          = e.rec;
+    s.state        = e.state;
+    s.busOffEvents = e.busOffEvents;
+    e.tec = e.rec = e.state = 0;
+    e.busOffEvents = 0;
+    logCanLoad(canBusNumber(i), s);
+  }
+
+  _lastIdCount = 0;
+  for (uint8_t i = 0; i < idCount; i++) {
+    if (ids[i].s.frames == 0) continue;
+    logCanId(ids[i].s);
+    _lastIds[_lastIdCount++] = ids[i].s;
+  }
+  canStatsPoll();  // next window starts from the current error state
+}
+
+const CanLoadSummary &canStatsLast(uint8_t bus) {
+  return _last[bus];
+}
+
+uint8_t canStatsBusiest(CanIdSummary *out, uint8_t max) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _lastIdCount; i++) {
+    const CanIdSummary &s = _lastIds[i];
+    if (n < max)                            out[n++] = s;
+    else if (n > 0 && s.frames > out[n - 1].frames) out[n - 1] = s;
+    else                                    continue;
+    for (uint8_t j = n - 1; j > 0 && out[j - 1].frames < out[j].frames; j--) {
+      CanIdSummary t = out[j - 1];
+      out[j - 1] = out[j];
+      out[j] = t;
+    }
+  }
+  return n;
+}
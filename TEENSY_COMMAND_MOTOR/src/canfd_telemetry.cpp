@@ -0,0 +1,75 @@
+#include "canfd_telemetry.h"
+#include "telemetry_link.h"
+
+#if CAN_FD_TELEMETRY
+static CanFdFrame _pending = {};
+static uint8_t    _seq = 0;
+static uint32_t   _pendingSinceUs = 0;
+static uint32_t   _lastHeaderMs = 0;
+static bool       _headerSent = false;
+static CanFdStats _stats = {};
+
+void canFdBegin() {
+  CanFD.begin();
+  CANFD_timings_t timing;
+  timing.baudrate   = CANFD_ARB_BAUD;
+  timing.baudrateFD = CANFD_DATA_BAUD;
+  timing.propdelay  = 190;
+  timing.bus_length = 1;
+  timing.sample     = 75;
+  CanFD.setBaudRate(timing);
+  CanFD.setRegions(64);  // 64-byte mailboxes
+}
+
+const CanFdStats &canFdStats() {
+  return _stats;
+}
+
+static void flush() {
+  if (_pending.count == 0) return;
+  _pending.seq = _seq++;  // advances on a drop too, so the logger sees the gap
+  CANFD_message_t msg;
+  msg.id  = CANFD_TELEMETRY_ID;
+  msg.len = sizeof(CanFdFrame);
+  msg.brs = 1;
+  msg.edl = 1;
+  memcpy(msg.buf, &_pending, sizeof(CanFdFrame));
+  if (CanFD.write(msg)) _stats.frames++;
+  else                  _stats.dropped++;
+  memset(&_pending, 0, sizeof(_pending));
+}
+
+void canFdRecord(const LogRecord &rec) {
+  if (_pending.count == 0) _pendingSinceUs = micros();
+  _pending.rec[_pending.count++] = rec;
+  if (_pending.count == CANFD_RECORDS_PER_FRAME) flush();
+}
+
+void canFdState() {
+  uint32_t now = millis();
+  if (!_headerSent || now - _lastHeaderMs >= CANFD_HEADER_MS) {
+    canFdRecord(logHeaderRecord());
+    _lastHeaderMs = now;
+    _headerSent = true;
+  }
+
+  LogRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.t_us   = micros();
+  rec.type   = LOG_REC_BAMOCAR;
+  rec.len    = (driveEnabled ? TL_FLAG_DRIVE : 0) | (bamocarOnline ? TL_FLAG_ONLINE : 0) |
+               (pedalFault ? TL_FLAG_PEDAL : 0);
+  rec.id     = (uint16_t)bamocar.errorWord;
+  rec.s16[0] = bamocar.rpmFeedback;
+  rec.s16[1] = bamocar.actualCurrent;
+  rec.s16[2] = bamocar.torqueActual;
+  rec.s16[3] = bamocar.power;
+  rec.s16[4] = (int16_t)(bamocar.motorTemp * 10.0f);
+  rec.s16[5] = (int16_t)(bamocar.inverterTemp * 10.0f);
+  canFdRecord(rec);
+}
+
+void canFdService() {
+  if (_pending.count > 0 && micros() - _pendingSinceUs >= CANFD_FLUSH_US) flush();
+}
+#endif
@@ -0,0 +1,217 @@
+#include "drive_sequence.h"
+#include "bamocar.h"
+#include "bamocar_rates.h"
+#include "bamocar_registers.h"
+#include "nextion.h"
+#include "button.h"
+#include "pedal.h"
+
+static DriveSeqState _state = SEQ_SPLASH;
+static bool     _reenable = false;  // re-enable skips steps 1-2 and the hold
+static uint32_t _enteredMs = 0;
+static uint32_t _requestMs = 0;
+static uint16_t _statusSeen = 0;    // bamocarRxCount(REG_STATUS) on entry
+static uint16_t _ackSeen = 0;       // bamocarRxCount(REG_DC_BUS_VOLTAGE) on entry
+static bool     _holding = false;   // t_detail currently shows the hold bar
+
+// Enters state s; acked() waits for a DC bus frame from now on.
+static void enter(DriveSeqState s) {
+  _state = s;
+  _enteredMs = _requestMs = millis();
+  _statusSeen = bamocarRxCount(REG_STATUS);
+  _ackSeen = bamocarRxCount(REG_DC_BUS_VOLTAGE);
+}
+
+// Each command is followed by a one-shot DC bus request, and its reply is
+// the acknowledgement. Status and error frames can't be: bamocar_rates
+// streams them, so one may arrive before the BAMOCAR has even seen the
+// command. The DC bus is not streamed and dcBusTask() waits for the
+// sequence, so a DC bus frame can only answer our request, and the
+// BAMOCAR handles frames in arrival order. Command and request leave
+// through different TX mailboxes, which need not go out in the order they
+// were written: SEQ_ACK_MIN_MS covers that.
+static void requestAck() {
+  requestDCBusOnce();
+}
+
+// True once the DC bus reply has arrived since enter() and SEQ_ACK_MIN_MS
+// have passed, or after SEQ_ACK_TIMEOUT_MS.
+static bool acked() {
+  uint32_t elapsed = millis() - _enteredMs;
+  return (bamocarRxCount(REG_DC_BUS_VOLTAGE) != _ackSeen && elapsed >= SEQ_ACK_MIN_MS) ||
+         elapsed >= SEQ_ACK_TIMEOUT_MS;
+}
+
+static bool freshStatus() {
+  return bamocarRxCount(REG_STATUS) != _statusSeen;
+}
+
+// Sends a status request every ms while waiting: keeps the BAMOCAR CAN
+// timeout from expiring and produces the next acknowledgement.
+static void poll(uint32_t ms) {
+  if (millis() - _requestMs >= ms) {
+    requestStatusOnce();
+    _requestMs = millis();
+  }
+}
+
+static void toHold(const char *phase, const char *detail) {
+  nextionBootStatus(phase, detail);
+  buttonResetHold();
+  _holding = false;
+  enter(SEQ_WAIT_HOLD);
+}
+
+void driveSeqBegin() {
+  _reenable = false;
+  currentStep = 0;
+  enter(SEQ_SPLASH);
+}
+
+// Mirrors startup steps 3-7 with the short CAN timeout. currentStep stays
+// at 7, so the torque task keeps sending zero torque as the watchdog feed.
+void driveSeqReenable() {
+  _reenable = true;
+  nextionPage(NX_PAGE_BOOT);
+  nextionBootStatus("RE-ENABLE", "clearing errors...");
+  bamocarRatesStart();
+  clearErrors();
+  requestAck();
+  enter(SEQ_CLEAR_ERRORS);
+}
+
+bool driveSeqActive() {
+  return _state != SEQ_RUNNING;
+}
+
+DriveSeqState driveSeqState() {
+  return _state;
+}
+
+void driveSeqTick() {
+  switch (_state) {
+    case SEQ_SPLASH:
+      if (millis() - _enteredMs < SEQ_SPLASH_MS) break;
+      nextionBootStatus("PRESS TO START", "press to continue");
+      enter(SEQ_WAIT_START);
+      break;
+
+    // --- Step 1: press to start, wait for BAMOCAR ---
+    case SEQ_WAIT_START:
+      poll(SEQ_HEARTBEAT_MS);
+      if (!buttonPressed()) break;
+      nextionBootStatus("WAITING BAMOCAR");
+      currentStep = 1;
+      bamocarRatesStart();
+      requestStatusOnce();
+      enter(SEQ_WAIT_ONLINE);
+      break;
+
+    case SEQ_WAIT_ONLINE:
+      if (!bamocarOnline) { poll(SEQ_POLL_MS); break; }
+      nextionBootStatus("BAMOCAR ONLINE");
+      // Requests refused while nothing acked the bus are still pending in
+      // the rate manager and go out on its next tick.
+      // --- Steps 2-4: DC bus, clear errors, CAN timeout (automatic) ---
+      currentStep = 2;
+      requestAck();
+      enter(SEQ_DC_BUS);
+      break;
+
+    case SEQ_DC_BUS:
+      if (!acked()) break;
+      currentStep = 3;
+      clearErrors();
+      requestAck();
+      enter(SEQ_CLEAR_ERRORS);
+      break;
+
+    case SEQ_CLEAR_ERRORS:
+      if (!acked()) break;
+      if (!_reenable) currentStep = 4;
+      else nextionBootStatus("RE-ENABLE", "configuring timeout...");
+      configureCanTimeout(_reenable ? CAN_TIMEOUT_MS : 2000);
+      requestAck();
+      enter(SEQ_CAN_TIMEOUT);
+      break;
+
+    case SEQ_CAN_TIMEOUT:
+      if (!acked()) break;
+      if (_reenable) {
+        nextionBootStatus("RE-ENABLE", "enabling drive...");
+        clearErrors();
+        requestAck();
+        enter(SEQ_ENABLE_CLEAR);
+      } else {
+        toHold("HOLD 3s: ENABLE", "hold 3s to enable");
+      }
+      break;
+
+    // --- Steps 5-7: hold 3s to enable drive and enter torque control ---
+    // Releasing and re-pressing resets the timer. t_detail shows a progress bar.
+    case SEQ_WAIT_HOLD: {
+      poll(SEQ_HEARTBEAT_MS);
+      bool held = buttonHeldFor(DRIVE_HOLD_MS);
+      uint32_t elapsed = buttonHoldElapsed();
+      if (held) {
+        buttonResetHold();  // sync hold state for the supervisor's re-enable
+        nextionBootStatus("ENABLING DRIVE");
+        if (!_reenable) currentStep = 5;
+        clearErrors();
+        requestAck();
+        enter(SEQ_ENABLE_CLEAR);
+      } else if (elapsed > 0) {
+        nextionHoldBar(NX_BOOT_DETAIL, elapsed, DRIVE_HOLD_MS);
+        _holding = true;
+      } else if (_holding) {
+        nextionText(NX_BOOT_DETAIL, "hold 3s to enable");
+        _holding = false;
+      }
+      break;
+    }
+
+    case SEQ_ENABLE_CLEAR:
+      if (!acked()) break;
+      disableDrive();  // lock, then enable: the BAMOCAR wants the edge
+      requestAck();
+      enter(SEQ_ENABLE_LOCK);
+      break;
+
+    case SEQ_ENABLE_LOCK:
+      if (!acked()) break;
+      enableDrive();
+      requestStatusOnce();
+      enter(SEQ_WAIT_ENABLED);
+      break;
+
+    // Advance on the ENA status bit rather than a fixed sleep. The lock was
+    // acknowledged, so ENA can only come from the enable frame.
+    case SEQ_WAIT_ENABLED:
+      if (freshStatus() && (bamocar.statusWord & BAMOCAR_STATUS_ENA)) {
+        sendTorqueCommand(0);
+        if (!_reenable) currentStep = 6;
+        nextionBootStatus("RELEASE PEDAL");
+        enter(SEQ_RELEASE_PEDAL);
+      } else if (millis() - _enteredMs >= SEQ_ENABLE_TIMEOUT_MS) {
+        char detail[32] = "hold 3s to retry";
+        if (bamocar.errorWord) bamocarErrorDescription(bamocar.errorWord, detail, sizeof(detail));
+        toHold("ENABLE FAILED", detail);
+      } else {
+        poll(SEQ_ACK_TIMEOUT_MS);
+      }
+      break;
+
+    // --- Wait for pedal release (automatic) ---
+    case SEQ_RELEASE_PEDAL:
+      poll(SEQ_HEARTBEAT_MS);
+      if (!pedalAtRest()) break;
+      currentStep = 7;
+      driveEnabled = true;
+      nextionPage(NX_PAGE_DRIVE);
+      enter(SEQ_RUNNING);
+      break;
+
+    case SEQ_RUNNING:
+      break;
+  }
+}
@@ -0,0 +1,173 @@
+#include "fault_capture.h"
+#include "irq_guard.h"
+
+#if CAPTURE_ENABLED
+static_assert((CAPTURE_RING_RECORDS & (CAPTURE_RING_RECORDS - 1)) == 0, "CAPTURE_RING_RECORDS must be a power of two");
+#define RING_MASK (CAPTURE_RING_RECORDS - 1)
+
+// ---------- Ring ----------
+// _head counts every record ever added; the newest _held of them are in the
+// ring. Both only change with interrupts masked. The ring is never
+// initialised: nothing reads past _held.
+#if CAPTURE_EXTMEM
+EXTMEM static LogRecord _ring[CAPTURE_RING_RECORDS];
+#else
+DMAMEM static LogRecord _ring[CAPTURE_RING_RECORDS];
+#endif
+static uint32_t _head = 0;
+static uint32_t _held = 0;
+static bool     _frozen = false;   // a capture is being written, records are dropped
+static bool     _enabled = false;  // captureBegin() found a card
+
+enum CaptureState : uint8_t {
+  CAPTURE_IDLE,
+  CAPTURE_ARMED,    // waiting out CAPTURE_POST_MS
+  CAPTURE_WRITING,  // frozen, records _next.._end going to _file
+};
+
+static uint8_t  _state = CAPTURE_IDLE;
+static uint32_t _triggerUs = 0;
+static uint8_t  _fileNo = 0;
+static uint32_t _next = 0, _end = 0;
+static uint32_t _missedNow = 0;  // this capture's lost records
+static char     _base[FILE_NAME_LEN];
+static FsFile   _file;
+static CaptureStats _stats = {};
+
+void captureBegin(const char *logName) {
+  const char *dot = strrchr(logName, '.');
+  size_t n = dot ? (size_t)(dot - logName) : strlen(logName);
+  if (n > FILE_NAME_LEN - sizeof("_F00.bin")) n = FILE_NAME_LEN - sizeof("_F00.bin");
+  memcpy(_base, logName, n);
+  _base[n] = '\0';
+  _stats = {};
+  _enabled = true;
+}
+
+void captureAdd(const LogRecord &rec) {
+  if (!_enabled) return;
+  IrqGuard lock;
+  if (_frozen) {
+    _missedNow++;
+    _stats.missed++;
+    return;
+  }
+  _ring[_head & RING_MASK] = rec;
+  _head++;
+  if (_held < CAPTURE_RING_RECORDS) _held++;
+}
+
+void captureCan(const CAN_message_t &msg, bool tx, uint8_t bus, uint32_t tUs) {
+  if (!_enabled) return;
+  LogRecord rec = logCanRecord(msg, tx, canBusNumber(bus));
+  rec.t_us = tUs;
+  captureAdd(rec);
+}
+
+// Blocks arrive complete, so the newest pair is taken as sampled now and
+// the others one sample period apart before it.
+void capturePedal(const volatile uint16_t *s1, const volatile uint16_t *s2, uint16_t n) {
+  if (!_enabled || n == 0) return;
+#if APPS_ACQ_MODE == APPS_ACQ_DMA
+  const uint32_t period = 1000000 / APPS_SAMPLE_HZ;
+#else
+  const uint32_t period = TORQUE_PERIOD_US;  // one pair per torque tick
+#endif
+  uint32_t first = micros() - (uint32_t)(n - 1) * period;
+  for (uint16_t i = 0; i < n; i += 3) {
+    LogRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.t_us = first + i * period;
+    rec.type = LOG_REC_APPS;
+    rec.len  = n - i < 3 ? n - i : 3;
+    rec.id   = period;
+    for (uint8_t k = 0; k < rec.len; k++) {
+      rec.s16[2 * k]     = (int16_t)s1[i + k];
+      rec.s16[2 * k + 1] = (int16_t)s2[i + k];
+    }
+    captureAdd(rec);
+  }
+}
+
+// ---------- Triggers ----------
+void captureTrigger(uint8_t cause, uint32_t detail) {
+  uint8_t file = 0;
+  if (_enabled) {
+    if (_state == CAPTURE_IDLE && _stats.files < CAPTURE_MAX_FILES) {
+      file = _fileNo = ++_stats.files;
+      _triggerUs = micros();
+      _state = CAPTURE_ARMED;
+    } else {
+      _stats.skipped++;
+    }
+  }
+  captureAdd(logFaultRecord(cause, detail, file));
+  logFault(cause, detail, file);
+}
+
+// ---------- Writer ----------
+static void _release() {
+  IrqGuard lock;
+  _frozen = false;
+  _state = CAPTURE_IDLE;
+}
+
+// After the post window: freeze, find the first record inside the pre
+// window (oldest first; records are only roughly time-ordered, CAN frames
+// carry their ISR time) and open the file with a header record.
+static void _start() {
+  {
+    IrqGuard lock;
+    _frozen = true;
+    _missedNow = 0;
+    _end = _head;
+    _next = _head - _held;
+  }
+  uint32_t from = _triggerUs - CAPTURE_PRE_MS * 1000u;
+  while (_next != _end && (int32_t)(_ring[_next & RING_MASK].t_us - from) < 0) _next++;
+
+  char name[FILE_NAME_LEN + sizeof("_F00.bin")];  // room for any _base and _fileNo
+  snprintf(name, sizeof(name), "%s_F%02u.bin", _base, _fileNo);
+  _file = SD.sdfs.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+  if (!_file) {
+    _stats.skipped++;
+    _release();
+    return;
+  }
+  LogRecord hdr = logHeaderRecord();
+  _file.write(&hdr, sizeof(hdr));
+  _state = CAPTURE_WRITING;
+}
+
+// At most CAPTURE_WRITE_RECORDS per call, straight from the ring, so the
+// other slack tasks keep running while a capture is written.
+void captureService() {
+  if (_state == CAPTURE_IDLE) return;
+  if (_state == CAPTURE_ARMED) {
+    if (micros() - _triggerUs >= CAPTURE_POST_MS * 1000u) _start();
+    return;
+  }
+  if (_next != _end) {
+    uint32_t i = _next & RING_MASK;
+    uint32_t n = _end - _next;
+    if (n > CAPTURE_RING_RECORDS - i) n = CAPTURE_RING_RECORDS - i;  // up to the wrap
+    if (n > CAPTURE_WRITE_RECORDS) n = CAPTURE_WRITE_RECORDS;
+    _file.write(&_ring[i], n * sizeof(LogRecord));
+    _next += n;
+    return;
+  }
+  LogRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.t_us   = micros();
+  rec.type   = LOG_REC_END;
+  rec.u32[0] = (uint32_t)_file.curPosition();
+  rec.u32[1] = _missedNow * sizeof(LogRecord);
+  _file.write(&rec, sizeof(rec));
+  _file.close();
+  _release();
+}
+
+const CaptureStats &captureStats() {
+  return _stats;
+}
+#endif
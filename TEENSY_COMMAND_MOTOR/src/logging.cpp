@@ -1,57 +1,162 @@
 #include "logging.h"
+#include "irq_guard.h"
+#include "canfd_telemetry.h"
+#include "fault_capture.h"
+#include <EEPROM.h>
 
 // ---------- Write buffer ----------
-// Batches SD writes to reduce per-frame latency. Drains automatically when
-// full; committed to flash by logFlush() every 500 ms from the main loop.
-static char     _buf[4096];
-static uint16_t _bufLen = 0;
+// LOG_SLOT_COUNT slots of LOG_SLOT_SIZE bytes used as a ring. The control
+// path only memcpy's into the slot being filled; full slots are handed to
+// the SD card by logService() from the loop's slack time, so an SD stall
+// never delays a torque frame. Records are split across slot boundaries so
+// every slot write is an exact multiple of the 512-byte sector size.
+// _append() may be called from the scheduler's timer task, so the slot
+// indices are only changed with interrupts masked.
+static_assert(LOG_SLOT_SIZE % 512 == 0, "LOG_SLOT_SIZE must be a multiple of 512");
+static_assert(LOG_SLOT_COUNT >= 2, "LOG_SLOT_COUNT needs at least two slots");
 
-static void _drain() {
-  if (_bufLen > 0) {
-    logFile.write((const uint8_t *)_buf, _bufLen);
-    _bufLen = 0;
+static char     _slots[LOG_SLOT_COUNT][LOG_SLOT_SIZE];
+static uint16_t _fillLen   = 0;  // bytes in the slot being filled
+static uint8_t  _fillSlot  = 0;  // slot the control path appends to
+static uint8_t  _writeSlot = 0;  // oldest full slot waiting for the SD
+static uint8_t  _queued    = 0;  // number of full slots waiting
+static uint16_t _writeSkip = 0;  // leading bytes of _writeSlot already on the card, see _sync()
+static uint32_t _lastSync  = 0;
+static LogStats _stats = {};
+static FsFile   _file;
+
+// Writes len bytes to the card and tracks the worst-case call latency.
+static void _commit(const char *data, uint16_t len) {
+  uint32_t t0 = micros();
+  _file.write(data, len);
+  uint32_t dt = micros() - t0;
+  if (dt > _stats.worstWriteUs) _stats.worstWriteUs = dt;
+  _stats.bytesWritten += len;
+  _stats.writes++;
+}
+
+// Flushes the directory entry so a power cut loses at most one sync
+// interval. Only whole sectors of the fill slot are written, keeping the
+// file position sector-aligned; the tail is moved to the slot start.
+// Only called with no slot queued, so if appends fill the slot during the
+// write it becomes _writeSlot, and logService() skips what is written.
+static void _sync() {
+  uint16_t whole;
+  uint8_t  slot;
+  {
+    IrqGuard lock;
+    whole = _fillLen & ~(uint16_t)511;
+    slot  = _fillSlot;
   }
+  if (whole > 0) {
+    _commit(_slots[slot], whole);
+    IrqGuard lock;
+    if (_fillSlot == slot) {
+      _fillLen -= whole;
+      memmove(_slots[slot], _slots[slot] + whole, _fillLen);
+    } else {
+      _writeSkip = whole;
+    }
+  }
+  uint32_t t0 = micros();
+  _file.flush();
+  uint32_t dt = micros() - t0;
+  if (dt > _stats.worstWriteUs) _stats.worstWriteUs = dt;
 }
 
 static void _append(const char *data, uint16_t len) {
-  if (!logFile) return;
-  if (_bufLen + len > (uint16_t)sizeof(_buf)) {
-    _drain();
+  if (!_file) return;
+  IrqGuard lock;
+  // Refuse the whole record if it would need a slot still owned by the SD.
+  uint16_t room = LOG_SLOT_SIZE - _fillLen;
+  if (len > room && _queued + 1 >= LOG_SLOT_COUNT) {
+    _stats.bytesDropped += len;
+    return;
+  }
+  if (len > room) {
+    memcpy(_slots[_fillSlot] + _fillLen, data, room);
+    data += room;
+    len  -= room;
+    _queued++;
+    _fillSlot = (_fillSlot + 1) % LOG_SLOT_COUNT;
+    _fillLen  = 0;
   }
-  memcpy(_buf + _bufLen, data, len);
-  _bufLen += len;
+  memcpy(_slots[_fillSlot] + _fillLen, data, len);
+  _fillLen += len;
 }
 
-// ---------- File management ----------
-char* generateFilename() {
-  int index = 1;
-  char filename[FILE_NAME_LEN];
-  do {
-    snprintf(filename, FILE_NAME_LEN - 1, "CAN_log_%04d.csv", index);
-    index++;
-  } while (SD.exists(filename));
-  return filename;
+// Binary records are built in place and appended whole; no formatting.
+// The CAN FD telemetry channel carries the same records in either format.
+static LogRecord _record(uint8_t type) {
+  LogRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.t_us = micros();
+  rec.type = type;
+  return rec;
+}
+
+// Header record: magic, record size and IMU scales so the converter can
+// reject truncated or foreign files.
+LogRecord logHeaderRecord() {
+  LogRecord rec = _record(LOG_REC_HEADER);
+  rec.len = LOG_BIN_VERSION;
+  rec.id  = sizeof(LogRecord);
+  memcpy(rec.data, LOG_BIN_MAGIC, sizeof(LOG_BIN_MAGIC) - 1);
+  rec.s16[4] = LOG_IMU_ACCEL_LSB_PER_G;
+  rec.s16[5] = LOG_IMU_GYRO_LSB_PER_DPS_X10;
+  return rec;
 }
 
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+void logWriteHeader() {
+  LogRecord rec = logHeaderRecord();
+  _append((const char *)&rec, sizeof(rec));
+}
+#else
 void logWriteHeader() {
   static const char hdr[] =
     "# C,ms,dir,id,len,b0,b1,b2,b3,b4,b5,b6,b7\n"
-    "# S,ms,apps1_raw,apps2_raw,pedal_fault,torque_cmd,rpm,dcbus_dV\n";
+    "# S,ms,apps1_raw,apps2_raw,pedal_fault,torque_cmd,rpm,dcbus_dV\n"
+    "# XR,ms,ax,ay,az,gx,gy,gz\n"
+    "# K,ms,task,runs,overruns,max_jitter_us,max_run_us\n"
+    "# KH,ms,task,h0,h1,h2,h3,h4,h5\n"
+    "# LT,ms,path,count,min_us,avg_us,p99_us,max_us\n"
+    "# FT,ms,cause,detail,capture\n";
   _append(hdr, sizeof(hdr) - 1);
+  char scale[64];
+  int n = snprintf(scale, sizeof(scale), "# XR scale: accel_lsb_per_g=%d gyro_lsb_per_dps_x10=%d\n",
+                   LOG_IMU_ACCEL_LSB_PER_G, LOG_IMU_GYRO_LSB_PER_DPS_X10);
+  _append(scale, n);
 }
+#endif
 
 // ---------- CAN frame logging ----------
 // Record: C,<ms>,<dir>,<id_hex>,<len>,<b0_hex>,...,<b7_hex>
 // Always 13 columns; unused byte fields are empty.
-void logCANFrame(const CAN_message_t &msg, const char *dir) {
+LogRecord logCanRecord(const CAN_message_t &msg, bool tx, uint8_t bus) {
+  LogRecord rec = _record(tx ? LOG_REC_TX : LOG_REC_RX);
+  rec.len = msg.len;
+  rec.id  = (uint16_t)msg.id;
+  memcpy(rec.data, msg.buf, 8);
+  rec.data[8] = bus;
+  return rec;
+}
+
+void logCANFrame(const CAN_message_t &msg, const char *dir, uint8_t bus) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = logCanRecord(msg, dir[0] == 'T', bus);
+  _append((const char *)&rec, sizeof(rec));
+#else
   char line[80];
-  int n = snprintf(line, 79, "C,%lu,%s,%03lX,%d", millis(), dir, msg.id, msg.len);
+  int n = bus > 1 ? snprintf(line, 79, "C,%lu,%s%u,%03lX,%d", millis(), dir, (unsigned)bus, msg.id, msg.len)
+                  : snprintf(line, 79, "C,%lu,%s,%03lX,%d", millis(), dir, msg.id, msg.len);
   for (int i = 0; i < 8; i++) {
     if (i < msg.len) n += snprintf(line + n, 80 - n, ",%02X", msg.buf[i]);
     else             n += snprintf(line + n, 80 - n, ",");
   }
   line[n++] = '\n';
   _append(line, n);
+#endif
 }
 
 // ---------- Sensor snapshot logging ----------
@@ -60,27 +165,364 @@ void logCANFrame(const CAN_message_t &msg, const char *dir) {
 // pedal_fault = 1 if APPS plausibility fault active.
 void logSensor(int16_t apps1Raw, int16_t apps2Raw, bool fault, 
               int16_t torque, int16_t rpm, int dcbusDV) {
+  LogRecord rec = _record(LOG_REC_SENSOR);
+  rec.len    = fault ? 1 : 0;
+  rec.s16[0] = apps1Raw;
+  rec.s16[1] = apps2Raw;
+  rec.s16[2] = torque;
+  rec.s16[3] = rpm;
+  rec.s16[4] = (int16_t)dcbusDV;
+  canFdRecord(rec);
+  captureAdd(rec);
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  _append((const char *)&rec, sizeof(rec));
+#else
   char line[56];
   int n = snprintf(line, sizeof(line), "S,%lu,%d,%d,%d,%d,%d,%d\n",
                   millis(), apps1Raw, apps2Raw, (int)fault, 
                   (int)torque, rpm, dcbusDV);
   _append(line, n);
+#endif
 }
 
 // ---------- Log IMU data ----------
-// Record: XL,<ms>,<accel_x>,<accel_y>,<accel_z>,<gyro_x>,<gyro_y>,<gyro_z>
-void logIMU(float ax, float ay, float az, float gx, float gy, float gz) {
+// Record: XR,<ms>,<accel_x>,<accel_y>,<accel_z>,<gyro_x>,<gyro_y>,<gyro_z>
+// Raw sensor counts; tUs is the sample time reconstructed from the FIFO.
+void logIMU(uint32_t tUs, const int16_t raw[6]) {
+  LogRecord rec = _record(LOG_REC_IMU);
+  rec.t_us = tUs;
+  memcpy(rec.s16, raw, 6 * sizeof(int16_t));
+  canFdRecord(rec);
+  captureAdd(rec);
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  _append((const char *)&rec, sizeof(rec));
+#else
   char line[64];
-  int n = snprintf(line, 63, "XL,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
-                  millis(), ax, ay, az, gx, gy, gz);
+  int n = snprintf(line, sizeof(line), "XR,%lu,%d,%d,%d,%d,%d,%d\n",
+                   tUs / 1000, raw[0], raw[1], raw[2], raw[3], raw[4], raw[5]);
+  _append(line, n);
+#endif
+}
+
+// ---------- Scheduler statistics ----------
+// Records: K,<ms>,<task>,<runs>,<overruns>,<max_jitter_us>,<max_run_us>
+//          KH,<ms>,<task>,<h0>,...,<h5>
+void logSchedStats(uint8_t task, const TaskStats &stats) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = _record(LOG_REC_TASK);
+  rec.len    = task;
+  rec.id     = stats.overruns > 0xFFFF ? 0xFFFF : (uint16_t)stats.overruns;
+  rec.u32[0] = stats.runs;
+  rec.u32[1] = stats.maxJitterUs;
+  rec.u32[2] = stats.maxRunUs;
+  _append((const char *)&rec, sizeof(rec));
+  rec = _record(LOG_REC_JITTER);
+  rec.len = task;
+  memcpy(rec.u16, stats.hist, sizeof(stats.hist));
+  _append((const char *)&rec, sizeof(rec));
+#else
+  char line[80];
+  int n = snprintf(line, sizeof(line), "K,%lu,%u,%lu,%lu,%lu,%lu\n",
+                   millis(), task, stats.runs, stats.overruns,
+                   stats.maxJitterUs, stats.maxRunUs);
+  _append(line, n);
+  n = snprintf(line, sizeof(line), "KH,%lu,%u", millis(), task);
+  for (int i = 0; i < SCHED_HIST_BUCKETS; i++) {
+    n += snprintf(line + n, sizeof(line) - n, ",%u", stats.hist[i]);
+  }
+  line[n++] = '\n';
   _append(line, n);
+#endif
 }
 
-// ---------- Periodic flush ----------
-// Drains the RAM buffer to the SD library, then commits to flash.
-// Called every 500 ms from the main loop — not on every frame.
+// ---------- Latency summaries ----------
+// Record: LT,<ms>,<path>,<count>,<min_us>,<avg_us>,<p99_us>,<max_us>
+// Durations arrive in 0.1 µs units; binary packs each into 24 bits.
+void logTrace(uint8_t path, const TraceSummary &s) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = _record(LOG_REC_LATENCY);
+  rec.len = path;
+  rec.id  = s.count > 0xFFFF ? 0xFFFF : (uint16_t)s.count;
+  const uint32_t v[4] = { s.min, s.avg, s.p99, s.max };
+  for (int i = 0; i < 4; i++) {
+    uint32_t x = v[i] > 0xFFFFFF ? 0xFFFFFF : v[i];
+    rec.data[i * 3]     = x & 0xFF;
+    rec.data[i * 3 + 1] = (x >> 8) & 0xFF;
+    rec.data[i * 3 + 2] = (x >> 16) & 0xFF;
+  }
+  _append((const char *)&rec, sizeof(rec));
+#else
+  char line[96];
+  int n = snprintf(line, sizeof(line), "LT,%lu,%u,%lu,%lu.%lu,%lu.%lu,%lu.%lu,%lu.%lu\n",
+                   millis(), path, s.count,
+                   s.min / 10, s.min % 10, s.avg / 10, s.avg % 10,
+                   s.p99 / 10, s.p99 % 10, s.max / 10, s.max % 10);
+  _append(line, n);
+#endif
+}
+
+// ---------- CAN bus statistics ----------
+// Records: CB,<ms>,<bus>,<load_pct>,<peak_pct>,<rx>,<tx>,<tx_busy>,<tx_dropped>,<tec>,<rec>,<state>,<bus_off>
+//          CI,<ms>,<dir>,<id_hex>,<frames>,<min_gap_us>,<max_gap_us>
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+static uint16_t _sat16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : (uint16_t)v; }
+static uint8_t  _sat8(uint32_t v)  { return v > 0xFF ? 0xFF : (uint8_t)v; }
+#endif
+
+void logCanLoad(uint8_t bus, const CanLoadSummary &s) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = _record(LOG_REC_CANLOAD);
+  rec.len     = bus | (s.state << 4);
+  rec.id      = s.loadPermille;
+  rec.u16[0]  = s.peakPermille;
+  rec.u16[1]  = _sat16(s.rxFrames);
+  rec.u16[2]  = _sat16(s.txFrames);
+  rec.u16[3]  = _sat16(s.txBusy);
+  rec.data[8]  = s.tec;
+  rec.data[9]  = s.rec;
+  rec.data[10] = _sat8(s.busOffEvents);
+  rec.data[11] = _sat8(s.txDropped);
+  _append((const char *)&rec, sizeof(rec));
+#else
+  char line[96];
+  int n = snprintf(line, sizeof(line), "CB,%lu,%u,%u.%u,%u.%u,%lu,%lu,%lu,%lu,%u,%u,%u,%lu\n",
+                   millis(), bus, s.loadPermille / 10, s.loadPermille % 10,
+                   s.peakPermille / 10, s.peakPermille % 10, s.rxFrames, s.txFrames,
+                   s.txBusy, s.txDropped, s.tec, s.rec, s.state, s.busOffEvents);
+  _append(line, n);
+#endif
+}
+
+void logCanId(const CanIdSummary &s) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = _record(LOG_REC_CANID);
+  rec.len    = s.bus | (s.extended ? 0x40 : 0) | (s.tx ? 0x80 : 0);
+  rec.id     = _sat16(s.frames);
+  rec.u32[0] = s.id;
+  rec.u32[1] = s.minGapUs;
+  rec.u32[2] = s.maxGapUs;
+  _append((const char *)&rec, sizeof(rec));
+#else
+  const char *dir = s.tx ? "TX" : "RX";
+  char line[64];
+  int n = s.bus > 1 ? snprintf(line, sizeof(line), "CI,%lu,%s%u,%03lX,%lu,%lu,%lu\n", millis(), dir,
+                               (unsigned)s.bus, s.id, s.frames, s.minGapUs, s.maxGapUs)
+                    : snprintf(line, sizeof(line), "CI,%lu,%s,%03lX,%lu,%lu,%lu\n", millis(), dir,
+                               s.id, s.frames, s.minGapUs, s.maxGapUs);
+  _append(line, n);
+#endif
+}
+
+// ---------- Fault triggers ----------
+// Record: FT,<ms>,<cause>,<detail_hex>,<capture>
+// The same F record opens the capture window in the capture file.
+LogRecord logFaultRecord(uint8_t cause, uint32_t detail, uint8_t capture) {
+  LogRecord rec = _record(LOG_REC_FAULT);
+  rec.len    = cause;
+  rec.id     = capture;
+  rec.u32[0] = detail;
+  return rec;
+}
+
+void logFault(uint8_t cause, uint32_t detail, uint8_t capture) {
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = logFaultRecord(cause, detail, capture);
+  _append((const char *)&rec, sizeof(rec));
+#else
+  char line[48];
+  int n = snprintf(line, sizeof(line), "FT,%lu,%u,%lX,%u\n", millis(), cause, detail, capture);
+  _append(line, n);
+#endif
+}
+
+// ---------- Background writer ----------
+// Call once per loop pass, after the time-critical work. Commits at most
+// one full slot per call, or syncs the file every LOG_SYNC_INTERVAL_MS.
+void logService() {
+  if (!_file) return;
+  if (_queued > 0) {
+    // Only this function moves _writeSlot; _append() may queue another
+    // slot meanwhile, so the count changes under the lock.
+    _commit(_slots[_writeSlot] + _writeSkip, LOG_SLOT_SIZE - _writeSkip);
+    IrqGuard lock;
+    _writeSlot = (_writeSlot + 1) % LOG_SLOT_COUNT;
+    _writeSkip = 0;
+    _queued--;
+    return;
+  }
+  if (millis() - _lastSync >= LOG_SYNC_INTERVAL_MS) {
+    _sync();
+    _lastSync = millis();
+  }
+}
+
+// ---------- Blocking flush ----------
+// Commits every queued slot and the partial fill slot, then flushes the
+// file. Leaves the file position unaligned; use before closing only.
 void logFlush() {
-  if (!logFile) return;
-  _drain();
-  logFile.flush();
+  if (!_file) return;
+  while (_queued > 0) logService();
+  if (_fillLen > 0) {
+    _commit(_slots[_fillSlot], _fillLen);
+    _fillLen = 0;
+  }
+  _file.flush();
+  _lastSync = millis();
+}
+
+// ---------- File management ----------
+// A log is pre-allocated as one contiguous run of clusters and erased, so
+// writing never waits for a FAT update and a power cut leaves the written
+// sectors followed by erased ones. EEPROM holds the next index and the log
+// still open. The first boot after a power cut finds where that log's data
+// ends, appends a trailer and releases the rest of the allocation, like
+// logClose() does on a clean shutdown.
+struct LogIndex {
+  uint32_t magic;
+  uint16_t next;  // index of the next log
+  uint16_t open;  // log without a trailer yet, 0 = none
+};
+#define LOG_INDEX_MAGIC 0x43414E31  // "CAN1"
+
+static uint16_t _openIndex = 0;
+
+static void _fileName(char *name, uint16_t index) {
+  snprintf(name, FILE_NAME_LEN, "CAN_log_%04u." LOG_FILE_EXT, index);
+}
+
+static void _putIndex(uint16_t next, uint16_t open) {
+  LogIndex idx = { LOG_INDEX_MAGIC, next, open };
+  EEPROM.put(LOG_INDEX_EEPROM_ADDR, idx);
+}
+
+// Written at the file position, then the file ends there.
+static void _writeTrailer(bool recovered, uint32_t tUs) {
+  uint32_t bytes = (uint32_t)_file.curPosition();
+  uint32_t dropped = recovered ? 0 : _stats.bytesDropped;
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  LogRecord rec = _record(LOG_REC_END);
+  rec.t_us   = tUs;
+  rec.len    = recovered ? 1 : 0;
+  rec.u32[0] = bytes;
+  rec.u32[1] = dropped;
+  _file.write(&rec, sizeof(rec));
+#else
+  (void)tUs;
+  char line[64];
+  int n = snprintf(line, sizeof(line), "# end: %lu bytes, %lu dropped, %s\n",
+                   bytes, dropped, recovered ? "recovered" : "closed");
+  _file.write(line, n);
+#endif
+  _file.truncate(_file.curPosition());
+  _file.sync();
+}
+
+// After a power cut FAT32 reports the whole pre-allocation as the file
+// size and exFAT only what was synced. Within that, the data ends at the
+// first erased sector (written sectors never are all 0x00 or all 0xFF),
+// then at the last whole record or line, as _sync() may split either.
+static bool _erasedSector(const uint8_t *sector) {
+  if (sector[0] != 0x00 && sector[0] != 0xFF) return false;
+  for (int i = 1; i < 512; i++) {
+    if (sector[i] != sector[0]) return false;
+  }
+  return true;
+}
+
+static void _recover(const char *name) {
+  _file = SD.sdfs.open(name, O_RDWR);
+  if (!_file) return;
+  uint8_t *buf = (uint8_t *)_slots[0];  // idle until the next log opens
+  uint64_t size = _file.fileSize();
+  uint32_t lo = 0, hi = size / 512;  // first erased sector
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (_file.seekSet((uint64_t)mid * 512) && _file.read(buf, 512) == 512 && _erasedSector(buf)) hi = mid;
+    else lo = mid + 1;
+  }
+  uint64_t end = (uint64_t)lo * 512 < size ? (uint64_t)lo * 512 : size;
+  uint32_t tUs = 0;
+#if LOG_FORMAT == LOG_FORMAT_BINARY
+  end -= end % sizeof(LogRecord);
+  LogRecord last;
+  if (end >= sizeof(LogRecord) && _file.seekSet(end - sizeof(LogRecord)) &&
+      _file.read(&last, sizeof(last)) == sizeof(last)) {
+    tUs = last.t_us;
+  }
+#else
+  uint64_t from = end > 512 ? end - 512 : 0;
+  int n = _file.seekSet(from) ? _file.read(buf, end - from) : 0;
+  while (n > 0 && buf[n - 1] != '\n') n--;
+  end = from + (n > 0 ? n : 0);
+#endif
+  _file.seekSet(end);
+  _writeTrailer(true, tUs);
+  _file.close();
+}
+
+bool logOpen(const char *name) {
+  _file = SD.sdfs.open(name, O_RDWR | O_CREAT | O_TRUNC);
+  if (!_file) return false;
+  // Unerased space could hold old card data that looks like a log, so
+  // without the erase the file just grows as it is written.
+  uint32_t first, last;
+  bool erased = _file.preAllocate(LOG_PREALLOC_BYTES) && _file.contiguousRange(&first, &last) &&
+                SD.sdfs.card()->erase(first, last);
+  if (!erased) _file.truncate(0);
+  {
+    IrqGuard lock;
+    _fillLen = _fillSlot = _writeSlot = _queued = 0;
+    _writeSkip = 0;
+  }
+  _stats = {};
+  _lastSync = millis();
+  _openIndex = 0;
+  logWriteHeader();
+  return true;
+}
+
+// Normally a single exists() call: more only when the card was written by
+// another unit or the EEPROM was erased.
+bool logOpenNext(char *name) {
+  LogIndex idx;
+  EEPROM.get(LOG_INDEX_EEPROM_ADDR, idx);
+  if (idx.magic != LOG_INDEX_MAGIC || idx.next == 0 || idx.next > LOG_INDEX_MAX) {
+    idx = { LOG_INDEX_MAGIC, 1, 0 };
+  }
+  if (idx.open != 0) {
+    _fileName(name, idx.open);
+    if (SD.exists(name)) _recover(name);
+  }
+
+  uint16_t index = idx.next;
+  uint16_t tries = 0;
+  for (_fileName(name, index); SD.exists(name); _fileName(name, index)) {
+    if (++tries >= LOG_INDEX_MAX) return false;
+    index = index % LOG_INDEX_MAX + 1;
+  }
+  uint16_t next = index % LOG_INDEX_MAX + 1;
+  if (!logOpen(name)) {
+    _putIndex(next, 0);
+    return false;
+  }
+  _putIndex(next, index);
+  _openIndex = index;
+  return true;
+}
+
+void logClose() {
+  if (!_file) return;
+  logFlush();
+  _writeTrailer(false, micros());
+  _file.close();
+  if (_openIndex != 0) {
+    LogIndex idx;
+    EEPROM.get(LOG_INDEX_EEPROM_ADDR, idx);
+    _putIndex(idx.next, 0);
+    _openIndex = 0;
+  }
+}
+
+const LogStats &logStats() {
+  return _stats;
 }
@@ -5,22 +5,30 @@
 #include "nextion.h"
 #include "button.h"
 #include "MpuController.h"
+#include "scheduler.h"
+#include "drive_sequence.h"
+#include "bamocar_rates.h"
+#include "trace.h"
+#include "can_stats.h"
+#include "telemetry.h"
+#include "canfd_telemetry.h"
+#include "fault_capture.h"
+#include "torque_shaping.h"
 
 // ---------- Global definitions ----------
 FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can1;
+FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16> Can2;
+#if CAN_FD_TELEMETRY
+FlexCAN_T4FD<CAN3, RX_SIZE_256, TX_SIZE_64> CanFD;
+#else
+FlexCAN_T4<CAN3, RX_SIZE_256, TX_SIZE_16> Can3;
+#endif
 const int chipSelect = BUILTIN_SDCARD;
-File logFile;
 int8_t currentStep = 0;
 int16_t currentTorque = 0;
 uint32_t lastTorqueSend = 0;
 bool bamocarOnline = false;
-int16_t rpmFeedback = 0;
-int16_t statusWord = 0;
-uint32_t bamocarErrorWord = 0;
-int16_t actualCurrent = 0;
-float motorTemp    = 0.0f;
-float inverterTemp = 0.0f;
-float dcBusVoltage = 0.0;
+BamocarState bamocar = {};
 int16_t apps1Raw = 0;
 int16_t apps2Raw = 0;
 bool pedalFault = false;
@@ -29,201 +37,40 @@ uint32_t lastBAMOCARRx = 0;
 Adafruit_MPU6050 mpu;
 MpuController mpuController(mpu);
 
-// ---------- Helpers ----------
-
-// Fills buf (must be ≥13 bytes) with an ASCII progress bar like [####      ]
-// elapsed/total drives fill level; bar is always 10 chars wide.
-static void holdBar(uint32_t elapsed, uint32_t total, char *buf) {
-  int filled = (int)(elapsed * 10 / total);
-  if (filled > 10) filled = 10;
-  buf[0] = '[';
-  for (int i = 0; i < 10; i++) buf[i + 1] = (i < filled) ? '#' : ' ';
-  buf[11] = ']';
-  buf[12] = '\0';
-}
-
-// Blocks until button pressed. Keeps CAN drained and sends a heartbeat
-// every 500 ms so the BAMOCAR CAN timeout never expires while waiting.
-static void waitForButton(const char *prompt) {
-  nextionBootStatus(prompt, "press to continue");
-  uint32_t lastHeartbeat = 0;
-  while (!buttonPressed()) {
-    readCanMessages();
-    if (millis() - lastHeartbeat > 500) {
-      requestStatusOnce();
-      lastHeartbeat = millis();
-    }
-    delay(10);
-  }
-}
-
-// Blocks until button is held continuously for DRIVE_HOLD_MS.
-// Releasing and re-pressing resets the timer. t_detail shows a progress bar.
-static void waitForButtonHeld(const char *prompt) {
-  nextionBootStatus(prompt, "hold 3s to enable");
-  uint32_t lastHeartbeat = 0;
-  uint32_t holdStart = 0;
-  for (;;) {
-    readCanMessages();
-    if (millis() - lastHeartbeat > 500) {
-      requestStatusOnce();
-      lastHeartbeat = millis();
-    }
-    if (digitalRead(BUTTON_PIN) == HIGH) {
-      if (holdStart == 0) holdStart = millis();
-      uint32_t elapsed = millis() - holdStart;
-      if (elapsed >= DRIVE_HOLD_MS) break;
-      char bar[13];
-      holdBar(elapsed, DRIVE_HOLD_MS, bar);
-      nextionText(NX_BOOT_DETAIL, bar);
-    } else {
-      if (holdStart != 0) nextionText(NX_BOOT_DETAIL, "hold 3s to enable");
-      holdStart = 0;
-    }
-    delay(10);
-  }
-  buttonResetHold();  // sync hold state for loop re-enable
-}
-
-static bool pedalAtRest() {
-  int raw = analogRead(APPS1_PIN);
-  float pct = (float)(APPS1_REST - raw) * 100.0f / (float)(APPS1_REST - APPS1_FULL);
-  return pct < PEDAL_DEADBAND_PERCENT;
-}
-
-// Full re-enable handshake: mirrors startup steps 3-7.
-// Blocks until handshake is complete and pedal is released.
-static void reenableDriveSequence() {
-  nextionBootStatus("RE-ENABLE", "clearing errors...");
-  requestStatusCyclic(CAN_TIMEOUT_MS);
-  requestErrorsCyclic(CAN_TIMEOUT_MS);
-  requestSpeedCyclic(CAN_TIMEOUT_MS);
-  requestCurrentCyclic(CAN_TIMEOUT_MS);
-  requestTempsCyclic(TEMP_CAN_TIMEOUT_MS);
-  clearErrors();
-  delay(CAN_TIMEOUT_MS*2);
-  readCanMessages();
-
-  nextionBootStatus("RE-ENABLE", "configuring timeout...");
-  configureCanTimeout(CAN_TIMEOUT_MS);
-  delay(CAN_TIMEOUT_MS*2);
-
-  nextionBootStatus("RE-ENABLE", "enabling drive...");
-  clearErrors();
-  delay(CAN_TIMEOUT_MS);
-  enableDrive();
-  requestStatusOnce();
-  delay(CAN_TIMEOUT_MS*5);
-  sendTorqueCommand(0);
-
-  nextionBootStatus("RELEASE PEDAL");
-  while (!pedalAtRest()) {
-    readCanMessages();
-    delay(CAN_READ_DELAY_MS);
-  }
-
-  driveEnabled = true;
-  nextionPage(NX_PAGE_DRIVE);
-}
-
-// ---------- Step Execution ----------
-void executeStep(int step) {
-  currentStep = step;
-  switch (step) {
-    case 1: requestStatusCyclic(100); requestErrorsCyclic(100); requestSpeedCyclic(100); requestCurrentCyclic(100); requestTempsCyclic(500); break;
-    case 2: requestDCBusOnce();       break;
-    case 3: clearErrors();            break;
-    case 4: configureCanTimeout(2000); break;
-    case 5:
-      clearErrors();
-      delay(100);
-      enableDrive();
-      requestStatusOnce();
-      driveEnabled = true;
-      break;
-    case 6: sendTorqueCommand(0);     break;
-    case 7:                           break;
-  }
-}
-
-// ---------- Setup ----------
-void setup() {
-  buttonInit();
-  nextionBegin();
-  nextionBootStatus("INITIALISING");
-
-  Can1.begin();
-  Can1.setBaudRate(500000);
-  analogReadResolution(12);
-
-  mpuController.begin();
-
-  if (!SD.begin(chipSelect)) {
-    nextionBootStatus("SD: NONE", "logging disabled");
+// ---------- Tasks ----------
+
+// Timer task (IntervalTimer ISR, TORQUE_PERIOD_US).
+// Always sends torque (0 when disabled) to keep BAMOCAR CAN watchdog alive.
+// Traced from the pedal sample to the torque frame's mailbox write.
+static void torqueTask() {
+  if (currentStep != 7) return;
+  uint32_t t0 = traceNow();
+  if (driveEnabled) {
+    updateTorqueFromPedal();
+    traceRecord(TRACE_PEDAL_TORQUE, t0, traceNow());
   } else {
-    char filename[FILE_NAME_LEN];
-    strcpy(filename, generateFilename());
-    logFile = SD.open(filename, FILE_WRITE);
-    if (!logFile) {
-      nextionBootStatus("SD: ERROR", "file open failed");
-    } else {
-      logWriteHeader();
-      nextionBootStatus("SD: OK", filename);
-    }
+    currentTorque = 0;
+    torqueShapeReset();
   }
-  delay(800);
-
-  // --- Step 1: press to start, wait for BAMOCAR ---
-  waitForButton("PRESS TO START");
-  nextionBootStatus("WAITING BAMOCAR");
-  executeStep(1);
-  while (!bamocarOnline) {
-    requestStatusOnce();
-    readCanMessages();
-    delay(300);
-  }
-  nextionBootStatus("BAMOCAR ONLINE");
-  delay(400);
-
-  // --- Steps 2-4: DC bus, clear errors, CAN timeout (automatic) ---
-  executeStep(2);
-  delay(200);
-  readCanMessages();
-
-  executeStep(3);
-  delay(200);
-
-  executeStep(4);
-  delay(200);
-
-  // --- Steps 5-7: hold 3s to enable drive and enter torque control ---
-  waitForButtonHeld("HOLD 3s: ENABLE");
-  nextionBootStatus("ENABLING DRIVE");
-  executeStep(5);
-  delay(500);
-  executeStep(6);
-  delay(500);
-
-  // --- Wait for pedal release (automatic) ---
-  nextionBootStatus("RELEASE PEDAL");
-  while (!pedalAtRest()) {
-    readCanMessages();
-    delay(50);
+  if (sendTorqueCommand(currentTorque) && driveEnabled) {
+    traceRecord(TRACE_PEDAL_TX, t0, traceLastWrite());
   }
-
-  // --- Step 7: enter torque control ---
-  executeStep(7);
-  nextionPage(NX_PAGE_DRIVE);
+  lastTorqueSend = millis();
 }
 
-// ---------- Loop ----------
-void loop() {
-  readCanMessages();
+// CAN RX drain, enable sequence, cyclic rates, BAMOCAR supervision and the drive
+// enable/disable button.
+static void supervisorTask() {
+  canBusService();
+  driveSeqTick();
+  bamocarRatesTick();
+  torqueLimitsTick();
 
   // --- BAMOCAR heartbeat timeout ---
   static bool bamocarOffline = false;
   if (currentStep == 7 && bamocarOnline && millis() - lastBAMOCARRx > 500) {
     if (!bamocarOffline) {
+      captureTrigger(CAPTURE_BAMOCAR_OFFLINE, millis() - lastBAMOCARRx);
       bamocarOffline = true;
       bamocarOnline = false;
       driveEnabled = false;
@@ -239,23 +86,31 @@ void loop() {
   // --- BAMOCAR error detection ---
   // On first error: disable drive, switch to boot page, show ERROR + fault name.
   static bool inErrorState = false;
-  if (currentStep == 7 && bamocarErrorWord != 0) {
+  if (currentStep == 7 && bamocar.errorWord != 0) {
     if (!inErrorState) {
+      captureTrigger(CAPTURE_BAMOCAR_ERROR, bamocar.errorWord);
       inErrorState = true;
       driveEnabled = false;
       sendTorqueCommand(0);
       currentTorque = 0;
       char detail[32];
-      bamocarErrorDescription(bamocarErrorWord, detail, sizeof(detail));
+      bamocarErrorDescription(bamocar.errorWord, detail, sizeof(detail));
       nextionPage(NX_PAGE_BOOT);
       nextionBootStatus("ERROR", detail);
     }
-  } else if (inErrorState && bamocarErrorWord == 0) {
+  } else if (inErrorState && bamocar.errorWord == 0) {
     inErrorState = false;
   }
 
+  // --- APPS plausibility fault (latched by the torque task) ---
+  static bool lastPedalFault = false;
+  if (currentStep == 7 && pedalFault && !lastPedalFault) {
+    captureTrigger(CAPTURE_PEDAL_FAULT, (uint32_t)(uint16_t)apps1Raw << 16 | (uint16_t)apps2Raw);
+  }
+  lastPedalFault = pedalFault;
+
   // --- Drive enable/disable toggle ---
-  if (currentStep == 7) {
+  if (currentStep == 7 && !driveSeqActive()) {
     bool pressed = buttonPressed();  // always call to keep state machine in sync
     if (driveEnabled && pressed) {
       // Short press disables drive immediately
@@ -266,50 +121,116 @@ void loop() {
       nextionText(NX_DRIVE_STATE, "OFF");
       buttonResetHold();  // don't count this press toward re-enable hold
     } else if (!driveEnabled) {
-      // Update hold progress bar on t_drive while button is being held
-      static uint32_t lastBarUpdate = 0;
-      if (millis() - lastBarUpdate >= 50) {
-        lastBarUpdate = millis();
-        uint32_t elapsed = buttonHoldElapsed();
-        if (elapsed > 0) {
-          char bar[13];
-          holdBar(elapsed, DRIVE_HOLD_MS, bar);
-          nextionText(NX_DRIVE_STATE, bar);
-        }
-      }
       // 3-second hold triggers full re-enable handshake (mirrors startup)
       if (buttonHeldFor(DRIVE_HOLD_MS)) {
-        reenableDriveSequence();
+        driveSeqReenable();
       }
     }
   }
+}
 
-  // --- Torque control ---
-  // Always send torque (0 when disabled) to keep BAMOCAR CAN watchdog alive.
-  if (currentStep == 7 && millis() - lastTorqueSend >= 20) {
-    if (driveEnabled) updateTorqueFromPedal();
-    else currentTorque = 0;
-    sendTorqueCommand(currentTorque);
-    logSensor(apps1Raw, apps2Raw, pedalFault, currentTorque, rpmFeedback, (int)(dcBusVoltage * 10));
-    mpuController.logTelemetry();
-    lastTorqueSend = millis();
-  }
+// Sensor snapshot, kept at 50 Hz regardless of torque rate.
+static void snapshotTask() {
+  if (currentStep != 7) return;
+  logSensor(apps1Raw, apps2Raw, pedalFault, currentTorque, bamocar.rpmFeedback, (int)(bamocar.dcBusVoltage * 10));
+}
 
-  // --- Periodic flush + display update ---
-  static uint32_t lastFlush = 0;
-  if (millis() - lastFlush > 500) {
-    logFlush();
-    lastFlush = millis();
-    requestDCBusOnce();
+// Drains the IMU FIFO. Before drive the samples are read and dropped so the
+// FIFO never overflows, matching the S record's start.
+static void imuTask() {
+  mpuController.service(currentStep == 7);
+}
+
+// Drive page refresh. Only changed components are queued, each at its own
+// rate; t_drive shows the hold progress bar while the button is held.
+static void displayTask() {
+  if (currentStep != 7 || driveSeqActive()) return;
+#if NX_DEBUG_PAGE
+  if (nextionCurrentPage() == NX_PAGE_DEBUG) {
+    nextionUpdateDebug();
+    return;
+  }
+  if (nextionCurrentPage() == NX_PAGE_CAN) {
+    nextionUpdateCan();
+    return;
+  }
+#endif
+  uint32_t elapsed = driveEnabled ? 0 : buttonHoldElapsed();
+  if (elapsed > 0) {
+    char bar[13];
+    nextionFormatHoldBar(bar, elapsed, DRIVE_HOLD_MS);
+    nextionUpdateDrive(bar);
+  } else {
     nextionUpdateDrive();
-    // nextionUpdateDrive writes "OFF" to t_drive; restore bar if still holding
-    if (!driveEnabled) {
-      uint32_t elapsed = buttonHoldElapsed();
-      if (elapsed > 0) {
-        char bar[13];
-        holdBar(elapsed, DRIVE_HOLD_MS, bar);
-        nextionText(NX_DRIVE_STATE, bar);
-      }
+  }
+}
+
+static void dcBusTask() {
+  if (currentStep != 7 || driveSeqActive()) return;
+  requestDCBusOnce();
+}
+
+static void statsTask() {
+  schedLogStats();
+  schedResetStats();
+  traceLogStats();
+  canStatsLog();
+}
+
+// ---------- Setup ----------
+void setup() {
+  traceBegin();
+  buttonInit();
+  nextionBegin();
+  nextionBootStatus("INITIALISING");
+
+  telemetryBegin();
+
+  bamocarBegin();
+  canBusBegin();
+  canFdBegin();
+  pedalBegin();
+
+  mpuController.begin();
+
+  if (!SD.begin(chipSelect)) {
+    nextionBootStatus("SD: NONE", "logging disabled");
+  } else {
+    char filename[FILE_NAME_LEN];
+    if (!logOpenNext(filename)) {
+      nextionBootStatus("SD: ERROR", "file open failed");
+    } else {
+      nextionBootStatus("SD: OK", filename);
+      captureBegin(filename);
     }
   }
+
+  // Steps 1-7 run from the supervisor task, see drive_sequence.cpp.
+  driveSeqBegin();
+
+  schedAddTimerTask("torque",     torqueTask,     TORQUE_PERIOD_US, TORQUE_DEADLINE_US);
+  schedAddTask("supervisor", supervisorTask,   SUPERVISOR_PERIOD_US,  1, SUPERVISOR_PERIOD_US);
+  schedAddTask("snapshot",   snapshotTask,     SNAPSHOT_PERIOD_US,    2, SNAPSHOT_PERIOD_US / 4);
+  schedAddTask("imu",        imuTask,          IMU_SERVICE_PERIOD_US, 6, 0);
+  schedAddTask("display",    displayTask,      DISPLAY_PERIOD_US,     3, DISPLAY_PERIOD_US / 4);
+  schedAddTask("dcbus",      dcBusTask,        DCBUS_PERIOD_US,       4, 0);
+  schedAddTask("telemetry",  telemetryStatus,  TELEMETRY_PERIOD_US,   4, 0);
+  schedAddTask("stats",      statsTask,        SCHED_STATS_PERIOD_US, 5, 0);
+#if CAN_FD_TELEMETRY
+  schedAddTask("canfd",      canFdState,       CANFD_STATE_PERIOD_US, 4, 0);
+  schedAddTask("canfd_tx",   canFdService,     0,                     8, 0);  // slack
+#endif
+  schedAddTask("nextion",    nextionService,   0,                     8, 0);  // slack
+  schedAddTask("link",       telemetryService, 0,                     8, 0);  // slack
+  schedAddTask("sd",         logService,       0,                     9, 0);  // slack
+#if CAPTURE_ENABLED
+  schedAddTask("capture",    captureService,   0,                     9, 0);  // slack
+#endif
+  schedBegin();
+}
+
+// ---------- Loop ----------
+// All periodic work is registered with the scheduler at the end of setup().
+void loop() {
+  schedRun();
 }
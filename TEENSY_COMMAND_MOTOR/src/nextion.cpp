@@ -1,42 +1,186 @@
 #include "nextion.h"
+#include "trace.h"
+#include "can_stats.h"
+#include "vehicle_state.h"
 
-// Send a Nextion command: flush any pending RX bytes, print the command
-// string, then terminate with three 0xFF bytes.
-// Flushing before each send prevents stale ACK/event bytes from the
-// display accumulating and corrupting subsequent reads (ref: NexHardware.cpp).
+// ---------- TX ring ----------
+// Commands are queued here and moved into the Serial7 TX buffer (enlarged
+// with addMemoryForWrite) only as fast as it has room, so a display update
+// never blocks the caller on the UART.
+static uint8_t  _txRing[NEXTION_TX_RING];
+static uint16_t _txHead = 0;  // next write
+static uint16_t _txTail = 0;  // next byte to send
+static uint8_t  _serialTxMem[NEXTION_TX_SERIAL_MEM];
+
+static NextionStats _stats = {};
+static uint8_t _page = NX_PAGE_BOOT;
+
+static uint16_t txFree() {
+  return (uint16_t)(NEXTION_TX_RING - 1 - ((_txHead - _txTail) & (NEXTION_TX_RING - 1)));
+}
+
+static void txDrain() {
+  int room = NEXTION_SERIAL.availableForWrite();
+  while (room > 0 && _txTail != _txHead) {
+    uint16_t end = (_txHead > _txTail) ? _txHead : NEXTION_TX_RING;
+    uint16_t n = end - _txTail;
+    if (n > (uint16_t)room) n = (uint16_t)room;
+    NEXTION_SERIAL.write(&_txRing[_txTail], n);
+    _txTail = (_txTail + n) & (NEXTION_TX_RING - 1);
+    room -= n;
+  }
+}
+
+static void shadowInvalidate();
+
+// Queue a Nextion command: the command string terminated with three 0xFF
+// bytes. A command that does not fit is dropped whole, never truncated, and
+// the shadow cache is cleared so the lost value is sent again.
 static void sendCommand(const char *cmd) {
-  while (NEXTION_SERIAL.available()) NEXTION_SERIAL.read();
-  NEXTION_SERIAL.print(cmd);
-  NEXTION_SERIAL.write(0xFF);
-  NEXTION_SERIAL.write(0xFF);
-  NEXTION_SERIAL.write(0xFF);
+  size_t len = strlen(cmd);
+  if (len + 3 > txFree()) {
+    _stats.dropped++;
+    shadowInvalidate();
+    return;
+  }
+  for (size_t i = 0; i < len + 3; i++) {
+    _txRing[_txHead] = (i < len) ? (uint8_t)cmd[i] : 0xFF;
+    _txHead = (_txHead + 1) & (NEXTION_TX_RING - 1);
+  }
+  _stats.commands++;
+  _stats.bytes += len + 3;
+  txDrain();
+}
+
+// ---------- RX parser ----------
+// Return codes arrive as <code> [data...] FF FF FF. With bkcmd=2 the display
+// only answers failed commands, so codes below 0x24 are all errors.
+// Touch (0x65) and sendme (0x66) events carry the page the display is on.
+static uint8_t _rxBuf[8];
+static uint8_t _rxLen = 0;
+static uint8_t _rxEnds = 0;  // consecutive 0xFF seen
+
+static void rxFrame() {
+  if (_rxLen == 0) return;
+  uint8_t code = _rxBuf[0];
+  if (code < 0x24) {
+    _stats.errors++;
+    _stats.lastError = code;
+  } else if ((code == 0x65 || code == 0x66) && _rxLen >= 2 && _rxBuf[1] != _page) {
+    _page = _rxBuf[1];
+    shadowInvalidate();
+  }
+}
+
+static void rxPoll() {
+  while (NEXTION_SERIAL.available()) {
+    uint8_t b = (uint8_t)NEXTION_SERIAL.read();
+    if (b == 0xFF) {
+      if (++_rxEnds == 3) {
+        rxFrame();
+        _rxLen = _rxEnds = 0;
+      }
+      continue;
+    }
+    // Lone 0xFF bytes were data (e.g. in a 0x71 number reply).
+    for (; _rxEnds > 0; _rxEnds--) {
+      if (_rxLen < sizeof(_rxBuf)) _rxBuf[_rxLen++] = 0xFF;
+    }
+    if (_rxLen < sizeof(_rxBuf)) _rxBuf[_rxLen++] = b;
+  }
+}
+
+// ---------- Shadow state ----------
+// Last value written to each component, as a hash. Writes that would not
+// change what is on screen are skipped. A page change reloads every
+// component from the editor defaults, so it invalidates the whole cache.
+struct Shadow {
+  const char *component;
+  uint32_t    hash;
+};
+
+static Shadow  _shadow[NEXTION_SHADOW_SLOTS];
+static uint8_t _shadowCount = 0;
+
+static uint32_t hashText(const char *text) {
+  uint32_t h = 2166136261u;  // FNV-1a
+  while (*text) h = (h ^ (uint8_t)*text++) * 16777619u;
+  return h;
+}
+
+// Returns true if component should be written (value changed or unknown)
+// and records hash as its new value.
+static bool shadowUpdate(const char *component, uint32_t hash) {
+  Shadow *s = nullptr;
+  for (uint8_t i = 0; i < _shadowCount; i++) {
+    if (_shadow[i].component == component || strcmp(_shadow[i].component, component) == 0) {
+      s = &_shadow[i];
+      break;
+    }
+  }
+  if (s && s->hash == hash) {
+    _stats.skipped++;
+    return false;
+  }
+  if (!s && _shadowCount < NEXTION_SHADOW_SLOTS) s = &_shadow[_shadowCount++];
+  if (s) {
+    s->component = component;
+    s->hash = hash;
+  }
+  return true;
+}
+
+static bool _driveRefresh = true;  // see nextionUpdateDrive()
+
+static void shadowInvalidate() {
+  _shadowCount = 0;
+  _driveRefresh = true;
 }
 
+// ---------- Commands ----------
 void nextionBegin() {
   NEXTION_SERIAL.begin(NEXTION_BAUD);
+  NEXTION_SERIAL.addMemoryForWrite(_serialTxMem, sizeof(_serialTxMem));
   delay(100);
   // Initialisation sequence (ref: nexInit() in NexHardware.cpp):
   //   empty command  — clears any garbage in the display's RX buffer
-  //   bkcmd=1        — display sends a return code after every command
+  //   bkcmd=2        — display answers failed commands only, no reply per success
   //   page 0         — ensure we start on the boot page
   sendCommand("");
-  sendCommand("bkcmd=1");
-  sendCommand("page 0");
+  sendCommand("bkcmd=2");
+  nextionPage(NX_PAGE_BOOT);
+}
+
+void nextionService() {
+  rxPoll();
+  txDrain();
+}
+
+const NextionStats &nextionStats() {
+  return _stats;
 }
 
 void nextionPage(uint8_t page) {
   char cmd[16];
   snprintf(cmd, sizeof(cmd),"page %d", page);
   sendCommand(cmd);
+  shadowInvalidate();
+  _page = page;
+}
+
+uint8_t nextionCurrentPage() {
+  return _page;
 }
 
 void nextionText(const char *component, const char *text) {
+  if (!shadowUpdate(component, hashText(text))) return;
   char cmd[80];
   snprintf(cmd, sizeof(cmd), "%s.txt=\"%s\"", component, text);
   sendCommand(cmd);
 }
 
 void nextionNum(const char *component, int value) {
+  if (!shadowUpdate(component, (uint32_t)value)) return;
   char cmd[32];
   snprintf(cmd, sizeof(cmd), "%s.val=%d", component, value);
   sendCommand(cmd);
@@ -47,21 +191,103 @@ void nextionBootStatus(const char *phase, const char *detail) {
   if (detail[0] != '\0') nextionText(NX_BOOT_DETAIL, detail);
 }
 
-// rpmFeedback is normalised: 32767 = RPM_MAX. Convert to actual RPM then km/h.
-// km/h formula: v = (2π × n × r_w) / (60 × G), r_w=0.247m, G=5.25 → 0.01775 km/h per RPM
-static float rpm_to_kmh(int normalised) {
-  float actual_rpm = (float)normalised / 32767.0f * RPM_MAX;
-  return 0.01775f * actual_rpm;
+// Fills buf (must be ≥13 bytes) with an ASCII progress bar like [####      ]
+// elapsed/total drives fill level; bar is always 10 chars wide.
+void nextionFormatHoldBar(char *buf, uint32_t elapsed, uint32_t total) {
+  int filled = (int)(elapsed * 10 / total);
+  if (filled > 10) filled = 10;
+  buf[0] = '[';
+  for (int i = 0; i < 10; i++) buf[i + 1] = (i < filled) ? '#' : ' ';
+  buf[11] = ']';
+  buf[12] = '\0';
+}
+
+void nextionHoldBar(const char *component, uint32_t elapsed, uint32_t total) {
+  char bar[13];
+  nextionFormatHoldBar(bar, elapsed, total);
+  nextionText(component, bar);
+}
+
+// ---------- Drive page ----------
+// Per-component refresh periods; a component is re-sent at most this often,
+// and only if its value changed since the last send.
+enum DriveField { DF_SPEED, DF_RPM, DF_TORQUE, DF_DCBUS, DF_FAULT, DF_STATE, DF_MTEMP, DF_ITEMP, DF_COUNT };
+
+static const uint16_t DRIVE_PERIOD_MS[DF_COUNT] = {
+  NX_SPEED_PERIOD_MS, NX_RPM_PERIOD_MS, NX_TORQUE_PERIOD_MS, NX_DCBUS_PERIOD_MS,
+  NX_FAULT_PERIOD_MS, NX_STATE_PERIOD_MS, NX_TEMP_PERIOD_MS, NX_TEMP_PERIOD_MS,
+};
+static uint32_t _driveLastMs[DF_COUNT];
+
+static bool driveDue(DriveField f, uint32_t now) {
+  if (now - _driveLastMs[f] < DRIVE_PERIOD_MS[f]) return false;
+  _driveLastMs[f] = now;
+  return true;
+}
+
+// After a page change or dropped command every field is due at once, so
+// the display never shows editor defaults for a whole temperature period.
+void nextionUpdateDrive(const char *state) {
+  uint32_t now = millis();
+  if (_driveRefresh) {
+    for (uint8_t f = 0; f < DF_COUNT; f++) _driveLastMs[f] = now - DRIVE_PERIOD_MS[f];
+    _driveRefresh = false;
+  }
+  if (driveDue(DF_SPEED, now))  nextionNum(NX_DRIVE_SPEED,  (int)(vehicleState().speedMs * 3.6f));
+  if (driveDue(DF_RPM, now))    nextionNum(NX_DRIVE_RPM,    (int)((float)bamocar.rpmFeedback / 32767.0f * RPM_MAX));
+  if (driveDue(DF_TORQUE, now)) nextionNum(NX_DRIVE_TORQUE, (int)((float)currentTorque / TORQUE_MAX * 100.0f));
+  if (driveDue(DF_DCBUS, now))  nextionNum(NX_DRIVE_DCBUS,  (int)bamocar.dcBusVoltage);
+  if (driveDue(DF_FAULT, now))  nextionText(NX_DRIVE_FAULT, pedalFault ? "FAULT" : "OK");
+  if (driveDue(DF_STATE, now))  nextionText(NX_DRIVE_STATE, state ? state : (driveEnabled ? "ON" : "OFF"));
+  if (driveDue(DF_MTEMP, now))  nextionNum(NX_DRIVE_MTEMP,  (int)bamocar.motorTemp);
+  if (driveDue(DF_ITEMP, now))  nextionNum(NX_DRIVE_ITEMP,  (int)bamocar.inverterTemp);
 }
 
-void nextionUpdateDrive() {
-  int actual_rpm = (int)((float)rpmFeedback / 32767.0f * RPM_MAX);
-  nextionNum(NX_DRIVE_SPEED,  (int)rpm_to_kmh(rpmFeedback));
-  nextionNum(NX_DRIVE_RPM,    actual_rpm);
-  nextionNum(NX_DRIVE_TORQUE, (int)((float)currentTorque / TORQUE_MAX * 100.0f));
-  nextionNum(NX_DRIVE_DCBUS,  (int)dcBusVoltage);
-  nextionText(NX_DRIVE_FAULT, pedalFault ? "FAULT" : "OK");
-  nextionText(NX_DRIVE_STATE, driveEnabled ? "ON" : "OFF");
-  nextionNum(NX_DRIVE_MTEMP, (int)motorTemp);
-  nextionNum(NX_DRIVE_ITEMP, (int)inverterTemp);
+#if NX_DEBUG_PAGE
+// ---------- Debug page ----------
+// Latest one-second latency summaries; the shadow cache makes repeat calls
+// free until the stats task publishes new numbers.
+static void debugLine(const char *component, uint8_t path) {
+  const TraceSummary &t = traceLast(path);
+  char line[48];
+  snprintf(line, sizeof(line), "%s %lu.%lu/%lu.%lu/%lu.%lu us", tracePathName(path),
+           t.avg / 10, t.avg % 10, t.p99 / 10, t.p99 % 10, t.max / 10, t.max % 10);
+  nextionText(component, line);
+}
+
+void nextionUpdateDebug() {
+  debugLine(NX_DEBUG_LAT0, TRACE_PEDAL_TORQUE);
+  debugLine(NX_DEBUG_LAT1, TRACE_PEDAL_TX);
+  debugLine(NX_DEBUG_LAT2, TRACE_RTT + (bamocarRegister(REG_STATUS) - BAMOCAR_REGISTERS));
+  debugLine(NX_DEBUG_LAT3, TRACE_RTT + (bamocarRegister(REG_DC_BUS_VOLTAGE) - BAMOCAR_REGISTERS));
+}
+
+// ---------- CAN page ----------
+// From the latest canStatsLog() window, like the latency page.
+static const char *const CAN_BUS_COMPONENTS[] = { NX_CAN_BUS1, NX_CAN_BUS2, NX_CAN_BUS3 };
+static const char *const CAN_ID_COMPONENTS[]  = { NX_CAN_ID0, NX_CAN_ID1, NX_CAN_ID2 };
+static const char *const CAN_STATE_NAMES[]    = { "OK", "PASSIVE", "BUS OFF" };
+
+void nextionUpdateCan() {
+  char line[48];
+  for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+    const CanLoadSummary &s = canStatsLast(bus);
+    snprintf(line, sizeof(line), "CAN%u %u.%u%% pk %u.%u%% T%u R%u %s", canBusNumber(bus),
+             s.loadPermille / 10, s.loadPermille % 10, s.peakPermille / 10, s.peakPermille % 10,
+             s.tec, s.rec, CAN_STATE_NAMES[s.state]);
+    nextionText(CAN_BUS_COMPONENTS[bus], line);
+  }
+  CanIdSummary busiest[3];
+  uint8_t n = canStatsBusiest(busiest, 3);
+  for (uint8_t i = 0; i < 3; i++) {
+    const CanIdSummary &s = busiest[i];
+    if (i >= n) {
+      nextionText(CAN_ID_COMPONENTS[i], "");
+      continue;
+    }
+    snprintf(line, sizeof(line), "%s%u %03lX %lu/s gap %lu-%luus", s.tx ? "TX" : "RX", s.bus,
+             s.id, s.frames * 1000 / (SCHED_STATS_PERIOD_US / 1000), s.minGapUs, s.maxGapUs);
+    nextionText(CAN_ID_COMPONENTS[i], line);
+  }
 }
+#endif
@@ -1,52 +1,193 @@
 #include "pedal.h"
+#include "irq_guard.h"
+#include "fault_capture.h"
+#include "torque_shaping.h"
 #include <math.h>
 
-// Converts a raw ADC reading to a 0–100% pedal position.
+#if APPS_ACQ_MODE == APPS_ACQ_DMA
+#include <ADC.h>
+#include <AnalogBufferDMA.h>
+#endif
+
+// Converts a raw ADC reading to a 0–1000 pedal position (0.1 % steps).
 // REST and FULL can be in either direction (rising or falling sensor).
-// Soft-clamped: out-of-range readings never produce an error, just 0% or 100%.
-static float appsPercent(int raw, int rest, int full) {
-  float pct = (float)(rest - raw) * 100.0f / (float)(rest - full);
-  if (pct < 0.0f) pct = 0.0f;
-  if (pct > 100.0f) pct = 100.0f;
-  return pct;
+// Soft-clamped: out-of-range readings never produce an error, just 0 or 1000.
+static int appsPermille(int raw, int rest, int full) {
+  int pm = (rest - raw) * 1000 / (rest - full);
+  if (pm < 0) pm = 0;
+  if (pm > 1000) pm = 1000;
+  return pm;
+}
+
+// ---------- Acquisition ----------
+// Every sample pair goes through a median-of-3 (drops single spikes) and
+// the plausibility check. The pair's filtered values are averaged into
+// apps1Raw/apps2Raw once per pedalSample() call. The raw pairs also go to
+// the fault capture ring.
+//
+// The run of bad pairs can end inside a block, so both outcomes are
+// latched per pair: _faultRun once the run reaches APPS_FAULT_SAMPLES,
+// _implausible for any bad pair. They stay set until
+// updateTorqueFromPedal() takes them, whoever filtered the block.
+static uint16_t _hist1[2], _hist2[2];  // previous two raw samples per sensor
+static uint8_t  _badRun = 0;           // consecutive implausible filtered pairs
+static bool     _faultRun = false;     // a run reached APPS_FAULT_SAMPLES
+static bool     _implausible = false;  // some filtered pair disagreed
+static uint32_t _lastSampleMs = 0;
+
+static inline uint16_t med3(uint16_t a, uint16_t b, uint16_t c) {
+  uint16_t lo = a < b ? a : b;
+  uint16_t hi = a < b ? b : a;
+  return c < lo ? lo : (c > hi ? hi : c);
+}
+
+void pedalFilter(const volatile uint16_t *s1, const volatile uint16_t *s2, uint16_t n) {
+  static bool primed = false;
+  if (n == 0) return;
+  capturePedal(s1, s2, n);
+  if (!primed) {
+    _hist1[0] = _hist1[1] = s1[0];
+    _hist2[0] = _hist2[1] = s2[0];
+    primed = true;
+  }
+  uint32_t sum1 = 0, sum2 = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    uint16_t m1 = med3(_hist1[0], _hist1[1], s1[i]);
+    uint16_t m2 = med3(_hist2[0], _hist2[1], s2[i]);
+    _hist1[0] = _hist1[1]; _hist1[1] = s1[i];
+    _hist2[0] = _hist2[1]; _hist2[1] = s2[i];
+    sum1 += m1;
+    sum2 += m2;
+
+    int d = appsPermille(m1, APPS1_REST, APPS1_FULL) - appsPermille(m2, APPS2_REST, APPS2_FULL);
+    if (abs(d) <= PEDAL_PLAUSIBILITY_PERCENT * 10) {
+      _badRun = 0;
+      continue;
+    }
+    _implausible = true;
+    if (_badRun < 255) _badRun++;
+    if (_badRun >= APPS_FAULT_SAMPLES) _faultRun = true;
+  }
+  apps1Raw = (int16_t)(sum1 / n);
+  apps2Raw = (int16_t)(sum2 / n);
+  _lastSampleMs = millis();
 }
 
+#if APPS_ACQ_MODE == APPS_ACQ_DMA
+// ADC0 samples APPS1 and ADC1 samples APPS2, both on a hardware timer at
+// APPS_SAMPLE_HZ. DMA ping-pongs between two APPS_DMA_BLOCK buffers per
+// sensor, so one completed block is always ready to filter while the other
+// fills; nothing runs on the CPU per conversion.
+static ADC adc;
+DMAMEM static volatile uint16_t __attribute__((aligned(32))) _dma1[2][APPS_DMA_BLOCK];
+DMAMEM static volatile uint16_t __attribute__((aligned(32))) _dma2[2][APPS_DMA_BLOCK];
+static AnalogBufferDMA _apps1Dma(_dma1[0], APPS_DMA_BLOCK, _dma1[1], APPS_DMA_BLOCK);
+static AnalogBufferDMA _apps2Dma(_dma2[0], APPS_DMA_BLOCK, _dma2[1], APPS_DMA_BLOCK);
+
+static void adcSetup(ADC_Module *m) {
+  m->setAveraging(1);  // filtering is ours; keep every conversion
+  m->setResolution(12);
+  m->setConversionSpeed(ADC_CONVERSION_SPEED::HIGH_SPEED);
+  m->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);
+}
+
+void pedalBegin() {
+  adcSetup(adc.adc0);
+  adcSetup(adc.adc1);
+  _apps1Dma.init(&adc, ADC_0);
+  _apps2Dma.init(&adc, ADC_1);
+  adc.adc0->startSingleRead(APPS1_PIN);
+  adc.adc1->startSingleRead(APPS2_PIN);
+  adc.adc0->startTimer(APPS_SAMPLE_HZ);
+  adc.adc1->startTimer(APPS_SAMPLE_HZ);
+  _lastSampleMs = millis();
+}
+
+// Filters the newest completed block pair. There is nothing older to
+// drain: with two buffers per sensor, once a second block completes the
+// DMA is already refilling the first. A skipped block leaves a gap in the
+// bad-pair run, not a reset (only a good pair resets it), so a sensor that
+// stays implausible still latches; losing blocks altogether trips
+// APPS_STALE_MS below.
+bool pedalSample() {
+  IrqGuard lock;  // torque task and the enable sequence both sample
+  if (!_apps1Dma.interrupted() || !_apps2Dma.interrupted()) return false;
+  volatile uint16_t *s1 = _apps1Dma.bufferLastISRFilled();
+  volatile uint16_t *s2 = _apps2Dma.bufferLastISRFilled();
+  uint16_t n1 = _apps1Dma.bufferCountLastISRFilled();
+  uint16_t n2 = _apps2Dma.bufferCountLastISRFilled();
+  arm_dcache_delete((void *)s1, n1 * sizeof(uint16_t));
+  arm_dcache_delete((void *)s2, n2 * sizeof(uint16_t));
+  pedalFilter(s1, s2, n1 < n2 ? n1 : n2);
+  _apps1Dma.clearInterrupt();
+  _apps2Dma.clearInterrupt();
+  return true;
+}
+#else
+void pedalBegin() {
+  analogReadResolution(12);
+  _lastSampleMs = millis();
+}
+
+// One blocking conversion per sensor, still run through the same filter.
+bool pedalSample() {
+  uint16_t s1 = analogRead(APPS1_PIN);
+  uint16_t s2 = analogRead(APPS2_PIN);
+  IrqGuard lock;
+  pedalFilter(&s1, &s2, 1);
+  return true;
+}
+#endif
+
+bool pedalAtRest() {
+  pedalSample();
+  return appsPermille(apps1Raw, APPS1_REST, APPS1_FULL) < PEDAL_DEADBAND_PERCENT * 10;
+}
+
+// Fixed point throughout (0.1 % steps); torque_shaping.h maps and limits.
 void updateTorqueFromPedal() {
-  apps1Raw = analogRead(APPS1_PIN);
-  apps2Raw = analogRead(APPS2_PIN);
-
-  float pct1 = appsPercent(apps1Raw, APPS1_REST, APPS1_FULL);
-  float pct2 = appsPercent(apps2Raw, APPS2_REST, APPS2_FULL);
-
-  // Plausibility: sensors must agree within PEDAL_PLAUSIBILITY_PERCENT.
-  // Fault only latches after 3 consecutive bad readings (~60ms) to reject
-  // single noisy samples. Zero torque immediately on any bad reading.
-  static int plausibilityCount = 0;
-  if (fabsf(pct1 - pct2) > PEDAL_PLAUSIBILITY_PERCENT) {
-    plausibilityCount++;
-    if (plausibilityCount >= 3) pedalFault = true;
+  // No new block for several periods means acquisition stopped: fail safe.
+  if (!pedalSample() && millis() - _lastSampleMs > APPS_STALE_MS) {
+    pedalFault = true;
+    currentTorque = 0;
+    torqueShapeReset();
+    return;
+  }
+
+  int pm1 = appsPermille(apps1Raw, APPS1_REST, APPS1_FULL);
+  int pm2 = appsPermille(apps2Raw, APPS2_REST, APPS2_FULL);
+
+  // Plausibility: filtered sensors must agree within PEDAL_PLAUSIBILITY_PERCENT.
+  // Fault only latches after APPS_FAULT_SAMPLES consecutive bad filtered
+  // pairs (~1 ms in DMA mode) to reject noise. Zero torque immediately if
+  // any pair since the last tick disagreed.
+  bool implausible = _implausible;
+  if (_faultRun) pedalFault = true;
+  _faultRun = _implausible = false;
+  if (implausible) {
     currentTorque = 0;
+    torqueShapeReset();
     return;
   }
-  plausibilityCount = 0;
 
   if (pedalFault) {
-    if (pct1 < PEDAL_DEADBAND_PERCENT && pct2 < PEDAL_DEADBAND_PERCENT) {
+    if (pm1 < PEDAL_DEADBAND_PERCENT * 10 && pm2 < PEDAL_DEADBAND_PERCENT * 10) {
       pedalFault = false;
     } else {
       currentTorque = 0;
+      torqueShapeReset();
       return;
     }
   }
 
   // Average both sensors (they agree within plausibility threshold).
-  float pct = (pct1 + pct2) * 0.5f;
+  int pm = (pm1 + pm2) / 2;
 
   // Dead band: absorbs calibration offset at rest, eliminates torque creep.
-  if (pct < PEDAL_DEADBAND_PERCENT) pct = 0.0f;
+  if (pm < PEDAL_DEADBAND_PERCENT * 10) pm = 0;
 
   // Cap at configured maximum acceleration
-  if (pct > MAX_ACCEL_PERCENT) pct = (float)MAX_ACCEL_PERCENT;
+  if (pm > MAX_ACCEL_PERCENT * 10) pm = MAX_ACCEL_PERCENT * 10;
 
-  currentTorque = (int16_t)(TORQUE_MAX * (pct / 100.0f));
+  currentTorque = torqueShape((uint16_t)pm);
 }
@@ -0,0 +1,144 @@
+#include "scheduler.h"
+#include "logging.h"
+
+struct Task {
+  TaskFn   fn;
+  uint8_t  priority;
+  bool     timer;
+  uint32_t nextUs;  // next release (cooperative tasks)
+  TaskStats stats;
+};
+
+static Task     _tasks[SCHED_MAX_TASKS];
+static uint8_t  _count = 0;
+static int8_t   _timerTask = -1;
+static uint32_t _timerLastUs = 0;
+static IntervalTimer _timer;
+
+static const uint32_t _histEdges[SCHED_HIST_BUCKETS - 1] = { 10, 50, 100, 500, 2000 };
+
+// Records one run: late = release-to-start delay, run = execution time.
+static void _account(Task &t, uint32_t late, uint32_t run) {
+  TaskStats &s = t.stats;
+  s.runs++;
+  if (late > s.maxJitterUs) s.maxJitterUs = late;
+  if (run  > s.maxRunUs)    s.maxRunUs = run;
+  if (t.stats.deadlineUs && late + run > s.deadlineUs) s.overruns++;
+  uint8_t b = 0;
+  while (b < SCHED_HIST_BUCKETS - 1 && late >= _histEdges[b]) b++;
+  if (s.hist[b] < 0xFFFF) s.hist[b]++;
+}
+
+static int8_t _add(const char *name, TaskFn fn, uint32_t periodUs,
+                   uint8_t priority, uint32_t deadlineUs, bool timer) {
+  if (_count >= SCHED_MAX_TASKS) return -1;
+  Task &t = _tasks[_count];
+  memset(&t, 0, sizeof(t));
+  t.fn = fn;
+  t.priority = priority;
+  t.timer = timer;
+  t.stats.name = name;
+  t.stats.periodUs = periodUs;
+  t.stats.deadlineUs = deadlineUs;
+  return (int8_t)_count++;
+}
+
+int8_t schedAddTask(const char *name, TaskFn fn, uint32_t periodUs,
+                    uint8_t priority, uint32_t deadlineUs) {
+  return _add(name, fn, periodUs, priority, deadlineUs, false);
+}
+
+int8_t schedAddTimerTask(const char *name, TaskFn fn, uint32_t periodUs,
+                         uint32_t deadlineUs) {
+  if (_timerTask >= 0) return -1;
+  int8_t id = _add(name, fn, periodUs, 0, deadlineUs, true);
+  _timerTask = id;
+  return id;
+}
+
+// IntervalTimer ISR. Jitter is measured against the ideal period since
+// the previous start.
+static void _timerISR() {
+  Task &t = _tasks[_timerTask];
+  uint32_t start = micros();
+  uint32_t since = start - _timerLastUs;
+  uint32_t late  = (since > t.stats.periodUs) ? since - t.stats.periodUs
+                                              : t.stats.periodUs - since;
+  _timerLastUs = start;
+  t.fn();
+  _account(t, late, micros() - start);
+}
+
+void schedBegin() {
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < _count; i++) _tasks[i].nextUs = now;
+  if (_timerTask >= 0) {
+    _timerLastUs = now;
+    _timer.begin(_timerISR, _tasks[_timerTask].stats.periodUs);
+  }
+}
+
+// Runs the single highest-priority released task, or every background task
+// when nothing periodic is due. A task that falls a whole period behind
+// skips the missed releases and counts them as overruns.
+void schedRun() {
+  uint32_t now = micros();
+  int8_t pick = -1;
+  for (uint8_t i = 0; i < _count; i++) {
+    Task &t = _tasks[i];
+    if (t.timer || t.stats.periodUs == 0) continue;
+    if ((int32_t)(now - t.nextUs) < 0) continue;
+    if (pick < 0 || t.priority < _tasks[pick].priority) pick = i;
+  }
+
+  if (pick < 0) {
+    for (uint8_t i = 0; i < _count; i++) {
+      Task &t = _tasks[i];
+      if (t.timer || t.stats.periodUs != 0) continue;
+      uint32_t start = micros();
+      t.fn();
+      _account(t, 0, micros() - start);
+    }
+    return;
+  }
+
+  Task &t = _tasks[pick];
+  uint32_t start = micros();
+  uint32_t late  = start - t.nextUs;
+  t.fn();
+  _account(t, late, micros() - start);
+
+  t.nextUs += t.stats.periodUs;
+  uint32_t after = micros();
+  if ((int32_t)(after - t.nextUs) >= 0) {
+    uint32_t missed = (after - t.nextUs) / t.stats.periodUs + 1;
+    t.stats.overruns += missed;
+    t.nextUs += missed * t.stats.periodUs;
+  }
+}
+
+uint8_t schedTaskCount() {
+  return _count;
+}
+
+const TaskStats &schedStats(uint8_t id) {
+  return _tasks[id].stats;
+}
+
+const uint32_t *schedHistEdges() {
+  return _histEdges;
+}
+
+void schedResetStats() {
+  for (uint8_t i = 0; i < _count; i++) {
+    TaskStats &s = _tasks[i].stats;
+    s.runs = s.overruns = s.maxJitterUs = s.maxRunUs = 0;
+    memset(s.hist, 0, sizeof(s.hist));
+  }
+}
+
+void schedLogStats() {
+  for (uint8_t i = 0; i < _count; i++) {
+    logSchedStats(i, _tasks[i].stats);
+  }
+}
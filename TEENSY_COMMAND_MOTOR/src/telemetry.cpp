@@ -0,0 +1,79 @@
+#include "telemetry.h"
+
+// ---------- TX ring ----------
+// Same scheme as the Nextion output path: whole encoded frames go into the
+// ring, TELEMETRY_SERIAL takes them as fast as its buffer has room.
+static uint8_t  _txRing[TELEMETRY_TX_RING];
+static uint16_t _txHead = 0;
+static uint16_t _txTail = 0;
+static uint8_t  _serialTxMem[TELEMETRY_TX_SERIAL_MEM];
+static uint8_t  _seq = 0;
+static TelemetryStats _stats = {};
+
+static_assert((TELEMETRY_TX_RING & (TELEMETRY_TX_RING - 1)) == 0, "TELEMETRY_TX_RING must be a power of two");
+
+static uint16_t txFree() {
+  return (uint16_t)(TELEMETRY_TX_RING - 1 - ((_txHead - _txTail) & (TELEMETRY_TX_RING - 1)));
+}
+
+static void send(uint8_t type, const void *payload, size_t len) {
+  uint8_t frame[TL_MAX_ENCODED];
+  size_t n = tlEncode(type, _seq++, payload, len, frame);
+  if (n == 0 || n > txFree()) {
+    _stats.dropped++;  // seq still advances, so the bridge counts the gap
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    _txRing[_txHead] = frame[i];
+    _txHead = (_txHead + 1) & (TELEMETRY_TX_RING - 1);
+  }
+  _stats.frames++;
+}
+
+void telemetryBegin() {
+  TELEMETRY_SERIAL.begin(TELEMETRY_BAUD);
+  TELEMETRY_SERIAL.addMemoryForWrite(_serialTxMem, sizeof(_serialTxMem));
+}
+
+void telemetryService() {
+  int room = TELEMETRY_SERIAL.availableForWrite();
+  while (room > 0 && _txTail != _txHead) {
+    uint16_t end = (_txHead > _txTail) ? _txHead : TELEMETRY_TX_RING;
+    uint16_t n = end - _txTail;
+    if (n > (uint16_t)room) n = (uint16_t)room;
+    TELEMETRY_SERIAL.write(&_txRing[_txTail], n);
+    _txTail = (_txTail + n) & (TELEMETRY_TX_RING - 1);
+    room -= n;
+  }
+}
+
+const TelemetryStats &telemetryStats() {
+  return _stats;
+}
+
+// ---------- Messages ----------
+void telemetryStatus() {
+  TlStatus s;
+  s.ms             = millis();
+  s.rpm            = (int16_t)((float)bamocar.rpmFeedback / 32767.0f * RPM_MAX);
+  s.torquePermille = (int16_t)((int32_t)currentTorque * 1000 / TORQUE_MAX);
+  s.dcBusDeciVolts = (uint16_t)(bamocar.dcBusVoltage * 10.0f);
+  s.motorTempDeci  = (int16_t)(bamocar.motorTemp * 10.0f);
+  s.igbtTempDeci   = (int16_t)(bamocar.inverterTemp * 10.0f);
+  s.errorWord      = (uint16_t)bamocar.errorWord;
+  s.apps1Raw       = (uint16_t)apps1Raw;
+  s.apps2Raw       = (uint16_t)apps2Raw;
+  s.step           = currentStep;
+  s.flags          = (driveEnabled ? TL_FLAG_DRIVE : 0) | (bamocarOnline ? TL_FLAG_ONLINE : 0) |
+                     (pedalFault ? TL_FLAG_PEDAL : 0);
+  send(TL_STATUS, &s, sizeof(s));
+}
+
+void telemetryCanFrame(const CAN_message_t &msg, uint32_t rxMs) {
+  TlCanFrame f;
+  f.ms     = rxMs;
+  f.id     = (uint16_t)msg.id;
+  f.len    = msg.len;
+  memcpy(f.data, msg.buf, sizeof(f.data));
+  send(TL_CAN, &f, sizeof(f));
+}
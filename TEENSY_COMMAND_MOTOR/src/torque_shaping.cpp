@@ -0,0 +1,86 @@
+#include "torque_shaping.h"
+#include "irq_guard.h"
+
+// ---------- Pedal map ----------
+static const uint8_t MAP[] = TORQUE_MAP;
+static const uint16_t MAP_POINTS = sizeof(MAP) / sizeof(MAP[0]);
+static const uint16_t MAP_STEP = 1000 / (MAP_POINTS - 1);  // pedal ‰ between points
+static_assert(MAP_POINTS >= 2 && 1000 % (MAP_POINTS - 1) == 0, "TORQUE_MAP points must split 0..100 % evenly");
+
+// Counts per torque tick for a full-scale step.
+static const int16_t RISE_STEP = (int32_t)TORQUE_MAX * TORQUE_PERIOD_US / (TORQUE_RISE_MS * 1000L) + 1;
+static const int16_t FALL_STEP = (int32_t)TORQUE_MAX * TORQUE_PERIOD_US / (TORQUE_FALL_MS * 1000L) + 1;
+
+static volatile int16_t _limit = 0;  // single halfword: written and read without a lock
+static int16_t _out = 0;
+static TorqueLimits _limits = {};
+
+static int16_t mapPedal(uint16_t pm) {
+  if (pm >= 1000) return (int16_t)((int32_t)MAP[MAP_POINTS - 1] * TORQUE_MAX / 100);
+  uint16_t i = pm / MAP_STEP;
+  int32_t f = pm % MAP_STEP;
+  int32_t pctScaled = MAP[i] * MAP_STEP + (MAP[i + 1] - MAP[i]) * f;  // % x MAP_STEP
+  return (int16_t)(pctScaled * TORQUE_MAX / (100 * MAP_STEP));
+}
+
+int16_t torqueShape(uint16_t pedalPermille) {
+  int16_t demand = mapPedal(pedalPermille);
+  int16_t limit = _limit;
+  if (demand > limit) demand = limit;
+  if (demand >= _out) {
+    _out = demand - _out > RISE_STEP ? _out + RISE_STEP : demand;
+  } else {
+    _out = _out - demand > FALL_STEP ? _out - FALL_STEP : demand;
+  }
+  if (_out > limit) _out = limit;
+  return _out;
+}
+
+void torqueShapeReset() {
+  IrqGuard lock;
+  _out = 0;
+}
+
+// ---------- Limits ----------
+// Linear from TORQUE_MAX at start to 0 at end.
+static int16_t derate(int32_t x, int32_t start, int32_t end) {
+  if (x <= start) return TORQUE_MAX;
+  if (x >= end) return 0;
+  return (int16_t)((int32_t)TORQUE_MAX * (end - x) / (end - start));
+}
+
+// counts = P * 60 / (2π rpm) * TORQUE_MAX / TORQUE_NM_AT_MAX, with the
+// constant folded: P * POWER_K / rpm stays within 32 bits.
+static const uint32_t POWER_K = 60ull * TORQUE_MAX * 1000 / (6283ull * TORQUE_NM_AT_MAX);
+static_assert((uint64_t)TORQUE_POWER_LIMIT_W * POWER_K < 0xFFFFFFFFull, "TORQUE_POWER_LIMIT_W overflows the power limit");
+
+static int16_t powerLimit(int32_t rpm, int32_t dcBusV) {
+  uint32_t watts = TORQUE_POWER_LIMIT_W;
+  if (dcBusV >= TORQUE_DCBUS_MIN_V && (uint32_t)dcBusV * TORQUE_DC_CURRENT_A < watts) {
+    watts = (uint32_t)dcBusV * TORQUE_DC_CURRENT_A;
+  }
+  watts = watts * TORQUE_EFFICIENCY_PERCENT / 100;
+  if (rpm <= 0) return TORQUE_MAX;
+  uint32_t counts = watts * POWER_K / (uint32_t)rpm;
+  return counts >= TORQUE_MAX ? TORQUE_MAX : (int16_t)counts;
+}
+
+void torqueLimitsTick() {
+  int32_t n = bamocar.rpmFeedback < 0 ? -(int32_t)bamocar.rpmFeedback : bamocar.rpmFeedback;
+  int32_t rpm = n * RPM_MAX / 32767;
+  TorqueLimits l;
+  l.speed     = derate(rpm, TORQUE_RPM_DERATE_START, RPM_MAX);
+  l.motorTemp = derate((int32_t)bamocar.motorTemp, TORQUE_MOTOR_TEMP_START_C, TORQUE_MOTOR_TEMP_END_C);
+  l.igbtTemp  = derate((int32_t)bamocar.inverterTemp, TORQUE_IGBT_TEMP_START_C, TORQUE_IGBT_TEMP_END_C);
+  l.power     = powerLimit(rpm, (int32_t)bamocar.dcBusVoltage);
+  l.limit     = l.speed;
+  if (l.motorTemp < l.limit) l.limit = l.motorTemp;
+  if (l.igbtTemp < l.limit)  l.limit = l.igbtTemp;
+  if (l.power < l.limit)     l.limit = l.power;
+  _limits = l;
+  _limit = l.limit;
+}
+
+TorqueLimits torqueLimits() {
+  return _limits;
+}
@@ -0,0 +1,136 @@
+#include "trace.h"
+#include "logging.h"
+#include "irq_guard.h"
+
+// Buckets 0-7 are exact cycle counts; above that, 8 sub-buckets per power
+// of two up to 2^32 cycles.
+#define TRACE_SUB_BITS 3
+#define TRACE_SUB      (1u << TRACE_SUB_BITS)
+#define TRACE_BUCKETS  ((32 - TRACE_SUB_BITS + 1) * TRACE_SUB)
+
+struct PathStats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint16_t hist[TRACE_BUCKETS];
+};
+
+static PathStats    _paths[TRACE_PATH_COUNT];
+static TraceSummary _last[TRACE_PATH_COUNT];
+
+#if TRACE_ENABLED
+static uint32_t _writeCycles[2];                        // [0] loop, [1] ISR
+static uint32_t _requestCycles[BAMOCAR_REGISTER_COUNT];
+static bool     _pending[BAMOCAR_REGISTER_COUNT];
+
+static uint16_t bucketOf(uint32_t v) {
+  if (v < TRACE_SUB) return (uint16_t)v;
+  uint8_t msb = 31 - __builtin_clz(v);
+  uint32_t sub = (v >> (msb - TRACE_SUB_BITS)) & (TRACE_SUB - 1);
+  return (uint16_t)((msb - TRACE_SUB_BITS + 1) * TRACE_SUB + sub);
+}
+
+void traceBegin() {
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+void traceRecord(uint8_t path, uint32_t startCycles, uint32_t endCycles) {
+  uint32_t d = endCycles - startCycles;
+  PathStats &p = _paths[path];
+  if (p.count == 0 || d < p.min) p.min = d;
+  if (d > p.max) p.max = d;
+  p.sum += d;
+  p.count++;
+  uint16_t &h = p.hist[bucketOf(d)];
+  if (h < 0xFFFF) h++;
+}
+
+void traceWrite() {
+  _writeCycles[inInterrupt() ? 1 : 0] = traceNow();
+}
+
+uint32_t traceLastWrite() {
+  return _writeCycles[inInterrupt() ? 1 : 0];
+}
+
+// Only the first request of a burst is timed until its answer arrives.
+void traceRequest(uint8_t reg) {
+  const BamocarRegister *r = bamocarRegister(reg);
+  if (!r) return;
+  size_t i = r - BAMOCAR_REGISTERS;
+  if (_pending[i]) return;
+  _requestCycles[i] = traceNow();
+  _pending[i] = true;
+}
+
+void traceResponse(uint8_t reg, uint32_t rxCycles) {
+  const BamocarRegister *r = bamocarRegister(reg);
+  if (!r) return;
+  size_t i = r - BAMOCAR_REGISTERS;
+  if (!_pending[i]) return;
+  _pending[i] = false;
+  traceRecord(TRACE_RTT + i, _requestCycles[i], rxCycles);
+}
+#endif
+
+// Upper edge of bucket b in cycles.
+static uint32_t bucketTop(uint16_t b) {
+  if (b < TRACE_SUB) return b;
+  uint8_t msb = b / TRACE_SUB + TRACE_SUB_BITS - 1;
+  uint32_t step = 1u << (msb - TRACE_SUB_BITS);
+  uint64_t lo = (uint64_t)(TRACE_SUB + b % TRACE_SUB) << (msb - TRACE_SUB_BITS);
+  uint64_t top = lo + step - 1;
+  return top > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)top;
+}
+
+static uint32_t toTenthUs(uint64_t cycles) {
+  return (uint32_t)(cycles * 10 / (F_CPU_ACTUAL / 1000000));
+}
+
+const char *tracePathName(uint8_t path) {
+  static char name[16];
+  if (path == TRACE_PEDAL_TORQUE) return "pedal_torque";
+  if (path == TRACE_PEDAL_TX)     return "pedal_tx";
+  if (path < TRACE_PATH_COUNT) {
+    snprintf(name, sizeof(name), "rtt_%s", BAMOCAR_REGISTERS[path - TRACE_RTT].name);
+    return name;
+  }
+  return "?";
+}
+
+const TraceSummary &traceLast(uint8_t path) {
+  return _last[path];
+}
+
+void traceLogStats() {
+  static PathStats p;  // too large for the stack of a cooperative task
+  for (uint8_t i = 0; i < TRACE_PATH_COUNT; i++) {
+    {
+      IrqGuard lock;
+      p = _paths[i];
+      memset(&_paths[i], 0, sizeof(_paths[i]));
+    }
+    TraceSummary &s = _last[i];
+    s.count = p.count;
+    if (p.count == 0) {
+      s.min = s.avg = s.p99 = s.max = 0;
+      continue;
+    }
+    uint32_t need = p.count - p.count / 100;  // samples at or below p99
+    uint32_t seen = 0;
+    uint16_t b = 0;
+    for (; b < TRACE_BUCKETS - 1; b++) {
+      seen += p.hist[b];
+      if (seen >= need) break;
+    }
+    uint32_t p99 = bucketTop(b);
+    if (p99 > p.max) p99 = p.max;
+    s.min = toTenthUs(p.min);
+    s.avg = toTenthUs(p.sum / p.count);
+    s.p99 = toTenthUs(p99);
+    s.max = toTenthUs(p.max);
+    logTrace(i, s);
+  }
+}
@@ -0,0 +1,58 @@
+#include "vehicle_state.h"
+#include "logging.h"
+#include <math.h>
+
+static const float ACCEL_MS2_PER_LSB = 9.80665f / LOG_IMU_ACCEL_LSB_PER_G;
+static const float GYRO_DPS_PER_LSB = 10.0f / LOG_IMU_GYRO_LSB_PER_DPS_X10;
+static const float WHEEL_MS_PER_NORM =
+  (float)RPM_MAX / 32767.0f * 2.0f * 3.14159265f * VEHICLE_WHEEL_RADIUS_M / (60.0f * VEHICLE_GEAR_RATIO);
+static const uint32_t MAX_DT_US = 4 * IMU_PERIOD_US;  // longer gaps restart the integration step
+
+static VehicleState _state = {};
+static float    _bias = 0.0f;
+static bool     _primed = false;
+static uint32_t _lastUs = 0;
+static uint32_t _lastMs = 0;  // millis() of the newest sample, for the timeout
+
+float vehicleWheelSpeed(int16_t rpmFeedback) {
+  return (float)rpmFeedback * WHEEL_MS_PER_NORM;
+}
+
+static float slipRatio(float wheel, float vehicle) {
+  return (wheel - vehicle) / (vehicle > VSE_MIN_SPEED_MS ? vehicle : VSE_MIN_SPEED_MS);
+}
+
+void vehicleStateImu(uint32_t tUs, const int16_t raw[6]) {
+  uint32_t dtUs = tUs - _lastUs;
+  _lastUs = tUs;
+  _lastMs = millis();
+  if (!_primed || dtUs == 0 || dtUs > MAX_DT_US) dtUs = IMU_PERIOD_US;
+  _primed = true;
+  const float dt = dtUs * 1e-6f;
+
+  VehicleState &s = _state;
+  float a = IMU_FORWARD_SIGN * raw[IMU_FORWARD_AXIS] * ACCEL_MS2_PER_LSB;
+  s.yawRateDps = raw[3 + IMU_YAW_AXIS] * GYRO_DPS_PER_LSB;
+  s.wheelMs = vehicleWheelSpeed(bamocar.rpmFeedback);
+
+  if (bamocar.rpmFeedback == 0 && s.speedMs < VSE_MIN_SPEED_MS) {
+    _bias += (a - _bias) * (dt / VSE_BIAS_TAU_S);
+    s.speedMs = 0.0f;
+  } else {
+    s.slip = slipRatio(s.wheelMs, s.speedMs);
+    float tau = fabsf(s.slip) > VSE_SLIP_LIMIT ? VSE_SLIP_TAU_S : VSE_TAU_S;
+    s.speedMs += dt * ((a - _bias) + (s.wheelMs - s.speedMs) / tau);
+    if (s.speedMs < 0.0f) s.speedMs = 0.0f;
+  }
+  s.accelMs2 += ((a - _bias) - s.accelMs2) * (dt / VSE_ACCEL_TAU_S);
+  s.slip = slipRatio(s.wheelMs, s.speedMs);
+  s.imu = true;
+}
+
+VehicleState vehicleState() {
+  if (_primed && millis() - _lastMs <= VSE_IMU_TIMEOUT_MS) return _state;
+  VehicleState s = {};
+  s.wheelMs = s.speedMs = vehicleWheelSpeed(bamocar.rpmFeedback);
+  s.imu = false;
+  return s;
+}
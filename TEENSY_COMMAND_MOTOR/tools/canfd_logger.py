@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Record the Teensy's CAN FD telemetry (CAN_FD_TELEMETRY) to a binary log.
+
+Each 64-byte frame on CANFD_TELEMETRY_ID carries up to three LogRecords
+(include/canfd_telemetry.h). They are written back to back, starting at
+the first header record, so the output is a binary log that
+tools/log_to_csv.py converts like an SD card file. The firmware repeats
+the header every second; only the first one is kept.
+
+Needs Linux SocketCAN and a CAN FD adapter on the Can3 bus, e.g.:
+  sudo ip link set can0 up type can bitrate 500000 dbitrate 2000000 fd on
+  python3 tools/canfd_logger.py can0 run.bin
+  python3 tools/log_to_csv.py run.bin
+"""
+
+from __future__ import annotations
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+CANFD_TELEMETRY_ID = 0x700
+RECORD_SIZE = 20
+FRAME = struct.Struct("<BBH")  # seq, count, reserved; records follow
+CANFD_FRAME = struct.Struct("<IBBBB64s")  # struct canfd_frame
+REC_HEADER = ord("H")
+STATUS_INTERVAL_S = 1.0
+
+
+def open_bus(iface: str) -> socket.socket:
+    sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+    sock.setsockopt(socket.SOL_CAN_RAW, socket.CAN_RAW_FD_FRAMES, 1)
+    sock.setsockopt(socket.SOL_CAN_RAW, socket.CAN_RAW_FILTER,
+                    struct.pack("=II", CANFD_TELEMETRY_ID, socket.CAN_SFF_MASK))
+    sock.bind((iface,))
+    return sock
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Record CAN FD telemetry to a binary log.")
+    parser.add_argument("iface", help="SocketCAN interface with FD enabled, e.g. can0")
+    parser.add_argument("output", help="Binary log to write, e.g. run.bin")
+    args = parser.parse_args()
+
+    sock = open_bus(args.iface)
+    frames = records = lost = 0
+    last_seq = None
+    started = False
+    next_status = time.monotonic() + STATUS_INTERVAL_S
+    with open(args.output, "wb") as out:
+        try:
+            while True:
+                raw = sock.recv(CANFD_FRAME.size)
+                if len(raw) < CANFD_FRAME.size:
+                    continue  # classic frame on the bus, not telemetry
+                _, length, _, _, _, data = CANFD_FRAME.unpack(raw)
+                if length < FRAME.size:
+                    continue
+                seq, count, _ = FRAME.unpack_from(data)
+                frames += 1
+                if last_seq is not None:
+                    lost += (seq - last_seq - 1) & 0xFF
+                last_seq = seq
+                for i in range(min(count, (length - FRAME.size) // RECORD_SIZE)):
+                    rec = data[FRAME.size + i * RECORD_SIZE:FRAME.size + (i + 1) * RECORD_SIZE]
+                    if rec[4] == REC_HEADER:
+                        if started:
+                            continue
+                        started = True
+                    if started:
+                        out.write(rec)
+                        records += 1
+                if time.monotonic() >= next_status:
+                    next_status += STATUS_INTERVAL_S
+                    state = "recording" if started else "waiting for header"
+                    print(f"\r{state}: {frames} frames, {records} records, {lost} frames lost",
+                          end="", file=sys.stderr)
+        except KeyboardInterrupt:
+            pass
+    print(f"\n{args.output}: {records} records, {lost} frames lost", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
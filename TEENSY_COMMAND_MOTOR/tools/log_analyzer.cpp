@@ -0,0 +1,248 @@
+// Batch analyser for CAN capture logs (host tool, not part of the firmware).
+//
+// Reads every .csv under the given directories (or the files given) in one
+// pass and decodes BAMOCAR 0x181 responses with the firmware's own table
+// (include/bamocar_decoder.h). Both the CANBUS_LOGS capture format and the
+// Teensy SD log format are read, see log_parse.h.
+//
+// One worker per core takes whole files, results are written in path order:
+//
+//   <out>/series.csv   file,ms,register,value     every decoded response
+//   <out>/gaps.csv     file,register,from_ms,to_ms,gap_ms
+//                      responses further apart than --gap-ms
+//   <out>/errors.csv   file,ms,error_word,errors  every error-word change
+//
+// plus a per-register summary on stdout.
+//
+// Build (from TEENSY_COMMAND_MOTOR):
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/log_analyzer.cpp -o log_analyzer
+// Usage:
+//   ./log_analyzer ../CANBUS_LOGS/17-10-2025 -o analysis
+//   ./log_analyzer -j 4 --gap-ms 500 CAN_log_0001.csv
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bamocar_decoder.h"
+#include "log_parse.h"
+
+namespace fs = std::filesystem;
+
+#define BAMOCAR_TX_ID    0x181
+#define DEFAULT_GAP_MS   250  // > 2 periods of the 100 ms cyclic telemetry
+
+// ---------- Results ----------
+struct Sample {
+  uint32_t ms;
+  uint8_t  row;    // BAMOCAR_REGISTERS index
+  float    value;
+};
+
+struct Gap {
+  uint8_t  row;
+  uint32_t fromMs;
+  uint32_t toMs;
+};
+
+struct ErrorEvent {
+  uint32_t ms;
+  uint32_t word;
+};
+
+struct FileResult {
+  fs::path path;
+  bool     ok = false;
+  uint64_t lines = 0;
+  uint64_t frames = 0;   // CAN frames of any id
+  uint64_t skipped = 0;  // lines that were neither a frame nor a known record
+  uint64_t rowCount[BAMOCAR_REGISTER_COUNT] = {};
+  std::vector<Sample>     samples;
+  std::vector<Gap>        gaps;
+  std::vector<ErrorEvent> errors;
+};
+
+static void analyseFile(FileResult &res, uint32_t gapMs) {
+  LogReader reader;
+  if (!reader.open(res.path.c_str())) return;
+  res.ok = true;
+
+  // ~30 bytes per line in either format; responses are about a quarter.
+  res.samples.reserve(reader.size() / 120);
+
+  BamocarState state = {};
+  bool     seen[BAMOCAR_REGISTER_COUNT] = {};
+  uint32_t lastMs[BAMOCAR_REGISTER_COUNT] = {};
+  uint32_t lastError = 0;
+
+  LogLine line;
+  while (reader.next(line)) {
+    if (line.kind == LOG_BAD) res.skipped++;
+    if (line.kind != LOG_FRAME) continue;
+    const LogFrame &fr = line.frame;
+    res.frames++;
+    if (!fr.rx || fr.bus != 1 || fr.id != BAMOCAR_TX_ID) continue;  // inverter bus
+
+    const BamocarRegister *r = bamocarDecode(fr.buf, fr.len, state);
+    if (!r) continue;
+    uint8_t row = (uint8_t)(r - BAMOCAR_REGISTERS);
+    res.rowCount[row]++;
+    res.samples.push_back({ fr.ms, row, bamocarValue(*r, state) });
+
+    if (seen[row] && fr.ms - lastMs[row] > gapMs) res.gaps.push_back({ row, lastMs[row], fr.ms });
+    seen[row] = true;
+    lastMs[row] = fr.ms;
+
+    if (r->reg == REG_ERROR_WORD && state.errorWord != lastError) {
+      res.errors.push_back({ fr.ms, state.errorWord });
+      lastError = state.errorWord;
+    }
+  }
+  res.lines = reader.lines();
+}
+
+// ---------- Output ----------
+static void errorNames(uint32_t word, char *buf, size_t len) {
+  size_t n = 0;
+  buf[0] = '\0';
+  for (int bit = 0; bit < 16; bit++) {
+    if (!(word & (1u << bit))) continue;
+    const char *name = BAMOCAR_ERROR_NAMES[bit][0] ? BAMOCAR_ERROR_NAMES[bit] : "UNKNOWN";
+    int w = snprintf(buf + n, len - n, "%s%s", n ? "|" : "", name);
+    if (w < 0 || (size_t)w >= len - n) break;
+    n += (size_t)w;
+  }
+}
+
+static FILE *openOut(const fs::path &dir, const char *name, const char *header) {
+  fs::path path = dir / name;
+  FILE *f = fopen(path.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "log_analyzer: cannot write %s\n", path.c_str());
+    exit(1);
+  }
+  static char buf[1 << 16];  // only one file is written at a time
+  setvbuf(f, buf, _IOFBF, sizeof(buf));
+  fputs(header, f);
+  return f;
+}
+
+static void writeResults(const std::vector<FileResult> &results, const fs::path &outDir) {
+  FILE *f = openOut(outDir, "series.csv", "file,ms,register,value\n");
+  for (const FileResult &r : results) {
+    std::string name = r.path.filename().string();
+    for (const Sample &s : r.samples)
+      fprintf(f, "%s,%u,%s,%g\n", name.c_str(), s.ms, BAMOCAR_REGISTERS[s.row].name, s.value);
+  }
+  fclose(f);
+
+  f = openOut(outDir, "gaps.csv", "file,register,from_ms,to_ms,gap_ms\n");
+  for (const FileResult &r : results) {
+    std::string name = r.path.filename().string();
+    for (const Gap &g : r.gaps)
+      fprintf(f, "%s,%s,%u,%u,%u\n", name.c_str(), BAMOCAR_REGISTERS[g.row].name, g.fromMs, g.toMs, g.toMs - g.fromMs);
+  }
+  fclose(f);
+
+  f = openOut(outDir, "errors.csv", "file,ms,error_word,errors\n");
+  for (const FileResult &r : results) {
+    std::string name = r.path.filename().string();
+    for (const ErrorEvent &e : r.errors) {
+      char names[160];
+      errorNames(e.word, names, sizeof(names));
+      fprintf(f, "%s,%u,0x%04X,%s\n", name.c_str(), e.ms, e.word, names);
+    }
+  }
+  fclose(f);
+}
+
+static void printSummary(const std::vector<FileResult> &results) {
+  uint64_t lines = 0, frames = 0, skipped = 0, gaps = 0, errors = 0;
+  uint64_t rows[BAMOCAR_REGISTER_COUNT] = {};
+  size_t failed = 0;
+  for (const FileResult &r : results) {
+    if (!r.ok) {
+      fprintf(stderr, "log_analyzer: cannot read %s\n", r.path.c_str());
+      failed++;
+    }
+    lines += r.lines;
+    frames += r.frames;
+    skipped += r.skipped;
+    gaps += r.gaps.size();
+    errors += r.errors.size();
+    for (size_t i = 0; i < BAMOCAR_REGISTER_COUNT; i++) rows[i] += r.rowCount[i];
+  }
+  printf("%zu files (%zu unreadable), %llu lines, %llu frames, %llu skipped\n",
+         results.size(), failed, (unsigned long long)lines, (unsigned long long)frames,
+         (unsigned long long)skipped);
+  printf("%-12s %10s\n", "register", "responses");
+  for (size_t i = 0; i < BAMOCAR_REGISTER_COUNT; i++)
+    printf("%-12s %10llu\n", BAMOCAR_REGISTERS[i].name, (unsigned long long)rows[i]);
+  printf("%llu gaps, %llu error-word changes\n", (unsigned long long)gaps, (unsigned long long)errors);
+}
+
+// ---------- Main ----------
+static void usage() {
+  fprintf(stderr,
+          "usage: log_analyzer [-o outdir] [-j threads] [--gap-ms N] <dir|file.csv>...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  fs::path outDir = ".";
+  unsigned threads = std::thread::hardware_concurrency();
+  uint32_t gapMs = DEFAULT_GAP_MS;
+  std::vector<fs::path> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "-o" && i + 1 < argc)            outDir = argv[++i];
+    else if (a == "-j" && i + 1 < argc)       threads = (unsigned)atoi(argv[++i]);
+    else if (a == "--gap-ms" && i + 1 < argc) gapMs = (uint32_t)atoi(argv[++i]);
+    else if (a[0] == '-')                     usage();
+    else                                      inputs.push_back(a);
+  }
+  if (inputs.empty()) usage();
+  if (threads == 0) threads = 1;
+
+  std::vector<FileResult> results;
+  for (const fs::path &in : inputs) {
+    std::error_code ec;
+    if (fs::is_directory(in, ec)) {
+      for (const auto &e : fs::recursive_directory_iterator(in, ec)) {
+        if (e.is_regular_file() && e.path().extension() == ".csv") {
+          results.emplace_back();
+          results.back().path = e.path();
+        }
+      }
+    } else {
+      results.emplace_back();
+      results.back().path = in;
+    }
+  }
+  std::sort(results.begin(), results.end(),
+            [](const FileResult &a, const FileResult &b) { return a.path < b.path; });
+
+  // Workers pull whole files; results land in their own slot, so no locking.
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  unsigned n = std::min<size_t>(threads, results.size());
+  for (unsigned t = 0; t < n; t++) {
+    pool.emplace_back([&]() {
+      for (size_t i; (i = next.fetch_add(1)) < results.size();) analyseFile(results[i], gapMs);
+    });
+  }
+  for (std::thread &t : pool) t.join();
+
+  std::error_code ec;
+  fs::create_directories(outDir, ec);
+  writeResults(results, outDir);
+  printSummary(results);
+  return 0;
+}
@@ -0,0 +1,659 @@
+// Columnar archive for CAN logs (host tool, not part of the firmware).
+//
+// build: decodes every .csv under the inputs (log_parse.h formats) into one
+// archive with a column per signal:
+//
+//   ms, one column per BAMOCAR_REGISTERS row (status, rpm, current, temps,
+//   dcbus, error_word, ...), torque_cmd, apps1, apps2, pedal_fault
+//
+// A row is added whenever a decoded value changes; every column holds its
+// last value (0 before the first one). Float registers are stored x10.
+// Rows are cut into chunks of ARCHIVE_CHUNK_ROWS per session; each chunk
+// column is delta + run-length varint encoded and has a min/max zone map.
+// The ms column's zone map is the time index.
+//
+// query: evaluates a conjunction of column predicates, skipping every chunk
+// whose zone maps rule a term out and decoding only the columns it needs.
+// Default output is the matching intervals per session.
+//
+// Build (from TEENSY_COMMAND_MOTOR):
+//   g++ -O2 -std=c++17 -pthread -Iinclude -Itools tools/log_archive.cpp -o log_archive
+// Usage:
+//   ./log_archive build can.arc ../CANBUS_LOGS
+//   ./log_archive query can.arc "rpm>0 && torque_cmd==0"
+//   ./log_archive query can.arc "ms>=20000, ms<30000" --rows rpm,dcbus --session 0060
+//
+// File layout (little-endian, host order):
+//   "CANARC" u16 version | chunk column blobs ... | footer | u64 footer offset, "CANARC" u16 version
+//   footer: u32 columns { u8 len, name, i32 scale }
+//           u32 sessions { u16 len, name, u32 first chunk, u32 chunks, u64 rows }
+//           u32 chunks { u32 rows, columns x { i32 min, i32 max, u64 offset, u32 bytes } }
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bamocar_decoder.h"
+#include "bamocar_registers.h"
+#include "log_parse.h"
+
+namespace fs = std::filesystem;
+
+#define BAMOCAR_TX_ID        0x181
+#define BAMOCAR_RX_ID        0x201
+#define ARCHIVE_MAGIC        "CANARC"
+#define ARCHIVE_VERSION      1
+#define ARCHIVE_CHUNK_ROWS   4096
+#define ARCHIVE_FLOAT_SCALE  10
+
+// ---------- Columns ----------
+// ms, then BAMOCAR_REGISTERS in table order, then the Teensy-side signals.
+enum : uint8_t {
+  COL_MS = 0,
+  COL_REG0 = 1,
+  COL_TORQUE_CMD = COL_REG0 + BAMOCAR_REGISTER_COUNT,
+  COL_APPS1,
+  COL_APPS2,
+  COL_PEDAL_FAULT,
+  COL_COUNT,
+};
+
+struct Column {
+  std::string name;
+  int32_t     scale;  // stored = value * scale
+};
+
+static std::vector<Column> buildColumns() {
+  std::vector<Column> cols;
+  cols.push_back({ "ms", 1 });
+  for (const BamocarRegister &r : BAMOCAR_REGISTERS)
+    cols.push_back({ r.name, r.type == BF_F32 ? ARCHIVE_FLOAT_SCALE : 1 });
+  cols.push_back({ "torque_cmd", 1 });
+  cols.push_back({ "apps1", 1 });
+  cols.push_back({ "apps2", 1 });
+  cols.push_back({ "pedal_fault", 1 });
+  return cols;
+}
+
+static int32_t storedValue(const BamocarRegister &r, const BamocarState &state) {
+  float v = bamocarValue(r, state);
+  if (r.type == BF_F32) return (int32_t)lroundf(v * ARCHIVE_FLOAT_SCALE);
+  if (r.type == BF_U32) return (int32_t)*(const uint32_t *)((const uint8_t *)&state + r.offset);
+  return (int32_t)v;
+}
+
+// ---------- Varint coding ----------
+static void putVarint(std::vector<uint8_t> &out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+// False if the varint runs past end or beyond 32 bits.
+static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 35 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// Pairs of (zigzag delta, repeat count): value += delta, then emit it count
+// times. Held values cost two bytes per run instead of per row.
+static void encodeColumn(const int32_t *v, uint32_t n, std::vector<uint8_t> &out) {
+  int32_t prev = 0;
+  for (uint32_t i = 0; i < n;) {
+    uint32_t run = 1;
+    while (i + run < n && v[i + run] == v[i]) run++;
+    putVarint(out, zigzag((int32_t)((uint32_t)v[i] - (uint32_t)prev)));
+    putVarint(out, run);
+    prev = v[i];
+    i += run;
+  }
+}
+
+// False if the blob (bytes long) ends, or holds an empty run, before n values.
+static bool decodeColumn(const uint8_t *p, uint32_t bytes, uint32_t n, int32_t *out) {
+  const uint8_t *end = p + bytes;
+  int32_t value = 0;
+  for (uint32_t i = 0; i < n;) {
+    uint32_t delta, run;
+    if (!getVarint(p, end, delta) || !getVarint(p, end, run) || run == 0) return false;
+    value = (int32_t)((uint32_t)value + (uint32_t)unzigzag(delta));
+    for (uint32_t k = 0; k < run && i < n; k++) out[i++] = value;
+  }
+  return true;
+}
+
+// ---------- Build ----------
+struct ChunkColumn {
+  int32_t  min;
+  int32_t  max;
+  uint64_t offset;  // filled in when written
+  uint32_t bytes;
+};
+
+struct Chunk {
+  uint32_t rows;
+  ChunkColumn cols[COL_COUNT];
+  std::vector<uint8_t> data;  // column blobs back to back (build only)
+};
+
+struct Session {
+  fs::path path;
+  std::string name;
+  bool ok = false;
+  uint32_t firstChunk = 0;
+  uint32_t chunkCount = 0;
+  uint64_t rows = 0;
+  std::vector<Chunk> chunks;  // build only; a reader uses Archive::chunks
+};
+
+static void encodeChunk(const std::vector<int32_t> (&cols)[COL_COUNT], uint32_t start, uint32_t n, Chunk &c) {
+  c.rows = n;
+  for (int k = 0; k < COL_COUNT; k++) {
+    const int32_t *v = cols[k].data() + start;
+    auto mm = std::minmax_element(v, v + n);
+    size_t before = c.data.size();
+    encodeColumn(v, n, c.data);
+    c.cols[k] = { *mm.first, *mm.second, before, (uint32_t)(c.data.size() - before) };
+  }
+}
+
+static void buildSession(Session &s) {
+  LogReader reader;
+  if (!reader.open(s.path.c_str())) return;
+  s.ok = true;
+
+  std::vector<int32_t> cols[COL_COUNT];
+  int32_t row[COL_COUNT] = {};
+  BamocarState state = {};
+
+  LogLine line;
+  while (reader.next(line)) {
+    bool changed = false;
+    auto set = [&](int k, int32_t v) {
+      if (row[k] != v) { row[k] = v; changed = true; }
+    };
+
+    if (line.kind == LOG_FRAME) {
+      const LogFrame &fr = line.frame;
+      row[COL_MS] = (int32_t)fr.ms;
+      if (fr.bus != 1) {
+        // BAMOCAR is only on the inverter bus (Can1)
+      } else if (fr.rx && fr.id == BAMOCAR_TX_ID) {
+        const BamocarRegister *r = bamocarDecode(fr.buf, fr.len, state);
+        if (r) set(COL_REG0 + (int)(r - BAMOCAR_REGISTERS), storedValue(*r, state));
+      } else if (!fr.rx && fr.id == BAMOCAR_RX_ID && fr.len >= 3 && fr.buf[0] == REG_TORQUE_COMMAND) {
+        set(COL_TORQUE_CMD, (int16_t)(fr.buf[1] | fr.buf[2] << 8));
+      }
+    } else if (line.kind == LOG_SENSOR) {
+      const LogSensor &sn = line.sensor;
+      row[COL_MS] = (int32_t)sn.ms;
+      set(COL_APPS1, sn.apps1Raw);
+      set(COL_APPS2, sn.apps2Raw);
+      set(COL_PEDAL_FAULT, sn.pedalFault);
+      set(COL_TORQUE_CMD, sn.torqueCmd);
+    }
+    if (!changed) continue;
+    for (int k = 0; k < COL_COUNT; k++) cols[k].push_back(row[k]);
+  }
+
+  uint32_t n = (uint32_t)cols[COL_MS].size();
+  s.rows = n;
+  s.chunkCount = (n + ARCHIVE_CHUNK_ROWS - 1) / ARCHIVE_CHUNK_ROWS;
+  for (uint32_t start = 0; start < n; start += ARCHIVE_CHUNK_ROWS) {
+    s.chunks.emplace_back();
+    encodeChunk(cols, start, std::min<uint32_t>(ARCHIVE_CHUNK_ROWS, n - start), s.chunks.back());
+  }
+}
+
+static void putBytes(FILE *f, const void *p, size_t n) { fwrite(p, 1, n, f); }
+template <typename T> static void put(FILE *f, T v) { putBytes(f, &v, sizeof(v)); }
+
+static void writeMagic(FILE *f) {
+  putBytes(f, ARCHIVE_MAGIC, 6);
+  put<uint16_t>(f, ARCHIVE_VERSION);
+}
+
+static int cmdBuild(const char *outPath, const std::vector<fs::path> &inputs) {
+  std::vector<Session> sessions;
+  for (const fs::path &in : inputs) {
+    std::error_code ec;
+    if (fs::is_directory(in, ec)) {
+      for (const auto &e : fs::recursive_directory_iterator(in, ec)) {
+        if (!e.is_regular_file() || e.path().extension() != ".csv") continue;
+        sessions.emplace_back();
+        sessions.back().path = e.path();
+        sessions.back().name = fs::relative(e.path(), in).string();
+      }
+    } else {
+      sessions.emplace_back();
+      sessions.back().path = in;
+      sessions.back().name = in.filename().string();
+    }
+  }
+  std::sort(sessions.begin(), sessions.end(),
+            [](const Session &a, const Session &b) { return a.name < b.name; });
+
+  // One worker per core, whole files each, as in log_analyzer.
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  unsigned n = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), sessions.size());
+  for (unsigned t = 0; t < n; t++) {
+    pool.emplace_back([&]() {
+      for (size_t i; (i = next.fetch_add(1)) < sessions.size();) buildSession(sessions[i]);
+    });
+  }
+  for (std::thread &t : pool) t.join();
+
+  FILE *f = fopen(outPath, "wb");
+  if (!f) {
+    fprintf(stderr, "log_archive: cannot write %s\n", outPath);
+    return 1;
+  }
+  writeMagic(f);
+  uint64_t offset = 8;
+  uint32_t chunkIndex = 0;
+  uint64_t rows = 0;
+  for (Session &s : sessions) {
+    if (!s.ok) fprintf(stderr, "log_archive: cannot read %s\n", s.path.c_str());
+    s.firstChunk = chunkIndex;
+    rows += s.rows;
+    for (Chunk &c : s.chunks) {
+      for (ChunkColumn &cc : c.cols) cc.offset += offset;
+      putBytes(f, c.data.data(), c.data.size());
+      offset += c.data.size();
+      c.data = std::vector<uint8_t>();
+      chunkIndex++;
+    }
+  }
+
+  uint64_t footer = offset;
+  std::vector<Column> columns = buildColumns();
+  put<uint32_t>(f, (uint32_t)columns.size());
+  for (const Column &c : columns) {
+    put<uint8_t>(f, (uint8_t)c.name.size());
+    putBytes(f, c.name.data(), c.name.size());
+    put<int32_t>(f, c.scale);
+  }
+  put<uint32_t>(f, (uint32_t)sessions.size());
+  for (const Session &s : sessions) {
+    put<uint16_t>(f, (uint16_t)s.name.size());
+    putBytes(f, s.name.data(), s.name.size());
+    put<uint32_t>(f, s.firstChunk);
+    put<uint32_t>(f, s.chunkCount);
+    put<uint64_t>(f, s.rows);
+  }
+  put<uint32_t>(f, chunkIndex);
+  for (const Session &s : sessions) {
+    for (const Chunk &c : s.chunks) {
+      put<uint32_t>(f, c.rows);
+      for (const ChunkColumn &cc : c.cols) {
+        put<int32_t>(f, cc.min);
+        put<int32_t>(f, cc.max);
+        put<uint64_t>(f, cc.offset);
+        put<uint32_t>(f, cc.bytes);
+      }
+    }
+  }
+  put<uint64_t>(f, footer);
+  writeMagic(f);
+  long size = ftell(f);
+  fclose(f);
+
+  printf("%zu sessions, %llu rows, %u chunks, %ld bytes\n", sessions.size(),
+         (unsigned long long)rows, chunkIndex, size);
+  return 0;
+}
+
+// ---------- Archive reader ----------
+struct Archive {
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  std::vector<Column> columns;
+  std::vector<Session> sessions;
+  std::vector<Chunk> chunks;
+
+  bool open(const char *path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 26) { ::close(fd); return false; }
+    size = (size_t)st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    data = (const uint8_t *)p;
+    return parseFooter();
+  }
+
+  ~Archive() {
+    if (data) munmap((void *)data, size);
+  }
+
+private:
+  template <typename T> T get(const uint8_t *&p) {
+    T v;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+  }
+
+  bool magicAt(size_t at) {
+    uint16_t version;
+    memcpy(&version, data + at + 6, 2);
+    return memcmp(data + at, ARCHIVE_MAGIC, 6) == 0 && version == ARCHIVE_VERSION;
+  }
+
+  // Everything is checked against the file before it is used: a truncated
+  // or corrupt archive fails open() instead of reading past the mapping.
+  bool parseFooter() {
+    if (!magicAt(0) || !magicAt(size - 8)) return false;
+    uint64_t footer;
+    memcpy(&footer, data + size - 16, 8);
+    if (footer < 8 || footer >= size - 16) return false;
+    const uint8_t *p = data + footer;
+    const uint8_t *end = data + size - 16;
+    auto fits = [&](size_t n) { return (size_t)(end - p) >= n; };
+
+    if (!fits(4)) return false;
+    uint32_t n = get<uint32_t>(p);
+    if (n != COL_COUNT) return false;  // built against a different register table
+    for (uint32_t i = 0; i < n; i++) {
+      if (!fits(1)) return false;
+      uint8_t len = get<uint8_t>(p);
+      if (!fits(len + 4u)) return false;
+      Column c = { std::string((const char *)p, len), 0 };
+      p += len;
+      c.scale = get<int32_t>(p);
+      if (c.scale <= 0) return false;
+      columns.push_back(c);
+    }
+
+    const size_t SESSION_MIN = 2 + 4 + 4 + 8;
+    if (!fits(4)) return false;
+    n = get<uint32_t>(p);
+    if (n > (size_t)(end - p) / SESSION_MIN) return false;
+    sessions.resize(n);
+    for (Session &s : sessions) {
+      if (!fits(2)) return false;
+      uint16_t len = get<uint16_t>(p);
+      if (!fits(len + SESSION_MIN - 2)) return false;
+      s.name.assign((const char *)p, len);
+      p += len;
+      s.firstChunk = get<uint32_t>(p);
+      s.chunkCount = get<uint32_t>(p);
+      s.rows = get<uint64_t>(p);
+    }
+
+    const size_t CHUNK_BYTES = 4 + COL_COUNT * (4 + 4 + 8 + 4);
+    if (!fits(4)) return false;
+    n = get<uint32_t>(p);
+    if (n > (size_t)(end - p) / CHUNK_BYTES) return false;
+    chunks.resize(n);
+    for (Chunk &c : chunks) {
+      c.rows = get<uint32_t>(p);
+      if (c.rows > ARCHIVE_CHUNK_ROWS) return false;
+      for (ChunkColumn &cc : c.cols) {
+        cc.min = get<int32_t>(p);
+        cc.max = get<int32_t>(p);
+        cc.offset = get<uint64_t>(p);
+        cc.bytes = get<uint32_t>(p);
+        if (cc.offset < 8 || cc.offset > footer || cc.bytes > footer - cc.offset) return false;
+      }
+    }
+    if (p != end) return false;
+
+    for (const Session &s : sessions)
+      if ((uint64_t)s.firstChunk + s.chunkCount > chunks.size()) return false;
+    return true;
+  }
+};
+
+// ---------- Query ----------
+enum Op : uint8_t { OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE };
+
+struct Term {
+  int    col;
+  Op     op;
+  double value;  // in column units
+};
+
+static bool test(double v, Op op, double x) {
+  switch (op) {
+    case OP_LT: return v <  x;
+    case OP_LE: return v <= x;
+    case OP_GT: return v >  x;
+    case OP_GE: return v >= x;
+    case OP_EQ: return v == x;
+    case OP_NE: return v != x;
+  }
+  return false;
+}
+
+// Can any value in [lo, hi] satisfy the term?
+static bool mayMatch(double lo, double hi, Op op, double x) {
+  switch (op) {
+    case OP_LT: return lo <  x;
+    case OP_LE: return lo <= x;
+    case OP_GT: return hi >  x;
+    case OP_GE: return hi >= x;
+    case OP_EQ: return lo <= x && x <= hi;
+    case OP_NE: return !(lo == x && hi == x);
+  }
+  return true;
+}
+
+static int findColumn(const Archive &a, const std::string &name) {
+  for (size_t i = 0; i < a.columns.size(); i++)
+    if (a.columns[i].name == name) return (int)i;
+  fprintf(stderr, "log_archive: unknown column '%s'\n", name.c_str());
+  exit(2);
+}
+
+// "rpm>0 && torque_cmd==0", terms joined by "&&" or ",".
+static std::vector<Term> parseWhere(const Archive &a, const char *expr) {
+  static const struct { const char *s; Op op; } OPS[] = {
+    { "<=", OP_LE }, { ">=", OP_GE }, { "==", OP_EQ }, { "!=", OP_NE },
+    { "<", OP_LT },  { ">", OP_GT },  { "=", OP_EQ },
+  };
+  std::vector<Term> terms;
+  std::string e = expr;
+  size_t pos = 0;
+  while (pos < e.size()) {
+    size_t stop = std::min(e.find("&&", pos), e.find(',', pos));
+    std::string t = e.substr(pos, stop == std::string::npos ? std::string::npos : stop - pos);
+    pos = stop == std::string::npos ? e.size() : stop + (e[stop] == ',' ? 1 : 2);
+    t.erase(std::remove(t.begin(), t.end(), ' '), t.end());
+    if (t.empty()) continue;
+
+    size_t at = std::string::npos;
+    Op op = OP_EQ;
+    size_t opLen = 0;
+    for (const auto &o : OPS) {
+      size_t i = t.find(o.s);
+      if (i != std::string::npos && i < at) {
+        at = i;
+        op = o.op;
+        opLen = strlen(o.s);
+        if (opLen == 2) break;  // two-char operators win at the same position
+      }
+    }
+    if (at == std::string::npos || at == 0) {
+      fprintf(stderr, "log_archive: bad term '%s'\n", t.c_str());
+      exit(2);
+    }
+    terms.push_back({ findColumn(a, t.substr(0, at)), op, atof(t.c_str() + at + opLen) });
+  }
+  return terms;
+}
+
+static int cmdQuery(const char *path, int argc, char **argv) {
+  auto t0 = std::chrono::steady_clock::now();
+  Archive a;
+  if (!a.open(path)) {
+    fprintf(stderr, "log_archive: %s is not a readable archive\n", path);
+    return 1;
+  }
+
+  std::vector<Term> terms;
+  std::vector<int> outCols;
+  std::string sessionFilter;
+  bool countOnly = false;
+  for (int i = 0; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--rows" && i + 1 < argc) {
+      std::string list = argv[++i];
+      for (size_t p = 0; p <= list.size();) {
+        size_t c = list.find(',', p);
+        if (c == std::string::npos) c = list.size();
+        if (c > p) outCols.push_back(findColumn(a, list.substr(p, c - p)));
+        p = c + 1;
+      }
+    } else if (arg == "--session" && i + 1 < argc) {
+      sessionFilter = argv[++i];
+    } else if (arg == "--count") {
+      countOnly = true;
+    } else {
+      std::vector<Term> t = parseWhere(a, argv[i]);
+      terms.insert(terms.end(), t.begin(), t.end());
+    }
+  }
+
+  bool need[COL_COUNT] = {};
+  need[COL_MS] = true;
+  for (const Term &t : terms) need[t.col] = true;
+  for (int c : outCols) need[c] = true;
+
+  if (!countOnly) {
+    if (outCols.empty()) {
+      printf("session,from_ms,to_ms,duration_ms,rows\n");
+    } else {
+      printf("session,ms");
+      for (int c : outCols) printf(",%s", a.columns[c].name.c_str());
+      printf("\n");
+    }
+  }
+
+  static int32_t values[COL_COUNT][ARCHIVE_CHUNK_ROWS];
+  uint64_t scanned = 0, skipped = 0, matches = 0;
+
+  for (const Session &s : a.sessions) {
+    if (!sessionFilter.empty() && s.name.find(sessionFilter) == std::string::npos) continue;
+    bool open = false;
+    int32_t fromMs = 0, lastMs = 0;
+    uint64_t runRows = 0;
+    auto close = [&](int32_t toMs) {
+      if (!open) return;
+      if (!countOnly && outCols.empty())
+        printf("%s,%d,%d,%d,%llu\n", s.name.c_str(), fromMs, toMs, toMs - fromMs, (unsigned long long)runRows);
+      open = false;
+    };
+
+    for (uint32_t ci = s.firstChunk; ci < s.firstChunk + s.chunkCount; ci++) {
+      const Chunk &c = a.chunks[ci];
+      bool possible = true;
+      for (const Term &t : terms) {
+        double scale = a.columns[t.col].scale;
+        if (!mayMatch(c.cols[t.col].min / scale, c.cols[t.col].max / scale, t.op, t.value)) {
+          possible = false;
+          break;
+        }
+      }
+      if (!possible) {
+        skipped++;
+        close(c.cols[COL_MS].min);
+        continue;
+      }
+      scanned++;
+      for (int k = 0; k < COL_COUNT; k++) {
+        if (need[k] && !decodeColumn(a.data + c.cols[k].offset, c.cols[k].bytes, c.rows, values[k])) {
+          fprintf(stderr, "log_archive: %s: chunk %u is corrupt\n", path, ci);
+          return 1;
+        }
+      }
+
+      for (uint32_t r = 0; r < c.rows; r++) {
+        bool hit = true;
+        for (const Term &t : terms) {
+          if (!test(values[t.col][r] / (double)a.columns[t.col].scale, t.op, t.value)) {
+            hit = false;
+            break;
+          }
+        }
+        int32_t ms = values[COL_MS][r];
+        if (!hit) { close(ms); continue; }
+        matches++;
+        if (!open) { open = true; fromMs = ms; runRows = 0; }
+        runRows++;
+        lastMs = ms;
+        if (!countOnly && !outCols.empty()) {
+          printf("%s,%d", s.name.c_str(), ms);
+          for (int col : outCols) printf(",%g", values[col][r] / (double)a.columns[col].scale);
+          printf("\n");
+        }
+      }
+    }
+    close(lastMs);
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  if (countOnly) printf("%llu\n", (unsigned long long)matches);
+  fprintf(stderr, "%llu matching rows, %llu chunks decoded, %llu skipped by zone maps, %.2f ms\n",
+          (unsigned long long)matches, (unsigned long long)scanned, (unsigned long long)skipped, ms);
+  return 0;
+}
+
+static int cmdInfo(const char *path) {
+  Archive a;
+  if (!a.open(path)) {
+    fprintf(stderr, "log_archive: %s is not a readable archive\n", path);
+    return 1;
+  }
+  printf("%zu sessions, %zu chunks, %zu bytes\n", a.sessions.size(), a.chunks.size(), a.size);
+  printf("%-12s %6s %12s\n", "column", "scale", "bytes");
+  for (size_t k = 0; k < a.columns.size(); k++) {
+    uint64_t bytes = 0;
+    for (const Chunk &c : a.chunks) bytes += c.cols[k].bytes;
+    printf("%-12s %6d %12llu\n", a.columns[k].name.c_str(), a.columns[k].scale, (unsigned long long)bytes);
+  }
+  return 0;
+}
+
+// ---------- Main ----------
+static void usage() {
+  fprintf(stderr,
+          "usage: log_archive build <archive> <dir|file.csv>...\n"
+          "       log_archive query <archive> [\"col>x && col==y\"] [--rows c1,c2] [--session name] [--count]\n"
+          "       log_archive info <archive>\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) usage();
+  std::string cmd = argv[1];
+  if (cmd == "build") {
+    if (argc < 4) usage();
+    std::vector<fs::path> inputs(argv + 3, argv + argc);
+    return cmdBuild(argv[2], inputs);
+  }
+  if (cmd == "query") return cmdQuery(argv[2], argc - 3, argv + 3);
+  if (cmd == "info")  return cmdInfo(argv[2]);
+  usage();
+}
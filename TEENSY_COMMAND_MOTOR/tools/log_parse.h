@@ -0,0 +1,242 @@
+#pragma once
+// Zero-copy reader for CAN log CSVs, shared by the host tools.
+//
+//   capture:  Time(ms),Dir,ID,Len,B0,...,B7,Decoded   (CANBUS_LOGS/*)
+//   teensy:   C,<ms>,<dir>,<id_hex>,<len>,<b0_hex>,...,<b7_hex>   (dir RX/TX, RX2/TX3.. = bus)
+//             S,<ms>,<apps1_raw>,<apps2_raw>,<pedal_fault>,<torque_cmd>,<rpm>,<dcbus_dV>
+//             (XR/XL/K/KH/LT/B/CB/CI/FT/AP and # comment lines are reported as LOG_OTHER)
+//
+// Older capture files repeat the register id in B0 (len + 1 byte fields);
+// that is detected per line from the field count.
+//
+// The file is mmapped and scanned in place; nothing is allocated per line.
+// The first non-comment line picks the format for the whole file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------- Field scanning ----------
+// A LogSpan is [p, end) without the newline; fields are split on ',' in place.
+struct LogSpan {
+  const char *p;
+  const char *end;
+  bool empty() const { return p == end; }
+};
+
+inline bool logNextField(LogSpan &line, LogSpan &f) {
+  if (line.p > line.end) return false;
+  f.p = line.p;
+  while (line.p < line.end && *line.p != ',') line.p++;
+  f.end = line.p;
+  line.p++;  // past the comma (or one past end: no more fields)
+  return true;
+}
+
+inline bool logParseDec(const LogSpan &f, uint32_t &out) {
+  if (f.empty()) return false;
+  uint32_t v = 0;
+  for (const char *c = f.p; c < f.end; c++) {
+    if (*c < '0' || *c > '9') return false;
+    v = v * 10 + (uint32_t)(*c - '0');
+  }
+  out = v;
+  return true;
+}
+
+inline bool logParseInt(const LogSpan &f, int32_t &out) {
+  bool neg = !f.empty() && *f.p == '-';
+  uint32_t v;
+  if (!logParseDec(LogSpan{ f.p + (neg ? 1 : 0), f.end }, v)) return false;
+  out = neg ? -(int32_t)v : (int32_t)v;
+  return true;
+}
+
+inline int logHexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Accepts "1A" and "0x1A".
+inline bool logParseHex(const LogSpan &f, uint32_t &out) {
+  const char *c = f.p;
+  if (f.end - c > 2 && c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) c += 2;
+  if (c == f.end) return false;
+  uint32_t v = 0;
+  for (; c < f.end; c++) {
+    int d = logHexDigit(*c);
+    if (d < 0) return false;
+    v = (v << 4) | (uint32_t)d;
+  }
+  out = v;
+  return true;
+}
+
+// ---------- Records ----------
+struct LogFrame {
+  uint32_t ms;
+  bool     rx;
+  uint8_t  bus;  // FlexCAN controller from the dir suffix, 1 without one
+  uint32_t id;
+  uint8_t  len;
+  uint8_t  buf[8];
+};
+
+struct LogSensor {
+  uint32_t ms;
+  int32_t  apps1Raw;
+  int32_t  apps2Raw;
+  int32_t  pedalFault;
+  int32_t  torqueCmd;
+  int32_t  rpm;
+  int32_t  dcBusDeciVolts;
+};
+
+enum LogLineKind : uint8_t {
+  LOG_FRAME,   // frame is valid
+  LOG_SENSOR,  // sensor is valid
+  LOG_OTHER,   // known non-CAN record or comment, skipped
+  LOG_BAD,     // unparseable
+};
+
+struct LogLine {
+  LogLineKind kind;
+  LogFrame    frame;
+  LogSensor   sensor;
+};
+
+// Reads up to 9 byte fields; the capture format's duplicated B0 shows up
+// as one field more than len.
+inline bool logParseBytes(LogSpan &line, LogFrame &fr) {
+  uint8_t raw[9];
+  int n = 0;
+  LogSpan f;
+  while (n < 9 && logNextField(line, f)) {
+    if (f.empty() || *f.p == '"') break;
+    uint32_t b;
+    if (!logParseHex(f, b) || b > 0xFF) return false;
+    raw[n++] = (uint8_t)b;
+  }
+  if (fr.len > 8 || n < fr.len) return false;
+  int skip = (n == fr.len + 1) ? 1 : 0;
+  memcpy(fr.buf, raw + skip, fr.len);
+  return true;
+}
+
+// <ms>,<dir>,<id>,<len>,<bytes>... (capture line, or a C record after "C,")
+inline bool logParseFrame(LogSpan line, LogFrame &fr) {
+  LogSpan f;
+  uint32_t v;
+  if (!logNextField(line, f) || !logParseDec(f, fr.ms)) return false;
+  if (!logNextField(line, f) || f.empty()) return false;
+  fr.rx = *f.p == 'R';
+  fr.bus = (f.end - f.p == 3 && f.p[2] >= '1' && f.p[2] <= '9') ? (uint8_t)(f.p[2] - '0') : 1;
+  if (!logNextField(line, f) || !logParseHex(f, fr.id)) return false;
+  if (!logNextField(line, f) || !logParseDec(f, v)) return false;
+  fr.len = (uint8_t)v;
+  return logParseBytes(line, fr);
+}
+
+// <ms>,<apps1_raw>,... after "S,"
+inline bool logParseSensor(LogSpan line, LogSensor &s) {
+  LogSpan f;
+  int32_t *fields[] = { &s.apps1Raw, &s.apps2Raw, &s.pedalFault, &s.torqueCmd, &s.rpm, &s.dcBusDeciVolts };
+  if (!logNextField(line, f) || !logParseDec(f, s.ms)) return false;
+  for (int32_t *out : fields) {
+    if (!logNextField(line, f) || !logParseInt(f, *out)) return false;
+  }
+  return true;
+}
+
+// ---------- File reader ----------
+class LogReader {
+public:
+  LogReader() = default;
+  LogReader(const LogReader &) = delete;
+  LogReader &operator=(const LogReader &) = delete;
+  ~LogReader() {
+    if (_data) munmap((void *)_data, _size);
+  }
+
+  bool open(const char *path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    _size = (size_t)st.st_size;
+    if (_size > 0) {
+      void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) { ::close(fd); _size = 0; return false; }
+      madvise(p, _size, MADV_SEQUENTIAL);
+      _data = (const char *)p;
+    }
+    ::close(fd);
+    _p = _data;
+    return true;
+  }
+
+  size_t size() const { return _size; }
+  uint64_t lines() const { return _lines; }
+
+  // Next non-empty line; false at end of file.
+  bool next(LogLine &out) {
+    const char *end = _data + _size;
+    while (_p < end) {
+      const char *nl = (const char *)memchr(_p, '\n', end - _p);
+      LogSpan line = { _p, nl ? nl : end };
+      _p = nl ? nl + 1 : end;
+      if (line.end > line.p && line.end[-1] == '\r') line.end--;
+      if (line.empty()) continue;
+      _lines++;
+
+      if (!_decided) {
+        if (*line.p == '#') { out.kind = LOG_OTHER; return true; }
+        _decided = true;
+        _teensy = !startsWith(line, "Time(ms),");
+        if (!_teensy) { out.kind = LOG_OTHER; return true; }  // header row
+      }
+      classify(line, out);
+      return true;
+    }
+    return false;
+  }
+
+private:
+  const char *_data = nullptr;
+  size_t      _size = 0;
+  const char *_p = nullptr;
+  uint64_t    _lines = 0;
+  bool        _decided = false;
+  bool        _teensy = false;
+
+  static bool startsWith(const LogSpan &line, const char *s) {
+    size_t n = strlen(s);
+    return (size_t)(line.end - line.p) >= n && memcmp(line.p, s, n) == 0;
+  }
+
+  void classify(LogSpan line, LogLine &out) {
+    if (!_teensy) {
+      out.kind = logParseFrame(line, out.frame) ? LOG_FRAME : LOG_BAD;
+      return;
+    }
+    LogSpan tag = { line.p, line.p };
+    logNextField(line, tag);
+    size_t n = tag.end - tag.p;
+    if (n == 1 && *tag.p == 'C') {
+      out.kind = logParseFrame(line, out.frame) ? LOG_FRAME : LOG_BAD;
+    } else if (n == 1 && *tag.p == 'S') {
+      out.kind = logParseSensor(line, out.sensor) ? LOG_SENSOR : LOG_BAD;
+    } else if (*tag.p == '#' || *tag.p == 'X' || *tag.p == 'K' || *tag.p == 'L' || *tag.p == 'B' ||
+               (n == 2 && (*tag.p == 'C' || *tag.p == 'F' || *tag.p == 'A'))) {
+      out.kind = LOG_OTHER;
+    } else {
+      out.kind = LOG_BAD;
+    }
+  }
+};
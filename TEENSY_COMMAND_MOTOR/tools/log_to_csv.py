@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Convert a binary Teensy SD log (LOG_FORMAT_BINARY) to the CSV schema.
+
+The firmware writes fixed-size LogRecord structs (see include/logging.h).
+This tool reproduces exactly the text the CSV build would have written:
+
+  C,<ms>,<dir>,<id_hex>,<len>,<b0_hex>,...,<b7_hex>
+  S,<ms>,<apps1_raw>,<apps2_raw>,<pedal_fault>,<torque_cmd>,<rpm>,<dcbus_dV>
+  XR,<ms>,<accel_x>,<accel_y>,<accel_z>,<gyro_x>,<gyro_y>,<gyro_z>   (raw counts)
+  K,<ms>,<task>,<runs>,<overruns>,<max_jitter_us>,<max_run_us>
+  KH,<ms>,<task>,<h0>,...,<h5>
+  LT,<ms>,<path>,<count>,<min_us>,<avg_us>,<p99_us>,<max_us>
+  CB,<ms>,<bus>,<load_pct>,<peak_pct>,<rx>,<tx>,<tx_busy>,<tx_dropped>,<tec>,<rec>,<state>,<bus_off>
+  CI,<ms>,<dir>,<id_hex>,<frames>,<min_gap_us>,<max_gap_us>
+  FT,<ms>,<cause>,<detail_hex>,<capture>
+  # end: <bytes> bytes, <dropped> dropped, closed|recovered
+
+so existing spreadsheets and scripts keep working. Version 1 files (scaled
+XL IMU records in m/s^2 and rad/s) are still accepted. Logs recorded from
+the CAN FD telemetry channel (tools/canfd_logger.py) also carry
+
+  B,<ms>,<flags>,<error_hex>,<rpm>,<current>,<torque_act>,<power>,<motor_temp_dC>,<igbt_temp_dC>
+
+and fault captures (CAN_log_NNNN_Fxx.bin, see include/fault_capture.h) one
+line per raw APPS sample pair
+
+  AP,<ms>,<apps1_raw>,<apps2_raw>
+
+With --us the time column is in microseconds instead, which is what the
+full-rate capture files need.
+
+Usage:
+  python3 tools/log_to_csv.py CAN_log_0001.bin            # writes CAN_log_0001.csv
+  python3 tools/log_to_csv.py CAN_log_0001.bin -o - | less
+  python3 tools/log_to_csv.py CAN_log_0001_F01.bin --us
+"""
+
+from __future__ import annotations
+
+import argparse
+import struct
+import sys
+from typing import BinaryIO, Iterator, TextIO, Tuple
+
+RECORD = struct.Struct("<IBBH12s")  # t_us, type, len, id, data
+MAGIC = b"CANLOG"
+VERSIONS = (1, 2)
+
+REC_HEADER = ord("H")
+REC_TX = ord("T")
+REC_RX = ord("R")
+REC_SENSOR = ord("S")
+REC_IMU = ord("X")
+REC_TASK = ord("K")
+REC_JITTER = ord("k")
+REC_LATENCY = ord("L")
+REC_BAMOCAR = ord("B")
+REC_CANLOAD = ord("U")
+REC_CANID = ord("I")
+REC_FAULT = ord("F")
+REC_APPS = ord("P")
+REC_END = ord("E")
+
+CSV_HEADER = (
+    "# C,ms,dir,id,len,b0,b1,b2,b3,b4,b5,b6,b7\n"
+    "# S,ms,apps1_raw,apps2_raw,pedal_fault,torque_cmd,rpm,dcbus_dV\n"
+    "# {imu},ms,ax,ay,az,gx,gy,gz\n"
+    "# K,ms,task,runs,overruns,max_jitter_us,max_run_us\n"
+    "# KH,ms,task,h0,h1,h2,h3,h4,h5\n"
+    "# LT,ms,path,count,min_us,avg_us,p99_us,max_us\n"
+    "# CB,ms,bus,load_pct,peak_pct,rx,tx,tx_busy,tx_dropped,tec,rec,state,bus_off\n"
+    "# CI,ms,dir,id,frames,min_gap_us,max_gap_us\n"
+    "# FT,ms,cause,detail,capture\n"
+    "# AP,ms,apps1_raw,apps2_raw\n"
+)
+XR_SCALE = "# XR scale: accel_lsb_per_g={accel} gyro_lsb_per_dps_x10={gyro}\n"
+
+
+def read_records(stream: BinaryIO) -> Iterator[Tuple[int, int, int, int, bytes]]:
+    """Yield (t_us, type, len, id, data), unwrapping the 32-bit micros() counter."""
+
+    wraps = 0
+    last = None
+    while True:
+        chunk = stream.read(RECORD.size)
+        if len(chunk) < RECORD.size:
+            return
+        t_us, rtype, rlen, rid, data = RECORD.unpack(chunk)
+        if last is not None and t_us < last and last - t_us > 0x80000000:
+            wraps += 1
+        last = t_us
+        yield t_us + (wraps << 32), rtype, rlen, rid, data
+
+
+def convert(stream: BinaryIO, out: TextIO, us: bool = False) -> int:
+    """Write CSV for every record in stream. Returns the number of records.
+
+    us: time column in microseconds instead of milliseconds.
+    """
+
+    records = read_records(stream)
+    first = next(records, None)
+    if first is None or first[1] != REC_HEADER or not first[4].startswith(MAGIC):
+        raise ValueError("not a binary CAN log (missing header record)")
+    version = first[2]
+    if version not in VERSIONS or first[3] != RECORD.size:
+        raise ValueError(f"unsupported log version {version} / record size {first[3]}")
+    if version == 1:
+        imu_scale = struct.unpack_from("<h", first[4], 8)[0] or 100
+        out.write(CSV_HEADER.format(imu="XL"))
+    else:
+        accel, gyro = struct.unpack_from("<2h", first[4], 8)
+        out.write(CSV_HEADER.format(imu="XR"))
+        out.write(XR_SCALE.format(accel=accel, gyro=gyro))
+    count = 0
+    for t_us, rtype, rlen, rid, data in records:
+        ms = t_us if us else t_us // 1000
+        if rtype in (REC_TX, REC_RX):
+            dlc = min(rlen, 8)
+            fields = [f"{data[i]:02X}" if i < dlc else "" for i in range(8)]
+            direction = "TX" if rtype == REC_TX else "RX"
+            if data[8] > 1:
+                direction += str(data[8])  # CAN2/CAN3; 0 in files from before multi-bus
+            out.write(f"C,{ms},{direction},{rid:03X},{rlen}," + ",".join(fields) + "\n")
+        elif rtype == REC_SENSOR:
+            apps1, apps2, torque, rpm, dcbus, _ = struct.unpack("<6h", data)
+            out.write(f"S,{ms},{apps1},{apps2},{rlen},{torque},{rpm},{dcbus}\n")
+        elif rtype == REC_IMU:
+            values = struct.unpack("<6h", data)
+            if version == 1:
+                out.write(f"XL,{ms}," + ",".join(f"{v / imu_scale:.2f}" for v in values) + "\n")
+            else:
+                out.write(f"XR,{ms}," + ",".join(str(v) for v in values) + "\n")
+        elif rtype == REC_TASK:
+            runs, jitter, run = struct.unpack("<3I", data)
+            out.write(f"K,{ms},{rlen},{runs},{rid},{jitter},{run}\n")
+        elif rtype == REC_JITTER:
+            hist = struct.unpack("<6H", data)
+            out.write(f"KH,{ms},{rlen}," + ",".join(str(h) for h in hist) + "\n")
+        elif rtype == REC_LATENCY:
+            tenths = [int.from_bytes(data[i:i + 3], "little") for i in range(0, 12, 3)]
+            out.write(f"LT,{ms},{rlen},{rid}," + ",".join(f"{t // 10}.{t % 10}" for t in tenths) + "\n")
+        elif rtype == REC_BAMOCAR:
+            values = struct.unpack("<6h", data)
+            out.write(f"B,{ms},{rlen},{rid:04X}," + ",".join(str(v) for v in values) + "\n")
+        elif rtype == REC_CANLOAD:
+            peak, rx, tx, busy = struct.unpack_from("<4H", data)
+            tec, rec, bus_off, dropped = data[8:12]
+            out.write(f"CB,{ms},{rlen & 0xF},{rid // 10}.{rid % 10},{peak // 10}.{peak % 10},"
+                      f"{rx},{tx},{busy},{dropped},{tec},{rec},{rlen >> 4 & 0x3},{bus_off}\n")
+        elif rtype == REC_CANID:
+            can_id, min_gap, max_gap = struct.unpack("<3I", data)
+            bus = rlen & 0xF
+            direction = ("TX" if rlen & 0x80 else "RX") + (str(bus) if bus > 1 else "")
+            out.write(f"CI,{ms},{direction},{can_id:03X},{rid},{min_gap},{max_gap}\n")
+        elif rtype == REC_FAULT:
+            detail = struct.unpack_from("<I", data)[0]
+            out.write(f"FT,{ms},{rlen},{detail:X},{rid}\n")
+        elif rtype == REC_APPS:
+            samples = struct.unpack("<6h", data)
+            for k in range(min(rlen, 3)):
+                t = t_us + k * rid
+                out.write(f"AP,{t if us else t // 1000},{samples[2 * k]},{samples[2 * k + 1]}\n")
+        elif rtype == REC_END:
+            size, dropped, _ = struct.unpack("<3I", data)
+            how = "recovered" if rlen else "closed"
+            out.write(f"# end: {size} bytes, {dropped} dropped, {how}\n")
+            count += 1
+            break
+        else:
+            # Unknown record type: the unused tail of an old log without a trailer.
+            break
+        count += 1
+    return count
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Convert a binary Teensy SD log to CSV.")
+    parser.add_argument("input", help="Binary log file, e.g. CAN_log_0001.bin")
+    parser.add_argument("-o", "--output", help="Output CSV path, or '-' for stdout (default: input with .csv)")
+    parser.add_argument("--us", action="store_true", help="Time column in microseconds (fault captures)")
+    args = parser.parse_args()
+
+    output = args.output
+    if output is None:
+        output = args.input.rsplit(".", 1)[0] + ".csv"
+
+    with open(args.input, "rb") as stream:
+        try:
+            if output == "-":
+                count = convert(stream, sys.stdout, args.us)
+            else:
+                with open(output, "w", newline="\n") as out:
+                    count = convert(stream, out, args.us)
+        except ValueError as exc:
+            raise SystemExit(f"{args.input}: {exc}") from exc
+
+    if output != "-":
+        print(f"{args.input}: {count} records -> {output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -2,16 +2,35 @@
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <WebSocketsServer.h>
+#include <WiFiUdp.h>
+#include "telemetry_link.h"
+#include "telemetry_page.h"
 
 const char* ssid = "FS_Dashboard";
 const char* password = "12345678";
 
 ESP8266WebServer server(80);
 WebSocketsServer webSocket(81);
+WiFiUDP udp;
 
-String motorStatus = "Unknown";
-int rpm = 0;
-int torque = 0;
+// Car link: COBS frames from the Teensy on the RX pin, see telemetry_link.h.
+// Must match TELEMETRY_BAUD in TEENSY_COMMAND_MOTOR/include/config.h.
+#define LINK_BAUD      460800
+#define LINK_RX_BUFFER 1024   // UART RX buffer, ~20 ms of link traffic
+#define LINK_MAX_BYTES 512    // bytes parsed per loop() so the web server keeps up
+
+// Decoded state goes out as one binary WebSocket message per UI tick (see
+// TlTickHeader in telemetry_link.h), and only while a browser is connected.
+#define UI_TICK_MS     50     // 20 Hz
+#define UI_MAX_FRAMES  16     // CAN frames carried per tick, the rest are counted
+
+// The same tick also goes out as a multicast UDP snapshot every tick, for
+// any number of listeners (see TlUdpHeader). 0 turns it off.
+#define UDP_STREAM     1
+
+TlDecoder link;
+TlTick<UI_MAX_FRAMES> tick;
+uint32_t lastTickMs = 0;
 
 // Conversion: 1 rpm = 0.01777 km/h
 float rpmToKmh(float rpmValue) {
@@ -30,7 +49,8 @@ const char webpage[] PROGMEM = R"rawliteral(
     h1 { color:#2e5786; text-align:center; }
     .flex { display:flex; justify-content:center; gap:20px; margin-bottom:20px; }
     .box { border:1px solid #2e5786; border-radius:8px; padding:15px; width:150px; text-align:center; }
-    #log { background:#111; color:#ccc; border:1px solid #333; padding:10px; height:300px; overflow-y:scroll; font-family:monospace; font-size:13px; }
+    #log { background:#111; color:#ccc; border:1px solid #333; padding:10px; height:300px; overflow:hidden; font-family:monospace; font-size:13px; margin:0; }
+    #loginfo { color:#888; font-size:12px; }
     #speed { font-size:64px; color:#00ff88; text-align:center; margin-top:30px; }
   </style>
 </head>
@@ -42,31 +62,57 @@ const char webpage[] PROGMEM = R"rawliteral(
     <div class="box"><b>Torque:</b><br><span id="torque">0</span></div>
   </div>
 
-  <div><b>Live CAN Frames:</b></div>
-  <div id="log"></div>
+  <div><b>Live CAN Frames:</b> <span id="loginfo"></span></div>
+  <pre id="log"></pre>
 
   <div id="speed">0.0 km/h</div>
 
+<script src="/telemetry.js"></script>
 <script>
   function updateSpeed(rpm) {
     const kmh = rpm * 0.01777;
     document.getElementById('speed').textContent = kmh.toFixed(1) + " km/h";
   }
 
+  // Scrolls back through the ring; back at the bottom it follows again.
+  let logBack = 0, skipped = 0, coalesced = 0, link = [0, 0, 0];
+
+  function render() {
+    document.getElementById('log').textContent = logRows(logBack).join("\n");
+    document.getElementById('loginfo').textContent =
+      (logBack ? "paused, " + logBack + " back" : "live") + " | " + logCount + " kept, " +
+      coalesced + " coalesced, " + skipped + " skipped | link " + link[0] + " frames, " +
+      link[1] + " lost, " + link[2] + " bad";
+  }
+
+  document.getElementById('log').addEventListener('wheel', function(e) {
+    e.preventDefault();
+    const maxBack = Math.max(0, logCount - LOG_ROWS);
+    logBack = Math.max(0, Math.min(maxBack, logBack + (e.deltaY < 0 ? 3 : -3)));
+    scheduleRender();
+  });
+
+  function applyStatus(v, off) {
+    const rpm = v.getInt16(off + 4, true);
+    const torque = v.getInt16(off + 6, true) / 10;
+    document.getElementById('status').textContent =
+      statusText(v.getUint16(off + 14, true), v.getInt8(off + 20), v.getUint8(off + 21));
+    document.getElementById('rpm').textContent = rpm;
+    document.getElementById('torque').textContent = torque.toFixed(1) + " %";
+    updateSpeed(rpm);
+  }
+
   var ws = new WebSocket('ws://' + location.hostname + ':81/');
+  ws.binaryType = 'arraybuffer';
   ws.onmessage = function(event){
-    var data = JSON.parse(event.data);
-
-    if(data.type === "values") {
-      document.getElementById('status').textContent = data.status;
-      document.getElementById('rpm').textContent = data.rpm;
-      document.getElementById('torque').textContent = data.torque;
-      updateSpeed(data.rpm);
-    } else if(data.type === "can") {
-      var log = document.getElementById('log');
-      log.innerHTML += data.frame + "<br>";
-      log.scrollTop = log.scrollHeight;
-    }
+    if (!(event.data instanceof ArrayBuffer)) return;
+    const t = readTick(new DataView(event.data), applyStatus);
+    if (!t) return;
+    skipped += t.skipped;
+    coalesced += t.coalesced;
+    link = t.link;
+    if (logBack > 0) logBack = Math.min(logBack + t.frames, Math.max(0, logCount - LOG_ROWS));  // keep a paused view still
+    scheduleRender();
   }
 </script>
 </body>
@@ -77,18 +123,56 @@ void handleRoot() {
   server.send_P(200, "text/html", webpage);
 }
 
-void sendValues() {
-  String msg = "{\"type\":\"values\",\"status\":\"" + motorStatus + "\",\"rpm\":" + rpm + ",\"torque\":" + torque + "}";
-  webSocket.broadcastTXT(msg);
+void handleScript() {
+  server.send_P(200, "application/javascript", TL_PAGE_SCRIPT);
+}
+
+// Parses what the UART has buffered; never waits for more.
+void linkPoll() {
+  int n = Serial.available();
+  if (n > LINK_MAX_BYTES) n = LINK_MAX_BYTES;
+  while (n-- > 0) {
+    if (!link.push((uint8_t)Serial.read())) continue;
+    TlStatus st;
+    TlCanFrame f;
+    if (link.type() == TL_STATUS && link.read(st)) tick.status(st);
+    else if (link.type() == TL_CAN && link.read(f)) tick.frame(f);
+  }
 }
 
-void sendCANFrame(const String& frameLine) {
-  String msg = "{\"type\":\"can\",\"frame\":\"" + frameLine + "\"}";
-  webSocket.broadcastTXT(msg);
+TlLinkCounts linkCounts() {
+  return { link.frames(), link.lost(), link.crcErrors() };
+}
+
+// One binary message with the newest status and the coalesced frames since
+// the last tick, packed in a static buffer.
+void sendTick() {
+  static uint8_t msg[TlTick<UI_MAX_FRAMES>::TICK_BYTES];
+  webSocket.broadcastBIN(msg, tick.pack(msg, linkCounts()));
+}
+
+// One snapshot datagram, see TlTick::packUdp().
+void sendUdp(uint32_t now) {
+  static uint8_t msg[TlTick<UI_MAX_FRAMES>::UDP_BYTES];
+  size_t n = tick.packUdp(msg, linkCounts(), now);
+  udp.beginPacketMulticast(IPAddress(TL_UDP_GROUP), TL_UDP_PORT, WiFi.softAPIP());
+  udp.write(msg, n);
+  udp.endPacket();
+}
+
+// Resync requests from receivers that saw a gap.
+void udpPoll() {
+  while (udp.parsePacket() > 0) {
+    uint8_t req[2];
+    int n = udp.read(req, sizeof(req));
+    if (n > 0) tick.request(req, n);
+    udp.flush();
+  }
 }
 
 void setup() {
-  Serial.begin(115200);
+  Serial.setRxBufferSize(LINK_RX_BUFFER);
+  Serial.begin(LINK_BAUD);
   WiFi.mode(WIFI_AP);
   WiFi.softAP(ssid, password);
 
@@ -97,26 +181,30 @@ void setup() {
   Serial.print("IP: "); Serial.println(WiFi.softAPIP());
 
   server.on("/", handleRoot);
+  server.on(TL_PAGE_SCRIPT_PATH, handleScript);
   server.begin();
   webSocket.begin();
+#if UDP_STREAM
+  udp.begin(TL_UDP_PORT);
+#endif
 }
 
 void loop() {
   server.handleClient();
   webSocket.loop();
 
-  if (Serial.available()) {
-    String line = Serial.readStringUntil('\n');
-    line.trim();
-
-    if (line.startsWith("RPM:")) rpm = line.substring(4).toInt();
-    else if (line.startsWith("TORQUE:")) torque = line.substring(7).toInt();
-    else if (line.startsWith("STATUS:")) {
-      motorStatus = line.substring(7);
-    }
-
-    else if (line.startsWith("CAN:")) sendCANFrame(line);
-
-    sendValues();
+  linkPoll();
+#if UDP_STREAM
+  udpPoll();
+#endif
+
+  uint32_t now = millis();
+  if (now - lastTickMs >= UI_TICK_MS) {
+    lastTickMs = now;
+    if (tick.pending() && webSocket.connectedClients() > 0) sendTick();
+#if UDP_STREAM
+    sendUdp(now);
+#endif
+    tick.reset();
   }
 }